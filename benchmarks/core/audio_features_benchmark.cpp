@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <AudioFile.h>
+
+#include <memory>
+
+#include "core/audio_features/audio_features.h"
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/signal_generator/signal_generator.h"
+
+static std::unique_ptr<hpaslt::AudioSpectrogram> featureSpectrogram;
+
+/**
+ * @brief Generate the spectrogram of a stereo tone.
+ *
+ * @param state range(0) is the length in seconds.
+ */
+static void audioFeaturesSetup(const benchmark::State& state) {
+  std::shared_ptr<AudioFile<float>> audioFile =
+      std::make_shared<AudioFile<float>>();
+  audioFile->setNumChannels(2);
+  hpaslt::SignalGenerator signalGenerator;
+  signalGenerator.bindAudioFile(audioFile);
+  signalGenerator.changeLength(audioFile->getSampleRate() * state.range(0));
+  signalGenerator.generateSignal(440, 0.5f);
+
+  hpaslt::STFTConfig config;
+  config.nfft = 2048;
+  config.hopSize = 512;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.mode = hpaslt::SpectrogramMode::RealToComplex;
+  featureSpectrogram = std::make_unique<hpaslt::AudioSpectrogram>();
+  featureSpectrogram->generateSTFT(audioFile, config);
+}
+
+static void audioFeaturesTeardown(const benchmark::State& state) {
+  featureSpectrogram.reset();
+}
+
+/**
+ * @brief Extract the log mel spectrogram and MFCC of every frame.
+ *
+ * @param state range(1) is the number of mel bands.
+ */
+static void generateFeaturesBenchmark(benchmark::State& state) {
+  hpaslt::FeatureConfig config;
+  config.filterbank.bandNum = state.range(1);
+  int frameNum = featureSpectrogram->getSpectrogramLength();
+
+  for (auto _ : state) {
+    hpaslt::AudioFeatures features(*featureSpectrogram, config);
+    benchmark::DoNotOptimize(features.getMFCC(0).data());
+  }
+
+  state.counters["frames/s"] = benchmark::Counter(
+      frameNum * 2, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(generateFeaturesBenchmark)
+    ->ArgsProduct({{60, 600}, {40, 128}})
+    ->Setup(audioFeaturesSetup)
+    ->Teardown(audioFeaturesTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,177 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "common/workspace_context.h"
+#include "core/audio_player/audio_player.h"
+#include "core/audio_source/memory_audio_source.h"
+#include "core/signal_generator/signal_generator.h"
+
+/**
+ * @brief Number of callbacks timed per benchmark, the audio is long enough to
+ * never run out.
+ *
+ */
+#define PLAYER_BENCHMARK_ITERATIONS 4096
+
+static std::shared_ptr<AudioFile<float>> playerAudioFile = nullptr;
+
+static std::shared_ptr<hpaslt::AudioObject> playerAudioObject = nullptr;
+
+static std::shared_ptr<hpaslt::AudioPlayer> audioPlayer = nullptr;
+
+static std::vector<float> interleavedSamples;
+
+static std::vector<float> outputBuffer;
+
+/**
+ * @brief Generate a stereo signal of the length in playerAudioFile.
+ *
+ * @param sampleNum
+ */
+static void prepareStereoAudio(int sampleNum) {
+  playerAudioFile = std::make_shared<AudioFile<float>>();
+  playerAudioFile->setNumChannels(2);
+
+  hpaslt::SignalGenerator signalGenerator;
+  signalGenerator.bindAudioFile(playerAudioFile);
+  signalGenerator.changeLength(sampleNum);
+  signalGenerator.generateSignal(440, 1);
+}
+
+/* ------------------------ Copy out ------------------------ */
+
+static void copyOutSetup(const benchmark::State& state) {
+  prepareStereoAudio(PLAYER_BENCHMARK_ITERATIONS * state.range(0));
+  interleavedSamples.resize(playerAudioFile->getNumSamplesPerChannel() * 2);
+  hpaslt::MemoryAudioSource(playerAudioFile)
+      .readInterleaved(0, playerAudioFile->getNumSamplesPerChannel(),
+                       interleavedSamples.data());
+  outputBuffer.resize(state.range(0) * 2);
+}
+
+static void copyOutTeardown(const benchmark::State& state) {
+  playerAudioFile = nullptr;
+  interleavedSamples.clear();
+  outputBuffer.clear();
+}
+
+/**
+ * @brief The copy the callback did before the ring buffer: one sample per
+ * channel per frame from the planar AudioFile.
+ *
+ * @param state
+ */
+static void planarGatherBenchmark(benchmark::State& state) {
+  int framesPerBuffer = state.range(0);
+  int cursor = 0;
+  for (auto _ : state) {
+    float* out = outputBuffer.data();
+    for (int i = 0; i < framesPerBuffer; i++) {
+      for (int channel = 0; channel < 2; channel++) {
+        *out++ = playerAudioFile->samples[channel][cursor + i];
+      }
+    }
+    benchmark::DoNotOptimize(outputBuffer.data());
+    cursor += framesPerBuffer;
+  }
+}
+
+BENCHMARK(planarGatherBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(64, 1024)
+    ->Iterations(PLAYER_BENCHMARK_ITERATIONS)
+    ->Setup(copyOutSetup)
+    ->Teardown(copyOutTeardown)
+    ->Unit(benchmark::kNanosecond);
+
+static void interleavedCopyBenchmark(benchmark::State& state) {
+  int framesPerBuffer = state.range(0);
+  int cursor = 0;
+  for (auto _ : state) {
+    std::memcpy(outputBuffer.data(), interleavedSamples.data() + cursor * 2,
+                framesPerBuffer * 2 * sizeof(float));
+    benchmark::DoNotOptimize(outputBuffer.data());
+    cursor += framesPerBuffer;
+  }
+}
+
+BENCHMARK(interleavedCopyBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(64, 1024)
+    ->Iterations(PLAYER_BENCHMARK_ITERATIONS)
+    ->Setup(copyOutSetup)
+    ->Teardown(copyOutTeardown)
+    ->Unit(benchmark::kNanosecond);
+
+/* ------------------------ paCallback ---------------------- */
+
+static void paCallbackSetup(const benchmark::State& state) {
+  namespace fs = std::filesystem;
+
+  // AudioPlayer logs and reads the project settings, keep both out of the
+  // way in a temporary directory.
+  if (!hpaslt::logger) {
+    fs::path workingDirectory = fs::temp_directory_path() / "hpaslt_benchmark";
+    hpaslt::workspaceContext::hpasltWorkingDirectory =
+        workingDirectory.string();
+    hpaslt::initLogger(workingDirectory.string());
+    hpaslt::logger->setLogLevel(spdlog::level::off);
+  }
+
+  int sampleNum = PLAYER_BENCHMARK_ITERATIONS * state.range(0);
+  prepareStereoAudio(sampleNum);
+  fs::path audioPath =
+      fs::path(hpaslt::workspaceContext::hpasltWorkingDirectory) /
+      "player_benchmark.wav";
+  playerAudioFile->save(audioPath.string());
+
+  playerAudioObject = std::make_shared<hpaslt::AudioObject>();
+  playerAudioObject->loadAudioFile(audioPath.string());
+
+  // The whole audio fits the ring, the timed loop never underruns.
+  auto config = hpaslt::ProjectSettingsConfig::getSingleton();
+  config->audioStreamFPB = state.range(0);
+  config->audioRingBufferFrames = sampleNum;
+
+  // No stream is opened without an initialized device, the producer still
+  // runs.
+  audioPlayer = std::make_shared<hpaslt::AudioPlayer>();
+  audioPlayer->loadAudioObject(playerAudioObject);
+  // range(1): 1 to copy every buffer into the spectrum analyzer ring.
+  audioPlayer->setSpectrumAnalyzerEnabled(state.range(1));
+  while (audioPlayer->getBufferedFrames() < sampleNum) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  outputBuffer.resize(state.range(0) * 2);
+}
+
+static void paCallbackTeardown(const benchmark::State& state) {
+  audioPlayer = nullptr;
+  playerAudioObject = nullptr;
+  playerAudioFile = nullptr;
+  outputBuffer.clear();
+}
+
+static void paCallbackBenchmark(benchmark::State& state) {
+  for (auto _ : state) {
+    hpaslt::AudioPlayer::paCallback(nullptr, outputBuffer.data(),
+                                    state.range(0), nullptr, 0,
+                                    audioPlayer.get());
+    benchmark::DoNotOptimize(outputBuffer.data());
+  }
+
+  state.counters["frames/s"] = benchmark::Counter(
+      state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(paCallbackBenchmark)
+    ->ArgsProduct({benchmark::CreateRange(64, 1024, 2), {0, 1}})
+    ->Iterations(PLAYER_BENCHMARK_ITERATIONS)
+    ->Setup(paCallbackSetup)
+    ->Teardown(paCallbackTeardown)
+    ->Unit(benchmark::kNanosecond);
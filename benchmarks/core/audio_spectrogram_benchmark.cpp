@@ -0,0 +1,261 @@
+#include <benchmark/benchmark.h>
+
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/signal_generator/signal_generator.h"
+
+static std::shared_ptr<AudioFile<float>> spectrogramAudioFile = nullptr;
+
+static std::shared_ptr<hpaslt::AudioSpectrogram> audioSpectrogram = nullptr;
+
+/**
+ * @brief Make sure spectrogramAudioFile holds a 3 tone signal of the length and
+ * channel number. The signal is kept between benchmarks with the same shape,
+ * generating an hour of audio is slower than transforming it.
+ *
+ * @param seconds the length of the audio.
+ * @param channelNum the number of channels.
+ */
+static void prepareAudio(int seconds, int channelNum) {
+  if (spectrogramAudioFile &&
+      spectrogramAudioFile->getNumChannels() == channelNum &&
+      spectrogramAudioFile->getNumSamplesPerChannel() ==
+          spectrogramAudioFile->getSampleRate() * seconds) {
+    return;
+  }
+
+  spectrogramAudioFile = std::make_shared<AudioFile<float>>();
+  spectrogramAudioFile->setNumChannels(channelNum);
+
+  hpaslt::SignalGenerator signalGenerator;
+  signalGenerator.bindAudioFile(spectrogramAudioFile);
+  signalGenerator.changeLength(spectrogramAudioFile->getSampleRate() * seconds);
+  signalGenerator.generateSignal(512, (float)1 / (float)3);
+  signalGenerator.overlaySignal(1024, (float)1 / (float)3);
+  signalGenerator.overlaySignal(2048, (float)1 / (float)3);
+}
+
+static void audioSpectrogramSetup(const benchmark::State& state) {
+  audioSpectrogram = std::make_shared<hpaslt::AudioSpectrogram>();
+}
+
+static void audioSpectrogramTeardown(const benchmark::State& state) {
+  audioSpectrogram = nullptr;
+}
+
+/**
+ * @brief Time generateSTFT and report the throughput counters.
+ *
+ * @param state
+ * @param config
+ */
+static void runSTFTBenchmark(benchmark::State& state,
+                             const hpaslt::STFTConfig& config) {
+  // Plan outside of the timed loop.
+  audioSpectrogram->generateSTFT(spectrogramAudioFile, config);
+
+  for (auto _ : state) {
+    audioSpectrogram->generateSTFT(spectrogramAudioFile, config);
+  }
+
+  int channelNum = spectrogramAudioFile->getNumChannels();
+  int64_t frames =
+      (int64_t)audioSpectrogram->getSpectrogramLength() * channelNum;
+  int64_t samples =
+      (int64_t)spectrogramAudioFile->getNumSamplesPerChannel() * channelNum;
+  // The spectrogram is the only allocation proportional to the audio.
+  int64_t bytes = audioSpectrogram->getSpectrogramBytes();
+
+  state.counters["frames/s"] =
+      benchmark::Counter(frames, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["samples/s"] = benchmark::Counter(
+      samples, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["bytes"] = benchmark::Counter(
+      bytes, benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+}
+
+/* ------------------------ nfft sweep ----------------------- */
+
+static void generateSTFTNfftBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  hpaslt::STFTConfig config;
+  config.nfft = state.range(0);
+  config.hopSize = config.nfft / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTNfftBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(128, 16384)
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ----------------------- Length sweep ---------------------- */
+
+static void generateSTFTLengthBenchmark(benchmark::State& state) {
+  prepareAudio(state.range(0), 2);
+
+  hpaslt::STFTConfig config;
+  config.nfft = 1024;
+  config.hopSize = 256;
+  config.window = hpaslt::WindowFunction::Hann;
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTLengthBenchmark)
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(60)
+    ->Arg(600)
+    ->Arg(3600)
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ---------------------- Channel sweep ---------------------- */
+
+static void generateSTFTChannelBenchmark(benchmark::State& state) {
+  prepareAudio(60, state.range(0));
+
+  hpaslt::STFTConfig config;
+  config.nfft = 1024;
+  config.hopSize = 256;
+  config.window = hpaslt::WindowFunction::Hann;
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTChannelBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ---------------------- Overlap sweep ---------------------- */
+
+static void generateSTFTOverlapBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  // range(0) is the hop size as a divisor of nfft: 1 is no overlap, 4 is 75%.
+  hpaslt::STFTConfig config;
+  config.nfft = 1024;
+  config.hopSize = config.nfft / state.range(0);
+  config.window = hpaslt::WindowFunction::Hann;
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTOverlapBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ----------------------- Thread sweep ---------------------- */
+
+static void generateSTFTThreadsBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  hpaslt::STFTConfig config;
+  config.nfft = 1024;
+  config.hopSize = 256;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.threadNum = state.range(0);
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTThreadsBenchmark)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* --------------------- Execution sweep --------------------- */
+
+static void generateSTFTExecutionBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  // range(1): 0 per frame, 1 batched, 2 batched and threaded.
+  hpaslt::STFTConfig config;
+  config.nfft = state.range(0);
+  config.hopSize = config.nfft / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.execution = state.range(1) == 0
+                         ? hpaslt::SpectrogramExecution::PerFrame
+                         : hpaslt::SpectrogramExecution::Batched;
+  config.threadNum = state.range(1) == 2 ? 0 : 1;
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTExecutionBenchmark)
+    ->ArgsProduct({benchmark::CreateRange(128, 8192, 2), {0, 1, 2}})
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ---------------------- Format sweep ----------------------- */
+
+static void generateSTFTFormatBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  // range(1): the SpectrogramFormat, the bytes counter shows the storage.
+  hpaslt::STFTConfig config;
+  config.nfft = state.range(0);
+  config.hopSize = config.nfft / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.format = (hpaslt::SpectrogramFormat)state.range(1);
+  runSTFTBenchmark(state, config);
+}
+
+BENCHMARK(generateSTFTFormatBenchmark)
+    ->ArgsProduct({{512, 2048, 8192}, {0, 1, 2, 3}})
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/* ------------------------ ISTFT sweep ---------------------- */
+
+static void generateISTFTBenchmark(benchmark::State& state) {
+  prepareAudio(60, 2);
+
+  // range(1): the number of threads, 0 for all.
+  hpaslt::STFTConfig config;
+  config.nfft = state.range(0);
+  config.hopSize = config.nfft / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.threadNum = state.range(1);
+  audioSpectrogram->generateSTFT(spectrogramAudioFile, config);
+  // Plan outside of the timed loop.
+  audioSpectrogram->generateISTFT();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(audioSpectrogram->generateISTFT());
+  }
+
+  int channelNum = spectrogramAudioFile->getNumChannels();
+  int64_t frames =
+      (int64_t)audioSpectrogram->getSpectrogramLength() * channelNum;
+  int64_t samples =
+      (int64_t)spectrogramAudioFile->getNumSamplesPerChannel() * channelNum;
+  state.counters["frames/s"] =
+      benchmark::Counter(frames, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["samples/s"] = benchmark::Counter(
+      samples, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(generateISTFTBenchmark)
+    ->ArgsProduct({benchmark::CreateRange(256, 4096, 4), {1, 0}})
+    ->Setup(audioSpectrogramSetup)
+    ->Teardown(audioSpectrogramTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
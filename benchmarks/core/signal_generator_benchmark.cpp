@@ -1,5 +1,7 @@
 #include <benchmark/benchmark.h>
 
+#include <vector>
+
 #include "core/signal_generator/signal_generator.h"
 
 std::shared_ptr<AudioFile<float>> audioFile = nullptr;
@@ -37,6 +39,10 @@ static void generateSignalBenchmark(benchmark::State& state) {
   for (auto _ : state) {
     signalGenerator->generateSignal(32, 1);
   }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      state.range(0) * audioFile->getNumChannels(),
+      benchmark::Counter::kIsIterationInvariantRate);
 }
 
 BENCHMARK(generateSignalBenchmark)
@@ -59,6 +65,10 @@ static void overlaySignalBenchmark(benchmark::State& state) {
     state.ResumeTiming();
     signalGenerator->overlaySignal(32, 1);
   }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      state.range(0) * audioFile->getNumChannels(),
+      benchmark::Counter::kIsIterationInvariantRate);
 }
 
 BENCHMARK(overlaySignalBenchmark)
@@ -67,3 +77,69 @@ BENCHMARK(overlaySignalBenchmark)
     ->Setup(signalGeneratorSetup)
     ->Teardown(signalGeneratorTeardown)
     ->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief The harmonics of 55 Hz.
+ *
+ * @param partialNum
+ * @return std::vector<hpaslt::SignalPartial>
+ */
+static std::vector<hpaslt::SignalPartial> harmonicPartials(int partialNum) {
+  std::vector<hpaslt::SignalPartial> partials;
+  for (int i = 1; i <= partialNum; i++) {
+    partials.push_back({55.f * i, 1.f / i, 0});
+  }
+  return partials;
+}
+
+/**
+ * @brief Build a signal with one generateSignal and one overlaySignal call per
+ * partial.
+ *
+ * @param state range(0) is the length, range(1) the number of partials.
+ */
+static void overlayPartialsLoopBenchmark(benchmark::State& state) {
+  signalGenerator->changeLength(state.range(0));
+  std::vector<hpaslt::SignalPartial> partials =
+      harmonicPartials(state.range(1));
+  for (auto _ : state) {
+    signalGenerator->generateSignal(partials[0].freq, partials[0].magnitude);
+    for (size_t i = 1; i < partials.size(); i++) {
+      signalGenerator->overlaySignal(partials[i].freq, partials[i].magnitude);
+    }
+  }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      state.range(0) * audioFile->getNumChannels(),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(overlayPartialsLoopBenchmark)
+    ->ArgsProduct({{44100 << 5, 44100 << 7}, {10, 50}})
+    ->Setup(signalGeneratorSetup)
+    ->Teardown(signalGeneratorTeardown)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Build the same signal in one pass.
+ *
+ * @param state range(0) is the length, range(1) the number of partials.
+ */
+static void generatePartialsBenchmark(benchmark::State& state) {
+  signalGenerator->changeLength(state.range(0));
+  std::vector<hpaslt::SignalPartial> partials =
+      harmonicPartials(state.range(1));
+  for (auto _ : state) {
+    signalGenerator->generatePartials(partials);
+  }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      state.range(0) * audioFile->getNumChannels(),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(generatePartialsBenchmark)
+    ->ArgsProduct({{44100 << 5, 44100 << 7}, {10, 50}})
+    ->Setup(signalGeneratorSetup)
+    ->Teardown(signalGeneratorTeardown)
+    ->Unit(benchmark::kMillisecond);
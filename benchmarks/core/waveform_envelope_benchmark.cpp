@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "core/waveform_envelope/waveform_envelope.h"
+
+#define ENVELOPE_BENCHMARK_SAMPLE_RATE 44100
+#define ENVELOPE_BENCHMARK_RESOLUTION 8192
+
+static std::vector<float> envelopeSamples;
+
+/**
+ * @brief Fill envelopeSamples with a tone of the length.
+ *
+ * @param state range(0) is the length in seconds.
+ */
+static void waveformEnvelopeSetup(const benchmark::State& state) {
+  envelopeSamples.resize((size_t)ENVELOPE_BENCHMARK_SAMPLE_RATE *
+                         state.range(0));
+  for (size_t i = 0; i < envelopeSamples.size(); i++) {
+    envelopeSamples[i] = std::sin(0.05f * (float)(i % 4096));
+  }
+}
+
+static void waveformEnvelopeTeardown(const benchmark::State& state) {
+  envelopeSamples.clear();
+  envelopeSamples.shrink_to_fit();
+}
+
+/**
+ * @brief Build the whole pyramid of one channel at once, like a file that is
+ * already decoded.
+ *
+ * @param state
+ */
+static void buildEnvelopeBenchmark(benchmark::State& state) {
+  int sampleNum = envelopeSamples.size();
+
+  for (auto _ : state) {
+    hpaslt::WaveformEnvelope envelope(sampleNum, ENVELOPE_BENCHMARK_RESOLUTION,
+                                      true);
+    envelope.extend(envelopeSamples.data(), sampleNum);
+    benchmark::DoNotOptimize(envelope.getLevel(0).max.data());
+  }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      sampleNum, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(buildEnvelopeBenchmark)
+    ->Arg(60)
+    ->Arg(600)
+    ->Arg(3600)
+    ->Setup(waveformEnvelopeSetup)
+    ->Teardown(waveformEnvelopeTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * @brief Extend the pyramid block by block, like a progressive load.
+ *
+ * @param state
+ */
+static void extendEnvelopeBenchmark(benchmark::State& state) {
+  int sampleNum = envelopeSamples.size();
+
+  for (auto _ : state) {
+    hpaslt::WaveformEnvelope envelope(sampleNum, ENVELOPE_BENCHMARK_RESOLUTION,
+                                      true);
+    for (int loaded = 0; loaded < sampleNum; loaded += 65536) {
+      envelope.extend(envelopeSamples.data(), loaded);
+    }
+    envelope.extend(envelopeSamples.data(), sampleNum);
+    benchmark::DoNotOptimize(envelope.getLevel(0).max.data());
+  }
+
+  state.counters["samples/s"] = benchmark::Counter(
+      sampleNum, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(extendEnvelopeBenchmark)
+    ->Arg(60)
+    ->Arg(600)
+    ->Setup(waveformEnvelopeSetup)
+    ->Teardown(waveformEnvelopeTeardown)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
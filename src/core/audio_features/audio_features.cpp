@@ -0,0 +1,166 @@
+#include "audio_features.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/fft_plan_cache/fft_plan_cache.h"
+#include "core/fft_wisdom/fft_wisdom.h"
+
+// Frames one worker extracts before taking a new chunk.
+#define FEATURE_CHUNK_FRAMES 64
+
+namespace hpaslt {
+
+int AudioFeatures::getThreadNum() {
+#ifdef _OPENMP
+  return m_config.threadNum > 0 ? m_config.threadNum : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void AudioFeatures::loadPower(AudioSpectrogram &spectrogram, int channel,
+                              int frame, float *dst) {
+  int binNum = spectrogram.getNfft() / 2 + 1;
+  // Complex spectrograms keep every bin, only the first half is read.
+  size_t offset = (size_t)frame * spectrogram.getBinNum();
+  switch (spectrogram.getFormat()) {
+  case SpectrogramFormat::Complex32: {
+    const fftwf_complex *bins =
+        spectrogram.getRawSpectrogram()[channel]->getRawSpectrogram() + offset;
+#pragma omp simd
+    for (int bin = 0; bin < binNum; bin++) {
+      dst[bin] = bins[bin][0] * bins[bin][0] + bins[bin][1] * bins[bin][1];
+    }
+    break;
+  }
+  case SpectrogramFormat::Magnitude32: {
+    const float *bins =
+        spectrogram.getCompactSpectrogram()[channel]->getMagnitudes() + offset;
+#pragma omp simd
+    for (int bin = 0; bin < binNum; bin++) {
+      dst[bin] = bins[bin] * bins[bin];
+    }
+    break;
+  }
+  case SpectrogramFormat::Magnitude16: {
+    const uint16_t *bins =
+        spectrogram.getCompactSpectrogram()[channel]->getHalfMagnitudes() +
+        offset;
+    for (int bin = 0; bin < binNum; bin++) {
+      float magnitude = halfToFloat(bins[bin]);
+      dst[bin] = magnitude * magnitude;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void AudioFeatures::preparePlans(const FeatureConfig &config) {
+  // The log energies of a chunk start at any float of their vector, the
+  // cepstrum buffer is fftw allocated.
+  int bandNum = config.filterbank.bandNum;
+  int alignmentNum = FFTPlanCache::getAlignmentNum();
+  float *in = fftwf_alloc_real(alignmentNum);
+  float *out = fftwf_alloc_real(1);
+
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+  for (int inOffset = 0; inOffset < alignmentNum; inOffset++) {
+    planCache->getDCTManyPlan(bandNum, FEATURE_CHUNK_FRAMES, in + inOffset,
+                              bandNum, out, bandNum,
+                              FFTWisdom::getPlannerFlags());
+  }
+
+  fftwf_free(in);
+  fftwf_free(out);
+}
+
+AudioFeatures::AudioFeatures(AudioSpectrogram &spectrogram,
+                             const FeatureConfig &config)
+    : m_config(config),
+      m_filterbank(spectrogram.getAudioSampleRate(), spectrogram.getNfft(),
+                   config.filterbank),
+      m_frameNum(spectrogram.getSpectrogramLength()) {
+  if (spectrogram.getFormat() == SpectrogramFormat::Decibel8) {
+    throw std::invalid_argument(
+        "Feature extraction needs complex or magnitude bins.");
+  }
+  int bandNum = m_filterbank.getBandNum();
+  if (config.mfccNum <= 0 || config.mfccNum > bandNum) {
+    throw std::invalid_argument("MFCC number out of range.");
+  }
+
+  int channelNum = std::max(spectrogram.getRawSpectrogram().size(),
+                            spectrogram.getCompactSpectrogram().size());
+  int mfccNum = config.mfccNum;
+  m_logMelSpectrograms.resize(channelNum);
+  m_mfccs.resize(channelNum);
+  for (int channel = 0; channel < channelNum; channel++) {
+    m_logMelSpectrograms[channel].resize((size_t)m_frameNum * bandNum);
+    m_mfccs[channel].resize((size_t)m_frameNum * mfccNum);
+  }
+
+  int chunkNum = (m_frameNum + FEATURE_CHUNK_FRAMES - 1) / FEATURE_CHUNK_FRAMES;
+  int taskNum = channelNum * chunkNum;
+
+  // Orthonormal scaling of the unnormalized FFTW_REDFT10 output.
+  float firstScale = std::sqrt(1.f / (4 * bandNum));
+  float scale = std::sqrt(1.f / (2 * bandNum));
+  float minEnergy = config.minEnergy;
+
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+
+#pragma omp parallel num_threads(getThreadNum())
+  {
+    // The power of one frame and the cepstrum of one chunk for each thread.
+    float *power = fftwf_alloc_real(m_filterbank.getBinNum());
+    float *cepstrum = fftwf_alloc_real((size_t)FEATURE_CHUNK_FRAMES * bandNum);
+
+#pragma omp for schedule(dynamic)
+    for (int task = 0; task < taskNum; task++) {
+      int channel = task / chunkNum;
+      int firstFrame = (task % chunkNum) * FEATURE_CHUNK_FRAMES;
+      int lastFrame = std::min(firstFrame + FEATURE_CHUNK_FRAMES, m_frameNum);
+      float *logMel =
+          m_logMelSpectrograms[channel].data() + (size_t)firstFrame * bandNum;
+
+      for (int frame = firstFrame; frame < lastFrame; frame++) {
+        float *bands = logMel + (size_t)(frame - firstFrame) * bandNum;
+        loadPower(spectrogram, channel, frame, power);
+        m_filterbank.apply(power, bands);
+#pragma omp simd
+        for (int band = 0; band < bandNum; band++) {
+          bands[band] = std::log(std::max(bands[band], minEnergy));
+        }
+      }
+
+      // One batched DCT-II over the log energies of the chunk.
+      fftwf_plan plan = planCache->getDCTManyPlan(
+          bandNum, lastFrame - firstFrame, logMel, bandNum, cepstrum, bandNum,
+          FFTWisdom::getPlannerFlags());
+      fftwf_execute_r2r(plan, logMel, cepstrum);
+
+      float *mfcc = m_mfccs[channel].data() + (size_t)firstFrame * mfccNum;
+      for (int frame = 0; frame < lastFrame - firstFrame; frame++) {
+        const float *coefficients = cepstrum + (size_t)frame * bandNum;
+        float *dst = mfcc + (size_t)frame * mfccNum;
+        dst[0] = coefficients[0] * firstScale;
+        for (int i = 1; i < mfccNum; i++) {
+          dst[i] = coefficients[i] * scale;
+        }
+      }
+    }
+
+    fftwf_free(power);
+    fftwf_free(cepstrum);
+  }
+}
+
+} // namespace hpaslt
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/mel_filterbank/mel_filterbank.h"
+
+namespace hpaslt {
+
+/**
+ * @class FeatureConfig
+ * @brief The filterbank and cepstrum of the extracted features.
+ *
+ */
+struct FeatureConfig {
+  FilterbankConfig filterbank;
+  // The number of cepstral coefficients kept, at most filterbank.bandNum.
+  int mfccNum = 13;
+  // Band energies are clamped to this before the log.
+  float minEnergy = 1e-10f;
+  // Number of worker threads, 0 to use all the OpenMP threads.
+  int threadNum = 0;
+};
+
+/**
+ * @brief The log mel spectrogram and the MFCC of every frame of a generated
+ * spectrogram.
+ * The band energies are the filterbank over the power of the unnormalized
+ * bins. The MFCC are the orthonormal DCT-II of the natural log energies, the
+ * same scaling as scipy's dct(norm="ortho").
+ *
+ */
+class AudioFeatures {
+private:
+  FeatureConfig m_config;
+  MelFilterbank m_filterbank;
+  int m_frameNum;
+
+  /**
+   * @brief frameNum * bandNum log energies of every channel, frame by frame.
+   *
+   */
+  std::vector<std::vector<float>> m_logMelSpectrograms;
+
+  /**
+   * @brief frameNum * mfccNum coefficients of every channel, frame by frame.
+   *
+   */
+  std::vector<std::vector<float>> m_mfccs;
+
+  int getThreadNum();
+
+  /**
+   * @brief Load the power of the first nfft / 2 + 1 bins of a frame.
+   *
+   * @param spectrogram
+   * @param channel
+   * @param frame
+   * @param dst
+   */
+  static void loadPower(AudioSpectrogram &spectrogram, int channel, int frame,
+                        float *dst);
+
+public:
+  /**
+   * @brief Extract the features of every channel of a generated spectrogram.
+   * The spectrogram must be SpectrogramFormat::Complex32, Magnitude32 or
+   * Magnitude16.
+   *
+   * @param spectrogram
+   * @param config
+   */
+  AudioFeatures(AudioSpectrogram &spectrogram, const FeatureConfig &config);
+
+  /**
+   * @brief Create the cached DCT plans of a full chunk of frames for the
+   * config, the last partial chunk is still planned on first use.
+   * This method is thread safe.
+   *
+   * @param config
+   */
+  static void preparePlans(const FeatureConfig &config);
+
+  const FeatureConfig &getConfig() const { return m_config; }
+
+  const MelFilterbank &getFilterbank() const { return m_filterbank; }
+
+  int getChannelNum() const { return m_mfccs.size(); }
+
+  int getFrameNum() const { return m_frameNum; }
+
+  int getBandNum() const { return m_filterbank.getBandNum(); }
+
+  int getMfccNum() const { return m_config.mfccNum; }
+
+  /**
+   * @brief Get the log energies of a channel.
+   *
+   * @param channel
+   * @return const std::vector<float>& frameNum * bandNum, frame by frame.
+   */
+  const std::vector<float> &getLogMelSpectrogram(int channel) const {
+    return m_logMelSpectrograms[channel];
+  }
+
+  /**
+   * @brief Get the cepstral coefficients of a channel.
+   *
+   * @param channel
+   * @return const std::vector<float>& frameNum * mfccNum, frame by frame.
+   */
+  const std::vector<float> &getMFCC(int channel) const {
+    return m_mfccs[channel];
+  }
+};
+
+} // namespace hpaslt
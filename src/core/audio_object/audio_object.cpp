@@ -1,21 +1,69 @@
 #include "audio_object.h"
 
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <filesystem>
+
+#include "core/audio_source/memory_audio_source.h"
+#include "core/audio_source/progressive_audio_source.h"
+#include "core/audio_source/streaming_audio_source.h"
+
+/**
+ * @brief WAV files decoding to at most this many bytes are loaded into memory,
+ * larger ones stay streamed from disk.
+ *
+ */
+#define AUDIO_OBJECT_MEMORY_LOAD_BYTES (1LL << 30)
+
 namespace hpaslt {
 
-void AudioObject::loadAudioFile(const std::string &filePath) {
-  std::shared_ptr<AudioFile<float>> targetFile =
-      std::make_shared<AudioFile<float>>();
-  if (!targetFile->load(filePath)) {
-    throw std::invalid_argument("Audio file at path cannot be loaded.");
+void AudioObject::loadAudioFile(const std::string &filePath, bool progressive) {
+  std::shared_ptr<AudioSource> targetSource = nullptr;
+
+  // Stream WAV files, fall back to AudioFile for everything it cannot parse.
+  std::string extension = std::filesystem::path(filePath).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (extension == ".wav") {
+    try {
+      targetSource = std::make_shared<StreamingAudioSource>(filePath);
+    } catch (const std::invalid_argument &) {
+      targetSource = nullptr;
+    }
+
+    // Decode files that fit into memory, block by block.
+    if (targetSource &&
+        (long long)targetSource->getNumSamplesPerChannel() *
+                targetSource->getNumChannels() * sizeof(float) <=
+            AUDIO_OBJECT_MEMORY_LOAD_BYTES) {
+      auto progressiveSource =
+          std::make_shared<ProgressiveAudioSource>(targetSource);
+      if (!progressive) {
+        progressiveSource->loadAll();
+      }
+      targetSource = progressiveSource;
+    }
+  }
+  if (!targetSource) {
+    std::shared_ptr<AudioFile<float>> targetFile =
+        std::make_shared<AudioFile<float>>();
+    if (!targetFile->load(filePath)) {
+      throw std::invalid_argument("Audio file at path cannot be loaded.");
+    }
+    // Playback copies interleaved frames out of the source.
+    auto memorySource = std::make_shared<MemoryAudioSource>(targetFile);
+    memorySource->prepareInterleaved();
+    targetSource = memorySource;
   }
-  if (targetFile->getNumChannels() > 2) {
+  if (targetSource->getNumChannels() > 2) {
     throw std::invalid_argument("Audio file channel number not supported.");
   }
 
   // Guard the audio file.
   m_mutex.lock();
-  // Set audio file.
-  m_audioFile = targetFile;
+  // Set audio source.
+  m_audioSource = targetSource;
   // Reset cursor.
   setCursor(0);
   m_mutex.unlock();
@@ -28,8 +76,8 @@ float AudioObject::getLength() {
   // Guard the audio file.
   m_mutex.lock();
 
-  int numSamples = m_audioFile->getNumSamplesPerChannel();
-  int sampleRate = m_audioFile->getSampleRate();
+  int numSamples = m_audioSource->getNumSamplesPerChannel();
+  int sampleRate = m_audioSource->getSampleRate();
 
   m_mutex.unlock();
 
@@ -41,7 +89,7 @@ float AudioObject::getTime() {
   m_mutex.lock();
 
   int cursorFrame = m_cursor;
-  int sampleRate = m_audioFile->getSampleRate();
+  int sampleRate = m_audioSource->getSampleRate();
 
   m_mutex.unlock();
 
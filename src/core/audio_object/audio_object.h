@@ -1,11 +1,14 @@
 #pragma once
 
-#include <AudioFile.h>
 #include <eventpp/callbacklist.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 
+#include "core/audio_source/audio_source.h"
+
 namespace hpaslt {
 
 class AudioObject {
@@ -18,35 +21,58 @@ class AudioObject {
   std::mutex m_mutex;
 
   /**
-   * @brief The current processing audio file.
+   * @brief The samples of the current processing audio.
    *
    */
-  std::shared_ptr<AudioFile<float>> m_audioFile;
+  std::shared_ptr<AudioSource> m_audioSource;
 
   /**
    * @brief Current playing frame.
+   * Atomic so the audio callback can advance it without taking m_mutex.
    *
    */
-  int m_cursor;
+  std::atomic<int> m_cursor;
 
   eventpp::CallbackList<void(float, float)> *m_onChangePlayingTime;
 
 public:
+  /**
+   * @brief Construct a new AudioObject object.
+   *
+   */
+  AudioObject() : m_cursor(0), m_onChangePlayingTime(nullptr) {}
+
   /**
    * @brief Get the current playing frame.
-   * This method is not thread safe.
+   * This method is thread safe and lock free.
    *
    * @return int
    */
-  int getCursor() { return m_cursor; }
+  int getCursor() { return m_cursor.load(std::memory_order_acquire); }
 
   /**
    * @brief Set the current playing frame.
-   * This method is not thread safe.
+   * This method is thread safe and lock free.
    *
    * @param cursor
    */
-  void setCursor(int cursor) { m_cursor = cursor; }
+  void setCursor(int cursor) {
+    m_cursor.store(cursor, std::memory_order_release);
+  }
+
+  /**
+   * @brief Move the cursor only if it is still at the expected frame, so a
+   * concurrent setCursor is never overwritten.
+   * This method is thread safe and lock free.
+   *
+   * @param expected
+   * @param cursor
+   * @return true if the cursor was moved.
+   */
+  bool advanceCursor(int expected, int cursor) {
+    return m_cursor.compare_exchange_strong(expected, cursor,
+                                            std::memory_order_acq_rel);
+  }
 
   /**
    * @brief Get the m_onChangePlayingTime as eventpp callback reference.
@@ -74,19 +100,29 @@ class AudioObject {
 
   /**
    * @brief Load the audio file from path.
+   * WAV files are decoded into a ProgressiveAudioSource, or streamed from
+   * disk when they are too large for memory. Other formats are decoded by
+   * AudioFile.
    * This method is thread safe.
    *
    * @param filePath
+   * @param progressive return as soon as the header is parsed, the caller
+   * loads the blocks of the ProgressiveAudioSource.
    */
-  void loadAudioFile(const std::string &filePath);
+  void loadAudioFile(const std::string &filePath, bool progressive = false);
 
   /**
-   * @brief Get the internal AudioFile reference.
-   * This method is not thread safe.
+   * @brief Get the shared ownership of the current AudioSource.
+   * The source is never modified after loading, holding the pointer keeps
+   * the samples alive even if another file is loaded.
+   * This method is thread safe.
    *
-   * @return AudioFile<float>&
+   * @return std::shared_ptr<AudioSource>
    */
-  AudioFile<float> &getAudioFile() { return *m_audioFile; }
+  std::shared_ptr<AudioSource> getAudioSource() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_audioSource;
+  }
 
   /**
    * @brief Get the mutex lock by reference.
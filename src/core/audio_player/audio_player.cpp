@@ -1,8 +1,28 @@
 #include "audio_player.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 #include "core/audio_object/audio_object.h"
 #include "logger/logger.h"
 
+/**
+ * @brief Maximum number of frames the producer copies at a time.
+ *
+ */
+#define AUDIO_PRODUCER_CHUNK_FRAMES 1024
+/**
+ * @brief How long the producer sleeps when the ring is full.
+ *
+ */
+#define AUDIO_PRODUCER_IDLE_US 500
+/**
+ * @brief How long play waits for the ring to hold the first buffer.
+ *
+ */
+#define AUDIO_PRIME_TIMEOUT_MS 100
+
 namespace hpaslt {
 
 int AudioPlayer::paCallback(const void *inputBuffer, void *outputBuffer,
@@ -11,6 +31,9 @@ int AudioPlayer::paCallback(const void *inputBuffer, void *outputBuffer,
                             PaStreamCallbackFlags statusFlags, void *userData) {
   AudioPlayer *audioPlayer = (AudioPlayer *)userData;
   AudioObject *audioObj = audioPlayer->m_audioObj.get();
+  const PlaybackSnapshot *snapshot =
+      audioPlayer->m_playbackSnapshot.load(std::memory_order_acquire);
+  SPSCRingBuffer<float> *ringBuffer = audioPlayer->m_ringBuffer.get();
   float *out = (float *)outputBuffer;
 
   // Prevent unused variable warnings.
@@ -18,52 +41,233 @@ int AudioPlayer::paCallback(const void *inputBuffer, void *outputBuffer,
   (void)statusFlags;
   (void)inputBuffer;
 
-  audioObj->getMutex().lock();
-
-  int channelNum = audioObj->getAudioFile().getNumChannels();
-  int sampleNum = audioObj->getAudioFile().getNumSamplesPerChannel();
-  auto samples = audioObj->getAudioFile().samples;
-  int cursor = audioObj->getCursor();
-
-  // TODO: Replace the for loop with memcpy.
-  for (unsigned long i = 0; i < framesPerBuffer; i++) {
-    // Reach the end of the audio.
-    if (cursor + i >= sampleNum) {
-      // Set cursor.
-      audioObj->setCursor(0);
-      audioObj->getMutex().unlock();
-      // Invoke time callback.
-      auto timeCallback = audioObj->getTimeCallback();
-      if (timeCallback)
-        (*timeCallback)(audioObj->getTime(), audioObj->getLength());
-      // Stop the stream.
-      audioPlayer->m_isPlaying = false;
-      audioPlayer->m_onChangePlayingStatus(false);
-      audioPlayer->m_needStopBeforeStartStream = true;
-      logger->coreLogger->trace("AudioPlayer finished.");
-      return paComplete;
+  if (!snapshot || !audioObj || !ringBuffer) {
+    return paAbort;
+  }
+
+  // Drop the frames of the old position after a seek.
+  audioPlayer->syncConsumer();
+
+  // Load the flag before reading, so a finished producer has nothing left.
+  bool producerFinished =
+      audioPlayer->m_producerFinished.load(std::memory_order_acquire) &&
+      audioPlayer->m_seekGeneration.load(std::memory_order_acquire) ==
+          audioPlayer->m_consumerGeneration.load(std::memory_order_relaxed);
+
+  int channelNum = snapshot->channelNum;
+  size_t sampleCount = framesPerBuffer * channelNum;
+  size_t readCount = ringBuffer->read(out, sampleCount);
+
+  // Underrun or the end of the audio, fill the rest with silence.
+  if (readCount < sampleCount) {
+    std::memset(out + readCount, 0, (sampleCount - readCount) * sizeof(float));
+  }
+
+  // Hand the played frames to the analyzer, one bounded copy.
+  SpectrumAnalyzer *spectrumAnalyzer =
+      audioPlayer->m_playbackSpectrumAnalyzer.load(std::memory_order_acquire);
+  if (spectrumAnalyzer) {
+    spectrumAnalyzer->push(out, (int)(readCount / channelNum));
+  }
+
+  // Update the cursor, unless a seek moved it since the last buffer.
+  int cursor = audioPlayer->m_consumerCursor;
+  audioPlayer->m_consumerCursor += (int)(readCount / channelNum);
+  audioObj->advanceCursor(cursor, audioPlayer->m_consumerCursor);
+
+  // Reach the end of the audio.
+  if (producerFinished && readCount < sampleCount) {
+    // Reset cursor and let pollEvents stop the player.
+    audioObj->advanceCursor(audioPlayer->m_consumerCursor, 0);
+    audioPlayer->m_finished.store(true, std::memory_order_release);
+    return paComplete;
+  }
+
+  return paContinue;
+}
+
+void AudioPlayer::requestSeek(int cursor) {
+  // The producer restarts from the same clamped cursor.
+  if (m_snapshot) {
+    cursor = std::clamp(cursor, 0, m_snapshot->sampleNum);
+  }
+  m_audioObj->setCursor(cursor);
+  m_seekCursor.store(cursor, std::memory_order_release);
+  m_seekGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void AudioPlayer::syncConsumer() {
+  int producerGeneration =
+      m_producerGeneration.load(std::memory_order_acquire);
+  if (producerGeneration ==
+      m_consumerGeneration.load(std::memory_order_relaxed))
+    return;
+
+  // The producer stopped writing the old position, the ring only holds stale
+  // frames. The seek already moved the cursor of the AudioObject there.
+  m_ringBuffer->discard();
+  m_consumerCursor = m_producerCursor.load(std::memory_order_relaxed);
+  m_consumerGeneration.store(producerGeneration, std::memory_order_release);
+}
+
+void AudioPlayer::producerLoop(
+    std::shared_ptr<const PlaybackSnapshot> snapshot) {
+  int channelNum = snapshot->channelNum;
+  int sampleNum = snapshot->sampleNum;
+  int generation = m_producerGeneration.load(std::memory_order_relaxed);
+  int cursor = m_producerCursor.load(std::memory_order_relaxed);
+
+  std::vector<float> chunk((size_t)AUDIO_PRODUCER_CHUNK_FRAMES * channelNum);
+
+  while (!m_stopProducer.load(std::memory_order_acquire)) {
+    // Restart from the new position after a seek.
+    int seekGeneration = m_seekGeneration.load(std::memory_order_acquire);
+    if (seekGeneration != generation) {
+      generation = seekGeneration;
+      cursor = std::clamp(m_seekCursor.load(std::memory_order_acquire), 0,
+                          sampleNum);
+      m_producerFinished.store(false, std::memory_order_relaxed);
+      m_producerCursor.store(cursor, std::memory_order_relaxed);
+      m_producerGeneration.store(generation, std::memory_order_release);
     }
-    // Copy data.
-    for (int channel = 0; channel < channelNum; channel++) {
-      *out++ = samples[channel][cursor + i];
+
+    // Wait until the consumer flushed the frames of the old position.
+    bool flushed =
+        m_consumerGeneration.load(std::memory_order_acquire) == generation;
+
+    // Wait at the end of the loaded frames during a progressive load.
+    int loadedSamples = snapshot->audioSource->getLoadedSamples();
+    int frameNum = std::min(
+        {(int)(m_ringBuffer->writeAvailable() / channelNum),
+         AUDIO_PRODUCER_CHUNK_FRAMES, loadedSamples - cursor});
+    if (!flushed || frameNum <= 0) {
+      if (flushed && cursor >= sampleNum)
+        m_producerFinished.store(true, std::memory_order_release);
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(AUDIO_PRODUCER_IDLE_US));
+      continue;
     }
+
+    // Streaming sources may block on the disk here, never in the callback.
+    frameNum = snapshot->audioSource->readInterleaved(cursor, frameNum,
+                                                      chunk.data());
+    m_ringBuffer->write(chunk.data(), (size_t)frameNum * channelNum);
+    cursor += frameNum;
   }
+}
 
-  // Update the cursor.
-  audioObj->setCursor(cursor + framesPerBuffer);
+void AudioPlayer::startProducer() {
+  int channelNum = m_snapshot->channelNum;
+  // The ring must hold at least two device buffers.
+  int ringFrames =
+      std::max(m_config->audioRingBufferFrames, 2 * m_config->audioStreamFPB);
+  m_ringBuffer =
+      std::make_unique<SPSCRingBuffer<float>>((size_t)ringFrames * channelNum);
+
+  // Start in sync at the current cursor.
+  int cursor = m_audioObj->getCursor();
+  int generation = m_seekGeneration.load(std::memory_order_relaxed);
+  m_seekCursor.store(cursor, std::memory_order_relaxed);
+  m_producerCursor.store(cursor, std::memory_order_relaxed);
+  m_producerGeneration.store(generation, std::memory_order_relaxed);
+  m_consumerGeneration.store(generation, std::memory_order_relaxed);
+  m_consumerCursor = cursor;
+  m_producerFinished.store(false, std::memory_order_relaxed);
+  m_stopProducer.store(false, std::memory_order_relaxed);
+
+  m_producerThread =
+      std::thread(&AudioPlayer::producerLoop, this, m_snapshot);
+}
 
-  audioObj->getMutex().unlock();
+void AudioPlayer::stopProducer() {
+  if (!m_producerThread.joinable())
+    return;
 
-  // Invoke time callback.
-  auto timeCallback = audioObj->getTimeCallback();
-  if (timeCallback)
-    (*timeCallback)(audioObj->getTime(), audioObj->getLength());
+  m_stopProducer.store(true, std::memory_order_release);
+  m_producerThread.join();
+}
 
-  return paContinue;
+void AudioPlayer::primeRingBuffer() {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(AUDIO_PRIME_TIMEOUT_MS);
+  size_t primeCount =
+      (size_t)m_config->audioStreamFPB * m_snapshot->channelNum;
+
+  while (std::chrono::steady_clock::now() < deadline) {
+    // Act as the consumer until the stream starts.
+    syncConsumer();
+    bool synced = m_seekGeneration.load(std::memory_order_acquire) ==
+                  m_consumerGeneration.load(std::memory_order_relaxed);
+    if (synced && (m_ringBuffer->readAvailable() >= primeCount ||
+                   m_producerFinished.load(std::memory_order_acquire)))
+      return;
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(AUDIO_PRODUCER_IDLE_US));
+  }
+
+  logger->coreLogger->warn("AudioPlayer ring buffer not primed in time.");
+}
+
+int AudioPlayer::getBufferedFrames() {
+  if (!m_ringBuffer || !m_snapshot)
+    return 0;
+
+  return (int)(m_ringBuffer->readAvailable() / m_snapshot->channelNum);
+}
+
+std::weak_ptr<SpectrumAnalyzer> AudioPlayer::getSpectrumAnalyzer() {
+  std::lock_guard<std::mutex> lock(m_spectrumAnalyzerMutex);
+  return m_spectrumAnalyzer;
+}
+
+void AudioPlayer::setSpectrumAnalyzerEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(m_spectrumAnalyzerMutex);
+  m_spectrumAnalyzerEnabled.store(enabled);
+  if (m_spectrumAnalyzer) {
+    m_spectrumAnalyzer->setEnabled(enabled);
+  }
+}
+
+void AudioPlayer::handleFinished() {
+  if (!m_finished.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  // Restart the producer from the beginning.
+  requestSeek(0);
+
+  // Stop the stream.
+  m_isPlaying = false;
+  m_onChangePlayingStatus(false);
+  m_needStopBeforeStartStream = true;
+  logger->coreLogger->trace("AudioPlayer finished.");
+}
+
+void AudioPlayer::pollEvents() {
+  if (!m_audioObj)
+    return;
+
+  // Invoke time callback when the audio thread moved the cursor.
+  int cursor = m_audioObj->getCursor();
+  if (cursor != m_lastPolledCursor) {
+    m_lastPolledCursor = cursor;
+    auto timeCallback = m_audioObj->getTimeCallback();
+    if (timeCallback)
+      (*timeCallback)(m_audioObj->getTime(), m_audioObj->getLength());
+  }
+
+  handleFinished();
 }
 
 AudioPlayer::AudioPlayer()
-    : m_stream(nullptr), m_isPlaying(false),
+    : m_playbackSnapshot(nullptr), m_finished(false),
+      m_playbackSpectrumAnalyzer(nullptr), m_spectrumAnalyzerEnabled(false),
+      m_stopProducer(false),
+      m_seekGeneration(0), m_seekCursor(0), m_producerGeneration(0),
+      m_producerCursor(0), m_consumerGeneration(0), m_consumerCursor(0),
+      m_producerFinished(false),
+      m_lastPolledCursor(0),
+      m_stream(nullptr), m_isPlaying(false),
       m_needStopBeforeStartStream(false) {
   // Init project settings singleton.
   m_config = ProjectSettingsConfig::getSingleton();
@@ -75,11 +279,16 @@ AudioPlayer::~AudioPlayer() {
     PaError err = Pa_CloseStream(m_stream);
     if (err != paNoError) {
       portAudioError(err);
-      return;
+    } else {
+      logger->coreLogger->trace(
+          "AudioPlayer destructed, pa stream cleaned up.");
     }
-    logger->coreLogger->trace("AudioPlayer destructed, pa stream cleaned up.");
   }
 
+  // The producer may outlive the stream, a joinable thread must never be
+  // destroyed even if closing the stream failed.
+  stopProducer();
+
   // Clear project settings singleton.
   m_config = nullptr;
 }
@@ -93,9 +302,43 @@ void AudioPlayer::loadAudioObject(std::weak_ptr<AudioObject> audioObj) {
     m_audioObj->resetTimeCallback();
   }
 
+  // No callback is running after the pause, the old snapshot can be released.
+  handleFinished();
+  stopProducer();
+  m_playbackSnapshot.store(nullptr, std::memory_order_release);
+  m_snapshot = nullptr;
+  m_playbackSpectrumAnalyzer.store(nullptr, std::memory_order_release);
+
   // Load the object.
   m_audioObj = audioObj.lock();
 
+  // Publish the samples of the new object to the audio callback.
+  auto snapshot = std::make_shared<PlaybackSnapshot>();
+  snapshot->audioSource = m_audioObj->getAudioSource();
+  snapshot->channelNum = snapshot->audioSource->getNumChannels();
+  snapshot->sampleNum = snapshot->audioSource->getNumSamplesPerChannel();
+  snapshot->sampleRate = snapshot->audioSource->getSampleRate();
+  m_snapshot = snapshot;
+  m_playbackSnapshot.store(m_snapshot.get(), std::memory_order_release);
+  m_lastPolledCursor = m_audioObj->getCursor();
+
+  // Analyze the frames of the new object, no callback uses the old analyzer.
+  std::shared_ptr<SpectrumAnalyzer> spectrumAnalyzer =
+      std::make_shared<SpectrumAnalyzer>(m_snapshot->channelNum,
+                                         m_snapshot->sampleRate);
+  {
+    std::lock_guard<std::mutex> lock(m_spectrumAnalyzerMutex);
+    spectrumAnalyzer->setEnabled(m_spectrumAnalyzerEnabled.load());
+    // The old analyzer is released after the lock, its thread is joined.
+    std::swap(m_spectrumAnalyzer, spectrumAnalyzer);
+  }
+  m_playbackSpectrumAnalyzer.store(m_spectrumAnalyzer.get(),
+                                   std::memory_order_release);
+  spectrumAnalyzer = nullptr;
+
+  // Fill the ring before the stream asks for frames.
+  startProducer();
+
   // Set AudioObject callback.
   m_audioObj->setTimeCallback(&m_onChangePlayingTime);
   // Initialize callback.
@@ -110,9 +353,7 @@ void AudioPlayer::loadAudioObject(std::weak_ptr<AudioObject> audioObj) {
     logger->coreLogger->error("No default output device.");
     return;
   }
-  m_audioObj->getMutex().lock();
-  outputParameters.channelCount = m_audioObj->getAudioFile().getNumChannels();
-  m_audioObj->getMutex().unlock();
+  outputParameters.channelCount = m_snapshot->channelNum;
   outputParameters.sampleFormat = paFloat32;
   outputParameters.suggestedLatency =
       Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
@@ -129,11 +370,9 @@ void AudioPlayer::loadAudioObject(std::weak_ptr<AudioObject> audioObj) {
   }
 
   // Open new stream.
-  m_audioObj->getMutex().lock();
   err = Pa_OpenStream(&m_stream, nullptr, &outputParameters,
-                      m_audioObj->getAudioFile().getSampleRate(),
+                      m_snapshot->sampleRate,
                       m_config->audioStreamFPB, paClipOff, paCallback, this);
-  m_audioObj->getMutex().unlock();
 
   if (err != paNoError) {
     portAudioError(err);
@@ -150,6 +389,8 @@ void AudioPlayer::play() {
   if (!m_audioObj)
     return;
 
+  handleFinished();
+
   if (m_isPlaying) {
     logger->coreLogger->trace("AudioPlayer already playing.");
     return;
@@ -163,6 +404,9 @@ void AudioPlayer::play() {
     }
     m_needStopBeforeStartStream = false;
   }
+
+  primeRingBuffer();
+
   PaError err = Pa_StartStream(m_stream);
   if (err != paNoError) {
     portAudioError(err);
@@ -179,6 +423,8 @@ void AudioPlayer::pause() {
   if (!m_audioObj)
     return;
 
+  handleFinished();
+
   if (!m_isPlaying) {
     logger->coreLogger->trace("AudioPlayer already paused.");
     return;
@@ -201,7 +447,7 @@ void AudioPlayer::replay() {
   if (!m_audioObj)
     return;
 
-  m_audioObj->setCursor(0);
+  requestSeek(0);
   auto timeCallback = m_audioObj->getTimeCallback();
   if (timeCallback)
     (*timeCallback)(m_audioObj->getTime(), m_audioObj->getLength());
@@ -213,7 +459,7 @@ void AudioPlayer::stop() {
     return;
 
   pause();
-  m_audioObj->setCursor(0);
+  requestSeek(0);
   auto timeCallback = m_audioObj->getTimeCallback();
   if (timeCallback)
     (*timeCallback)(m_audioObj->getTime(), m_audioObj->getLength());
@@ -223,24 +469,20 @@ void AudioPlayer::setTime(float time) {
   if (!m_audioObj)
     return;
 
-  m_audioObj->getMutex().lock();
-
-  // Get the audio file.
-  AudioFile<float> &audioFile = m_audioObj->getAudioFile();
+  // Get the audio source.
+  std::shared_ptr<AudioSource> audioSource = m_audioObj->getAudioSource();
   // Get the new cursor frame.
-  int cursorFrame = (int)(audioFile.getSampleRate() * time);
+  int cursorFrame = (int)(audioSource->getSampleRate() * time);
 
   // Bound the frame.
-  int maxFrame = audioFile.getNumSamplesPerChannel();
+  int maxFrame = audioSource->getNumSamplesPerChannel();
   if (cursorFrame < 0) {
     cursorFrame = 0;
   } else if (cursorFrame > maxFrame) {
     cursorFrame = maxFrame;
   }
 
-  m_audioObj->setCursor(cursorFrame);
-
-  m_audioObj->getMutex().unlock();
+  requestSeek(cursorFrame);
 }
 
 } // namespace hpaslt
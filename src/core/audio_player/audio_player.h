@@ -3,14 +3,34 @@
 #include <eventpp/callbacklist.h>
 #include <portaudio.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "core/audio_object/audio_object.h"
+#include "core/ring_buffer/ring_buffer.h"
+#include "core/spectrum_analyzer/spectrum_analyzer.h"
 #include "logger/logger.h"
 #include "serialization/project_settings/project_settings_config.h"
 
 namespace hpaslt {
 
+/**
+ * @class PlaybackSnapshot
+ * @brief The AudioSource the producer thread plays.
+ * Holds shared ownership of the source, so loading another file into the
+ * AudioObject never frees samples the producer is reading.
+ *
+ */
+struct PlaybackSnapshot {
+  std::shared_ptr<AudioSource> audioSource;
+  int channelNum;
+  int sampleNum;
+  int sampleRate;
+};
+
 class AudioPlayer {
 private:
   /**
@@ -25,6 +45,123 @@ class AudioPlayer {
    */
   std::shared_ptr<AudioObject> m_audioObj;
 
+  /**
+   * @brief The owner of the snapshot the audio callback plays.
+   * Only replaced while no stream is running.
+   *
+   */
+  std::shared_ptr<const PlaybackSnapshot> m_snapshot;
+
+  /**
+   * @brief The snapshot published to the audio callback.
+   *
+   */
+  std::atomic<const PlaybackSnapshot *> m_playbackSnapshot;
+
+  /**
+   * @brief Set by the audio callback when the audio reaches the end.
+   * Consumed by pollEvents, the audio thread never invokes callbacks.
+   *
+   */
+  std::atomic<bool> m_finished;
+
+  /**
+   * @brief Interleaved frames from the producer thread to the audio callback.
+   * Only replaced while neither the stream nor the producer is running.
+   *
+   */
+  std::unique_ptr<SPSCRingBuffer<float>> m_ringBuffer;
+
+  /**
+   * @brief Guard m_spectrumAnalyzer, it is replaced by the load job while the
+   * UI thread reads it.
+   *
+   */
+  std::mutex m_spectrumAnalyzerMutex;
+
+  /**
+   * @brief The owner of the analyzer of the frames the audio callback plays.
+   *
+   */
+  std::shared_ptr<SpectrumAnalyzer> m_spectrumAnalyzer;
+
+  /**
+   * @brief The analyzer published to the audio callback.
+   * Only replaced while the stream is not running.
+   *
+   */
+  std::atomic<SpectrumAnalyzer *> m_playbackSpectrumAnalyzer;
+
+  /**
+   * @brief If the spectrum analyzer of every loaded AudioObject analyzes.
+   *
+   */
+  std::atomic<bool> m_spectrumAnalyzerEnabled;
+
+  /**
+   * @brief The thread filling m_ringBuffer.
+   *
+   */
+  std::thread m_producerThread;
+
+  /**
+   * @brief Ask the producer thread to exit.
+   *
+   */
+  std::atomic<bool> m_stopProducer;
+
+  /**
+   * @brief Incremented by every seek, the producer restarts when it changes.
+   *
+   */
+  std::atomic<int> m_seekGeneration;
+
+  /**
+   * @brief The cursor of the latest seek.
+   *
+   */
+  std::atomic<int> m_seekCursor;
+
+  /**
+   * @brief The seek generation the producer is writing.
+   *
+   */
+  std::atomic<int> m_producerGeneration;
+
+  /**
+   * @brief The cursor the producer restarted from for m_producerGeneration.
+   *
+   */
+  std::atomic<int> m_producerCursor;
+
+  /**
+   * @brief The seek generation whose frames the consumer is reading.
+   * The producer waits for the consumer to flush the ring before it writes
+   * frames of a new generation.
+   *
+   */
+  std::atomic<int> m_consumerGeneration;
+
+  /**
+   * @brief The frame the consumer reads next.
+   * Only touched by the thread reading the ring, the audio callback advances
+   * the cursor of the AudioObject from it without overwriting a seek.
+   *
+   */
+  int m_consumerCursor;
+
+  /**
+   * @brief Set by the producer once it wrote the last frame of the audio.
+   *
+   */
+  std::atomic<bool> m_producerFinished;
+
+  /**
+   * @brief The cursor last reported through m_onChangePlayingTime.
+   *
+   */
+  int m_lastPolledCursor;
+
   /**
    * @brief Created stream for current AudioObject.
    *
@@ -55,15 +192,70 @@ class AudioPlayer {
    */
   eventpp::CallbackList<void(float, float)> m_onChangePlayingTime;
 
+  /**
+   * @brief Handle the end of audio reported by the audio callback.
+   *
+   */
+  void handleFinished();
+
+  /**
+   * @brief Move the playback to the cursor.
+   * The audio callback keeps playing the frames in the ring until the
+   * producer restarts from the new position.
+   *
+   * @param cursor
+   */
+  void requestSeek(int cursor);
+
+  /**
+   * @brief Consumer side of a seek: drop the frames of the old position once
+   * the producer restarted. Only call this method from the thread reading the
+   * ring, the audio callback or the UI thread while the stream is stopped.
+   *
+   */
+  void syncConsumer();
+
+  /**
+   * @brief Start the producer thread for the current snapshot.
+   *
+   */
+  void startProducer();
+
+  /**
+   * @brief Stop and join the producer thread.
+   *
+   */
+  void stopProducer();
+
+  /**
+   * @brief Copy interleaved frames of the snapshot into the ring until
+   * stopped.
+   *
+   * @param snapshot
+   */
+  void producerLoop(std::shared_ptr<const PlaybackSnapshot> snapshot);
+
+  /**
+   * @brief Wait until the ring holds the first buffer to play.
+   * Only call this method while the stream is stopped.
+   *
+   */
+  void primeRingBuffer();
+
+public:
   /**
    * @brief Callback function called by Port Audio.
+   * Real time safe: no locks, allocations, logging or callbacks. Frames come
+   * from the ring buffer filled by the producer thread and the cursor is
+   * atomic. The played frames are copied into the spectrum analyzer ring.
+   * Public so benchmarks can drive it without an audio device.
    *
    * @param inputBuffer ignore input buffer.
    * @param outputBuffer write to this buffer to play audio.
    * @param framesPerBuffer number of frames to write.
    * @param timeInfo PaStreamCallbackTimeInfo pointer.
    * @param statusFlags PaStreamCallbackFlags struct.
-   * @param userData AudioObject pointer as void*.
+   * @param userData AudioPlayer pointer as void*.
    * @return paContinue if there's more data to play.
    * @return paComplete if the audio ends.
    */
@@ -72,7 +264,6 @@ class AudioPlayer {
                         const PaStreamCallbackTimeInfo *timeInfo,
                         PaStreamCallbackFlags statusFlags, void *userData);
 
-public:
   static void portAudioError(PaError err) {
     logger->coreLogger->error("Port Audio Error: {}", Pa_GetErrorText(err));
   }
@@ -135,6 +326,39 @@ class AudioPlayer {
     return m_onChangePlayingTime;
   }
 
+  /**
+   * @brief Invoke the callbacks for what the audio thread did since the last
+   * call: playing time changes and the end of the audio.
+   * Call this method from the UI thread once per frame.
+   *
+   */
+  void pollEvents();
+
+  /**
+   * @brief Get the number of frames queued ahead of the audio device.
+   * Exact while the stream is stopped, approximate while it is playing.
+   *
+   * @return int
+   */
+  int getBufferedFrames();
+
+  /**
+   * @brief Get the analyzer of the current AudioObject.
+   * Replaced when another AudioObject is loaded.
+   *
+   * @return std::weak_ptr<SpectrumAnalyzer>
+   */
+  std::weak_ptr<SpectrumAnalyzer> getSpectrumAnalyzer();
+
+  /**
+   * @brief Start or stop analyzing the played frames, for the current and
+   * every later AudioObject. The audio callback skips the analyzer while it is
+   * disabled.
+   *
+   * @param enabled
+   */
+  void setSpectrumAnalyzerEnabled(bool enabled);
+
   /**
    * @brief Load the AudioObject to the AudioPlayer.
    *
@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+ * @brief The number of frames in one block of an AudioSource.
+ * Streaming sources decode, cache and read ahead whole blocks.
+ *
+ */
+#define AUDIO_SOURCE_BLOCK_FRAMES 65536
+
+namespace hpaslt {
+
+/**
+ * @brief Block based read access to the samples of an audio.
+ * Consumers copy the range they need instead of indexing a fully decoded
+ * buffer, so the samples may live in memory or be streamed from disk.
+ * All the methods are thread safe.
+ *
+ */
+class AudioSource {
+public:
+  virtual ~AudioSource() {}
+
+  virtual int getNumChannels() = 0;
+
+  virtual int getSampleRate() = 0;
+
+  virtual int getNumSamplesPerChannel() = 0;
+
+  /**
+   * @brief Get the number of frames that can be read.
+   * Only grows, the frames before it never change. Smaller than
+   * getNumSamplesPerChannel while a progressive load is running.
+   *
+   * @return int
+   */
+  virtual int getLoadedSamples() { return getNumSamplesPerChannel(); }
+
+  /**
+   * @brief Copy the samples of one channel.
+   *
+   * @param channel
+   * @param offset the first frame to read.
+   * @param count the number of frames, clamped to the loaded frames.
+   * @param dst
+   * @return int the number of samples written.
+   */
+  virtual int read(int channel, int offset, int count, float *dst) = 0;
+
+  /**
+   * @brief Copy the frames of all the channels interleaved.
+   *
+   * @param offset the first frame to read.
+   * @param count the number of frames, clamped to the loaded frames.
+   * @param dst
+   * @return int the number of frames written.
+   */
+  virtual int readInterleaved(int offset, int count, float *dst) = 0;
+
+  /**
+   * @brief Get all the samples of one channel if they are resident.
+   * Lets consumers skip the copy for in memory audio. Only the frames below
+   * getLoadedSamples are valid, the pointer lives as long as the source.
+   *
+   * @param channel
+   * @return const float* nullptr if the samples are not contiguous in memory.
+   */
+  virtual const float *getChannelData(int channel) { return nullptr; }
+};
+
+} // namespace hpaslt
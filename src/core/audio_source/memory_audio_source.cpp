@@ -0,0 +1,77 @@
+#include "memory_audio_source.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace hpaslt {
+
+int MemoryAudioSource::read(int channel, int offset, int count, float *dst) {
+  int sampleNum = getNumSamplesPerChannel();
+  if (channel < 0 || channel >= getNumChannels() || offset < 0 ||
+      offset >= sampleNum) {
+    return 0;
+  }
+  count = std::min(count, sampleNum - offset);
+
+  std::memcpy(dst, m_audioFile->samples[channel].data() + offset,
+              count * sizeof(float));
+  return count;
+}
+
+void MemoryAudioSource::prepareInterleaved() {
+  int channelNum = getNumChannels();
+  int sampleNum = getNumSamplesPerChannel();
+  // Mono is already interleaved.
+  if (channelNum <= 1) {
+    return;
+  }
+
+  // Interleave before the copy is set, readInterleaved would read from it.
+  std::vector<float> interleaved((size_t)sampleNum * channelNum);
+  readInterleaved(0, sampleNum, interleaved.data());
+  m_interleaved = std::move(interleaved);
+}
+
+int MemoryAudioSource::readInterleaved(int offset, int count, float *dst) {
+  int channelNum = getNumChannels();
+  int sampleNum = getNumSamplesPerChannel();
+  if (offset < 0 || offset >= sampleNum) {
+    return 0;
+  }
+  count = std::min(count, sampleNum - offset);
+
+  // Mono is already interleaved.
+  if (channelNum == 1) {
+    std::memcpy(dst, m_audioFile->samples[0].data() + offset,
+                count * sizeof(float));
+    return count;
+  }
+
+  if (!m_interleaved.empty()) {
+    std::memcpy(dst, m_interleaved.data() + (size_t)offset * channelNum,
+                (size_t)count * channelNum * sizeof(float));
+    return count;
+  }
+
+  // Stereo is the common case, keep the two streams in registers.
+  if (channelNum == 2) {
+    const float *left = m_audioFile->samples[0].data() + offset;
+    const float *right = m_audioFile->samples[1].data() + offset;
+    for (int i = 0; i < count; i++) {
+      dst[2 * i] = left[i];
+      dst[2 * i + 1] = right[i];
+    }
+    return count;
+  }
+
+  for (int channel = 0; channel < channelNum; channel++) {
+    const float *in = m_audioFile->samples[channel].data() + offset;
+    for (int i = 0; i < count; i++) {
+      dst[i * channelNum + channel] = in[i];
+    }
+  }
+  return count;
+}
+
+} // namespace hpaslt
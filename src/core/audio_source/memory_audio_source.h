@@ -0,0 +1,70 @@
+#pragma once
+
+#include <AudioFile.h>
+
+#include <memory>
+#include <vector>
+
+#include "core/audio_source/audio_source.h"
+
+namespace hpaslt {
+
+/**
+ * @brief An AudioSource over a fully decoded AudioFile.
+ * The AudioFile must not be modified while the source is in use.
+ *
+ */
+class MemoryAudioSource : public AudioSource {
+private:
+  std::shared_ptr<AudioFile<float>> m_audioFile;
+
+  /**
+   * @brief All the frames interleaved, empty until prepareInterleaved.
+   *
+   */
+  std::vector<float> m_interleaved;
+
+public:
+  /**
+   * @brief Construct a new MemoryAudioSource object.
+   *
+   * @param audioFile
+   */
+  explicit MemoryAudioSource(std::shared_ptr<AudioFile<float>> audioFile)
+      : m_audioFile(audioFile) {}
+
+  /**
+   * @brief Get the underlying AudioFile.
+   *
+   * @return std::shared_ptr<AudioFile<float>>
+   */
+  std::shared_ptr<AudioFile<float>> getAudioFile() { return m_audioFile; }
+
+  /**
+   * @brief Interleave every frame once, so readInterleaved is a single copy.
+   * Doubles the memory of multichannel audio, only playback needs it. Must be
+   * called before the source is shared between threads.
+   *
+   */
+  void prepareInterleaved();
+
+  virtual int getNumChannels() override {
+    return m_audioFile->getNumChannels();
+  }
+
+  virtual int getSampleRate() override { return m_audioFile->getSampleRate(); }
+
+  virtual int getNumSamplesPerChannel() override {
+    return m_audioFile->getNumSamplesPerChannel();
+  }
+
+  virtual int read(int channel, int offset, int count, float *dst) override;
+
+  virtual int readInterleaved(int offset, int count, float *dst) override;
+
+  virtual const float *getChannelData(int channel) override {
+    return m_audioFile->samples[channel].data();
+  }
+};
+
+} // namespace hpaslt
@@ -0,0 +1,67 @@
+#include "progressive_audio_source.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hpaslt {
+
+ProgressiveAudioSource::ProgressiveAudioSource(
+    std::shared_ptr<AudioSource> decoder)
+    : m_decoder(decoder), m_channelNum(decoder->getNumChannels()),
+      m_sampleRate(decoder->getSampleRate()),
+      m_sampleNum(decoder->getNumSamplesPerChannel()), m_decodedBlockNum(0),
+      m_loadedSamples(0) {
+  // Not value initialized, the pages are only touched when a block is loaded.
+  for (int channel = 0; channel < m_channelNum; channel++) {
+    m_channels.emplace_back(new float[m_sampleNum]);
+  }
+}
+
+bool ProgressiveAudioSource::loadNextBlock() {
+  int offset = m_decodedBlockNum * AUDIO_SOURCE_BLOCK_FRAMES;
+  if (offset >= m_sampleNum) {
+    return false;
+  }
+
+  int count = std::min(AUDIO_SOURCE_BLOCK_FRAMES, m_sampleNum - offset);
+  for (int channel = 0; channel < m_channelNum; channel++) {
+    m_decoder->read(channel, offset, count, m_channels[channel].get() + offset);
+  }
+  m_decodedBlockNum++;
+
+  // Readers only touch frames below the published frame number.
+  m_loadedSamples.store(offset + count, std::memory_order_release);
+  return offset + count < m_sampleNum;
+}
+
+int ProgressiveAudioSource::read(int channel, int offset, int count,
+                                 float *dst) {
+  int loadedSamples = getLoadedSamples();
+  if (channel < 0 || channel >= m_channelNum || offset < 0 ||
+      offset >= loadedSamples) {
+    return 0;
+  }
+  count = std::min(count, loadedSamples - offset);
+
+  std::memcpy(dst, m_channels[channel].get() + offset, count * sizeof(float));
+  return count;
+}
+
+int ProgressiveAudioSource::readInterleaved(int offset, int count,
+                                            float *dst) {
+  int loadedSamples = getLoadedSamples();
+  if (offset < 0 || offset >= loadedSamples) {
+    return 0;
+  }
+  count = std::min(count, loadedSamples - offset);
+
+  for (int channel = 0; channel < m_channelNum; channel++) {
+    const float *in = m_channels[channel].get() + offset;
+    for (int i = 0; i < count; i++) {
+      dst[i * m_channelNum + channel] = in[i];
+    }
+  }
+  return count;
+}
+
+} // namespace hpaslt
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "core/audio_source/audio_source.h"
+
+namespace hpaslt {
+
+/**
+ * @brief An AudioSource decoded into memory block by block.
+ * A loader thread calls loadNextBlock until it returns false, every call
+ * publishes one more block. Readers see a growing, immutable prefix of the
+ * audio through getLoadedSamples and can start working on it right away.
+ *
+ */
+class ProgressiveAudioSource : public AudioSource {
+private:
+  /**
+   * @brief The source decoded by the loader, only read by loadNextBlock.
+   *
+   */
+  std::shared_ptr<AudioSource> m_decoder;
+
+  int m_channelNum;
+  int m_sampleRate;
+  int m_sampleNum;
+
+  /**
+   * @brief The samples of each channel, allocated up front so publishing a
+   * block never moves the samples before it.
+   *
+   */
+  std::vector<std::unique_ptr<float[]>> m_channels;
+
+  /**
+   * @brief The number of blocks loadNextBlock has written.
+   * Only accessed by the loader thread.
+   *
+   */
+  int m_decodedBlockNum;
+
+  /**
+   * @brief The number of frames published to the readers.
+   *
+   */
+  std::atomic<int> m_loadedSamples;
+
+public:
+  /**
+   * @brief Construct a new ProgressiveAudioSource object.
+   *
+   * @param decoder the source to decode, read from the beginning to the end.
+   */
+  explicit ProgressiveAudioSource(std::shared_ptr<AudioSource> decoder);
+
+  /**
+   * @brief Decode and publish the next block.
+   * Only one thread may call this method.
+   *
+   * @return true if there are more blocks to load.
+   * @return false if the audio is completely loaded.
+   */
+  bool loadNextBlock();
+
+  /**
+   * @brief Load all the remaining blocks.
+   *
+   */
+  void loadAll() {
+    while (loadNextBlock()) {
+    }
+  }
+
+  virtual int getNumChannels() override { return m_channelNum; }
+
+  virtual int getSampleRate() override { return m_sampleRate; }
+
+  virtual int getNumSamplesPerChannel() override { return m_sampleNum; }
+
+  virtual int getLoadedSamples() override {
+    return m_loadedSamples.load(std::memory_order_acquire);
+  }
+
+  virtual int read(int channel, int offset, int count, float *dst) override;
+
+  virtual int readInterleaved(int offset, int count, float *dst) override;
+
+  virtual const float *getChannelData(int channel) override {
+    return m_channels[channel].get();
+  }
+};
+
+} // namespace hpaslt
@@ -0,0 +1,185 @@
+#include "streaming_audio_source.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+namespace hpaslt {
+
+StreamingAudioSource::StreamingAudioSource(const std::string &filePath)
+    : m_wavFile(std::make_unique<MappedWavFile>(filePath)),
+      m_readAheadBlock(-1), m_stopReadAhead(false) {
+  if (m_wavFile->getNumSamplesPerChannel() > INT_MAX) {
+    throw std::invalid_argument("Audio file is too long.");
+  }
+  m_channelNum = m_wavFile->getNumChannels();
+  m_sampleRate = m_wavFile->getSampleRate();
+  m_sampleNum = (int)m_wavFile->getNumSamplesPerChannel();
+
+  m_readAheadThread = std::thread(&StreamingAudioSource::readAheadLoop, this);
+}
+
+StreamingAudioSource::~StreamingAudioSource() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopReadAhead = true;
+  }
+  m_readAheadCondition.notify_one();
+  m_readAheadThread.join();
+}
+
+StreamingAudioSource::Block
+StreamingAudioSource::decodeBlock(int blockIndex) {
+  int64_t offset = (int64_t)blockIndex * AUDIO_SOURCE_BLOCK_FRAMES;
+  auto block = std::make_shared<std::vector<float>>(
+      (size_t)AUDIO_SOURCE_BLOCK_FRAMES * m_channelNum);
+  for (int channel = 0; channel < m_channelNum; channel++) {
+    m_wavFile->readSamples(channel, offset, AUDIO_SOURCE_BLOCK_FRAMES,
+                           block->data() +
+                               (size_t)channel * AUDIO_SOURCE_BLOCK_FRAMES);
+  }
+  // The float copy is cached, the pages of the file are no longer needed.
+  m_wavFile->release(offset, AUDIO_SOURCE_BLOCK_FRAMES);
+  return block;
+}
+
+StreamingAudioSource::Block
+StreamingAudioSource::insertBlock(int blockIndex, Block block) {
+  auto it = m_blocks.find(blockIndex);
+  if (it != m_blocks.end()) {
+    return it->second.first;
+  }
+
+  m_lruBlocks.push_front(blockIndex);
+  m_blocks[blockIndex] = {block, m_lruBlocks.begin()};
+
+  // Evict the least recently used blocks, readers still holding one keep it
+  // alive.
+  while (m_lruBlocks.size() > STREAMING_CACHE_BLOCKS) {
+    m_blocks.erase(m_lruBlocks.back());
+    m_lruBlocks.pop_back();
+  }
+  return block;
+}
+
+StreamingAudioSource::Block StreamingAudioSource::getBlock(int blockIndex) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_blocks.find(blockIndex);
+    if (it != m_blocks.end()) {
+      // Mark as the most recently used.
+      m_lruBlocks.splice(m_lruBlocks.begin(), m_lruBlocks, it->second.second);
+      return it->second.first;
+    }
+  }
+
+  // Decode without the lock, so readers of other blocks are not blocked.
+  Block block = decodeBlock(blockIndex);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return insertBlock(blockIndex, block);
+}
+
+void StreamingAudioSource::requestReadAhead(int blockIndex) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_readAheadBlock = blockIndex;
+  }
+  m_readAheadCondition.notify_one();
+}
+
+void StreamingAudioSource::readAheadLoop() {
+  int blockNum =
+      (m_sampleNum + AUDIO_SOURCE_BLOCK_FRAMES - 1) / AUDIO_SOURCE_BLOCK_FRAMES;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_readAheadCondition.wait(
+        lock, [this]() { return m_stopReadAhead || m_readAheadBlock >= 0; });
+    if (m_stopReadAhead) {
+      return;
+    }
+
+    int firstBlock = m_readAheadBlock;
+    m_readAheadBlock = -1;
+    int lastBlock =
+        std::min(firstBlock + STREAMING_READ_AHEAD_BLOCKS, blockNum);
+
+    for (int blockIndex = firstBlock; blockIndex < lastBlock; blockIndex++) {
+      // A newer request or the destructor takes over.
+      if (m_stopReadAhead || m_readAheadBlock >= 0) {
+        break;
+      }
+      if (m_blocks.contains(blockIndex)) {
+        continue;
+      }
+
+      lock.unlock();
+      Block block = decodeBlock(blockIndex);
+      lock.lock();
+      insertBlock(blockIndex, block);
+    }
+  }
+}
+
+int StreamingAudioSource::read(int channel, int offset, int count,
+                               float *dst) {
+  if (channel < 0 || channel >= m_channelNum || offset < 0 ||
+      offset >= m_sampleNum) {
+    return 0;
+  }
+  count = std::min(count, m_sampleNum - offset);
+
+  int written = 0;
+  while (written < count) {
+    int frame = offset + written;
+    int blockIndex = frame / AUDIO_SOURCE_BLOCK_FRAMES;
+    int blockOffset = frame % AUDIO_SOURCE_BLOCK_FRAMES;
+    int blockCount =
+        std::min(count - written, AUDIO_SOURCE_BLOCK_FRAMES - blockOffset);
+
+    Block block = getBlock(blockIndex);
+    std::memcpy(dst + written,
+                block->data() + (size_t)channel * AUDIO_SOURCE_BLOCK_FRAMES +
+                    blockOffset,
+                blockCount * sizeof(float));
+    written += blockCount;
+  }
+
+  requestReadAhead((offset + count - 1) / AUDIO_SOURCE_BLOCK_FRAMES + 1);
+  return count;
+}
+
+int StreamingAudioSource::readInterleaved(int offset, int count, float *dst) {
+  if (offset < 0 || offset >= m_sampleNum) {
+    return 0;
+  }
+  count = std::min(count, m_sampleNum - offset);
+
+  int written = 0;
+  while (written < count) {
+    int frame = offset + written;
+    int blockIndex = frame / AUDIO_SOURCE_BLOCK_FRAMES;
+    int blockOffset = frame % AUDIO_SOURCE_BLOCK_FRAMES;
+    int blockCount =
+        std::min(count - written, AUDIO_SOURCE_BLOCK_FRAMES - blockOffset);
+
+    Block block = getBlock(blockIndex);
+    float *out = dst + (size_t)written * m_channelNum;
+    for (int channel = 0; channel < m_channelNum; channel++) {
+      const float *in = block->data() +
+                        (size_t)channel * AUDIO_SOURCE_BLOCK_FRAMES +
+                        blockOffset;
+      for (int i = 0; i < blockCount; i++) {
+        out[i * m_channelNum + channel] = in[i];
+      }
+    }
+    written += blockCount;
+  }
+
+  requestReadAhead((offset + count - 1) / AUDIO_SOURCE_BLOCK_FRAMES + 1);
+  return count;
+}
+
+} // namespace hpaslt
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "core/audio_source/audio_source.h"
+#include "core/mapped_wav_file/mapped_wav_file.h"
+
+/**
+ * @brief The number of decoded blocks a StreamingAudioSource keeps.
+ *
+ */
+#define STREAMING_CACHE_BLOCKS 64
+
+/**
+ * @brief The number of blocks decoded ahead of the last read.
+ *
+ */
+#define STREAMING_READ_AHEAD_BLOCKS 4
+
+namespace hpaslt {
+
+/**
+ * @brief An AudioSource streaming a WAV file from disk.
+ * Only the header is parsed when the source is opened. Blocks are converted
+ * to float on first access and kept in a small LRU cache, and a read ahead
+ * thread decodes the blocks following the last read so sequential readers
+ * like the player rarely wait for the disk.
+ *
+ */
+class StreamingAudioSource : public AudioSource {
+private:
+  /**
+   * @brief One decoded block, the channels are stored one after another.
+   *
+   */
+  using Block = std::shared_ptr<const std::vector<float>>;
+
+  std::unique_ptr<MappedWavFile> m_wavFile;
+
+  int m_channelNum;
+  int m_sampleRate;
+  int m_sampleNum;
+
+  /**
+   * @brief Guards the cache and the read ahead request.
+   *
+   */
+  std::mutex m_mutex;
+
+  /**
+   * @brief Decoded blocks by block index.
+   *
+   */
+  std::unordered_map<int, std::pair<Block, std::list<int>::iterator>>
+      m_blocks;
+
+  /**
+   * @brief Block indices from the most to the least recently used.
+   *
+   */
+  std::list<int> m_lruBlocks;
+
+  /**
+   * @brief The first block the read ahead thread should decode, -1 for none.
+   *
+   */
+  int m_readAheadBlock;
+
+  bool m_stopReadAhead;
+
+  std::condition_variable m_readAheadCondition;
+
+  std::thread m_readAheadThread;
+
+  /**
+   * @brief Get the block from the cache or decode it.
+   *
+   * @param blockIndex
+   * @return Block
+   */
+  Block getBlock(int blockIndex);
+
+  /**
+   * @brief Decode one block from the mapped file.
+   *
+   * @param blockIndex
+   * @return Block
+   */
+  Block decodeBlock(int blockIndex);
+
+  /**
+   * @brief Insert a decoded block and evict the least recently used ones.
+   * Must be called with m_mutex held.
+   *
+   * @param blockIndex
+   * @param block
+   * @return Block the cached block, which may have been inserted by another
+   * thread first.
+   */
+  Block insertBlock(int blockIndex, Block block);
+
+  /**
+   * @brief Ask the read ahead thread to decode the blocks after blockIndex.
+   *
+   * @param blockIndex
+   */
+  void requestReadAhead(int blockIndex);
+
+  /**
+   * @brief Decode requested blocks until stopped.
+   *
+   */
+  void readAheadLoop();
+
+public:
+  /**
+   * @brief Open the WAV file at the path.
+   * Throws std::invalid_argument if the file is not a supported WAV file.
+   *
+   * @param filePath
+   */
+  explicit StreamingAudioSource(const std::string &filePath);
+
+  /**
+   * @brief Disable the default copy constructor for StreamingAudioSource.
+   *
+   */
+  StreamingAudioSource(const StreamingAudioSource &) = delete;
+
+  /**
+   * @brief Stop the read ahead thread and unmap the file.
+   *
+   */
+  ~StreamingAudioSource();
+
+  virtual int getNumChannels() override { return m_channelNum; }
+
+  virtual int getSampleRate() override { return m_sampleRate; }
+
+  virtual int getNumSamplesPerChannel() override { return m_sampleNum; }
+
+  virtual int read(int channel, int offset, int count, float *dst) override;
+
+  virtual int readInterleaved(int offset, int count, float *dst) override;
+};
+
+} // namespace hpaslt
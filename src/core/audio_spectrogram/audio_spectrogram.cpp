@@ -1,5 +1,24 @@
 #include "audio_spectrogram.h"
 
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/audio_source/memory_audio_source.h"
+#include "core/fft_plan_cache/fft_plan_cache.h"
+#include "core/fft_wisdom/fft_wisdom.h"
+
+// Bytes of samples and bins one worker transforms before taking a new chunk.
+#define SPECTROGRAM_CHUNK_BYTES (256 * 1024)
+// Resynthesized samples with less summed squared window are set to zero.
+#define SPECTROGRAM_ISTFT_MIN_POWER 1e-10f
+
 namespace hpaslt {
 
 RawSpectrogram::RawSpectrogram(int size) {
@@ -13,64 +32,765 @@ RawSpectrogram::~RawSpectrogram() {
   fftwf_free(m_rawSpectrogram);
 }
 
-void AudioSpectrogram::generateSpectrogram(
-    std::shared_ptr<AudioFile<float>> audioFile, int nfft) {
-  // Set the sample rate and fft bin size.
-  m_audioFile = audioFile;
-  m_nfft = nfft;
-  m_spectrogramLength = m_audioFile->getNumSamplesPerChannel() / m_nfft;
+CompactSpectrogram::CompactSpectrogram(SpectrogramFormat format, int size)
+    : m_format(format), m_spectrogramSize(size) {
+  m_data = fftwf_malloc(std::max<size_t>(1, getBytes()));
+}
 
-  /* ---------------- Generate the spectrogram ---------------- */
+CompactSpectrogram::~CompactSpectrogram() { fftwf_free(m_data); }
 
-  int channelNum = m_audioFile->getNumChannels();
+/**
+ * @brief Convert a float to an IEEE half float, rounding to nearest even.
+ * Branch free, so the conversion loops vectorize.
+ *
+ * @param value
+ * @return uint16_t
+ */
+static inline uint16_t floatToHalf(float value) {
+  uint32_t bits = std::bit_cast<uint32_t>(value);
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
 
-  // Clear the old raw spectrogram for all channels.
-  m_rawSpectrograms.clear();
-  // Init raw spectrogram for all channels.
-  for (int i = 0; i < channelNum; i++) {
-    m_rawSpectrograms.push_back(
-        std::make_unique<RawSpectrogram>(m_nfft * m_spectrogramLength));
-  }
-
-  // Read the samples into the input fftw complex array.
-  std::vector<fftwf_complex *> inputs;
-  inputs.resize(channelNum);
-  for (int channel = 0; channel < channelNum; channel++) {
-    // Alloc the input array.
-    inputs[channel] =
-        (fftwf_complex *)fftwf_alloc_complex(m_nfft * m_spectrogramLength);
-    // Read the data in as real number.
-#pragma omp parallel for
-    for (int i = 0; i < m_nfft * m_spectrogramLength; i++) {
-      inputs[channel][i][0] = m_audioFile->samples[channel][i];
-      inputs[channel][i][1] = 0;
+  // Every case is computed and selected with masks, so the conversion loops
+  // have no branches. Overflow to inf, keep NaN.
+  uint32_t nanMask = 0u - (uint32_t)(bits > (255u << 23));
+  uint32_t special = 0x7c00u | (nanMask & 0x200u);
+  // Let the float addition round the subnormals.
+  const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+  uint32_t subnormal =
+      std::bit_cast<uint32_t>(std::bit_cast<float>(bits) +
+                              std::bit_cast<float>(denormMagic)) -
+      denormMagic;
+  // Rebias the exponent and round the mantissa.
+  uint32_t mantissaOdd = (bits >> 13) & 1;
+  uint32_t normal =
+      (bits + ((uint32_t)(15 - 127) << 23) + 0xfffu + mantissaOdd) >> 13;
+
+  uint32_t specialMask = 0u - (uint32_t)(bits >= ((127u + 16) << 23));
+  uint32_t subnormalMask = 0u - (uint32_t)(bits < (113u << 23));
+  uint32_t half = (special & specialMask) |
+                  (subnormal & subnormalMask & ~specialMask) |
+                  (normal & ~subnormalMask & ~specialMask);
+  return (uint16_t)(half | (sign >> 16));
+}
+
+/**
+ * @brief An approximate log2 accurate to about 0.005, enough for 8 bit dB.
+ * Branch free, so the conversion loops vectorize.
+ *
+ * @param value a positive normal float.
+ * @return float
+ */
+static inline float fastLog2(float value) {
+  uint32_t bits = std::bit_cast<uint32_t>(value);
+  // The polynomial approximates log2(mantissa) + 1 on [1, 2).
+  float exponent = (float)((int)(bits >> 23) - 128);
+  float mantissa = std::bit_cast<float>((bits & 0x7fffffu) | 0x3f800000u);
+  return exponent +
+         (-0.34484843f * mantissa + 2.02466578f) * mantissa - 0.67487759f;
+}
+
+void AudioSpectrogram::preparePlans(int nfft) {
+  // Plan on fftw allocated arrays, which share the alignment of the arrays
+  // generateSpectrogram executes on. Frames read straight from the samples
+  // start at any float, and the bins of a frame at any complex number.
+  int alignmentNum = FFTPlanCache::getAlignmentNum();
+  fftwf_complex *in = fftwf_alloc_complex(nfft + alignmentNum);
+  fftwf_complex *out = fftwf_alloc_complex(nfft + alignmentNum);
+
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+  planCache->getComplexPlan(nfft, FFTW_FORWARD, in, out,
+                            FFTWisdom::getPlannerFlags());
+  for (int inOffset = 0; inOffset < alignmentNum; inOffset++) {
+    for (int outOffset = 0; outOffset == 0 || 2 * outOffset < alignmentNum;
+         outOffset++) {
+      planCache->getRealToComplexPlan(nfft, (float *)in + inOffset,
+                                      out + outOffset,
+                                      FFTWisdom::getPlannerFlags());
+    }
+  }
+  planCache->getComplexToRealPlan(nfft, in, (float *)out,
+                                  FFTWisdom::getPlannerFlags());
+
+  fftwf_free(in);
+  fftwf_free(out);
+}
+
+void AudioSpectrogram::preparePlans(const STFTConfig &config) {
+  preparePlans(config.nfft);
+  if (config.mode != SpectrogramMode::RealToComplex ||
+      config.execution != SpectrogramExecution::Batched) {
+    return;
+  }
+
+  // The plans of a full chunk, the last partial chunk of a source is still
+  // planned on first use. Frames are loaded into the chunk buffer, rectangular
+  // frames are read straight from the samples one hop apart at any float.
+  int nfft = config.nfft;
+  int binNum = nfft / 2 + 1;
+  int frameNum = getChunkFrameNum(config);
+  int alignmentNum = FFTPlanCache::getAlignmentNum();
+  float *in = fftwf_alloc_real(alignmentNum);
+  fftwf_complex *out = fftwf_alloc_complex(alignmentNum);
+
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+  bool direct = config.window == WindowFunction::Rectangular;
+  for (int inOffset = 0; inOffset < (direct ? alignmentNum : 1); inOffset++) {
+    for (int outOffset = 0; outOffset == 0 || 2 * outOffset < alignmentNum;
+         outOffset++) {
+      planCache->getRealToComplexManyPlan(nfft, frameNum, in + inOffset, nfft,
+                                          out + outOffset, binNum,
+                                          FFTWisdom::getPlannerFlags());
+      if (direct) {
+        planCache->getRealToComplexManyPlan(
+            nfft, frameNum, in + inOffset, config.hopSize, out + outOffset,
+            binNum, FFTWisdom::getPlannerFlags());
+      }
+    }
+  }
+
+  fftwf_free(in);
+  fftwf_free(out);
+}
+
+int AudioSpectrogram::getFrameNum(const STFTConfig &config, int sampleNum) {
+  int nfft = config.nfft;
+  int hopSize = config.hopSize;
+  if (sampleNum <= 0) {
+    return 0;
+  }
+
+  // Only whole frames.
+  if (config.padding == PaddingMode::Drop) {
+    return sampleNum < nfft ? 0 : (sampleNum - nfft) / hopSize + 1;
+  }
+
+  // One more frame for the padded partial frame.
+  if (sampleNum <= nfft) {
+    return 1;
+  }
+  return (sampleNum - nfft + hopSize - 1) / hopSize + 1;
+}
+
+/**
+ * @brief Mirror an index past the end of the samples back into range.
+ *
+ * @param index
+ * @param sampleNum
+ * @return int
+ */
+static int reflectIndex(int index, int sampleNum) {
+  if (sampleNum == 1) {
+    return 0;
+  }
+  int period = 2 * (sampleNum - 1);
+  index %= period;
+  return index < sampleNum ? index : period - index;
+}
+
+const float *AudioSpectrogram::loadChunkSamples(int channel, int firstFrame,
+                                                int lastFrame,
+                                                std::vector<float> &buffer,
+                                                int &sampleOffset) {
+  // Resident samples are used in place once they are completely loaded.
+  const float *channelData = m_audioSource->getChannelData(channel);
+  if (channelData && m_audioSource->getLoadedSamples() ==
+                         m_audioSource->getNumSamplesPerChannel()) {
+    sampleOffset = 0;
+    return channelData;
+  }
+
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
+  int first = firstFrame * m_config.hopSize;
+  int lastEnd = (lastFrame - 1) * m_config.hopSize + m_config.nfft;
+  // Reflect padding mirrors the samples before the end of the audio.
+  if (m_config.padding == PaddingMode::Reflect && lastEnd > sampleNum) {
+    int period = 2 * (sampleNum - 1);
+    int mirrored = lastEnd - 1 >= period ? 0 : period - (lastEnd - 1);
+    first = std::min(first, std::max(0, mirrored));
+  }
+  int end = std::min(sampleNum, lastEnd);
+
+  buffer.resize(end - first);
+  int readNum = m_audioSource->read(channel, first, end - first, buffer.data());
+  // Frames a progressive load has not reached yet are silent.
+  std::fill(buffer.begin() + readNum, buffer.end(), 0.f);
+  sampleOffset = first;
+  return buffer.data();
+}
+
+void AudioSpectrogram::loadFrame(const float *samples, int sampleOffset,
+                                 int sampleNum, int start, float *dst) {
+  int nfft = m_config.nfft;
+  const float *window = m_window.data();
+  const float *frame = samples + (start - sampleOffset);
+  int validNum = std::min(nfft, sampleNum - start);
+
+  // Apply the window in the same pass that loads the frame.
+#pragma omp simd
+  for (int i = 0; i < validNum; i++) {
+    dst[i] = frame[i] * window[i];
+  }
+
+  // Pad the partial frame.
+  for (int i = validNum; i < nfft; i++) {
+    float sample = 0;
+    if (m_config.padding == PaddingMode::Reflect) {
+      sample = samples[reflectIndex(start + i, sampleNum) - sampleOffset];
+    }
+    dst[i] = sample * window[i];
+  }
+}
+
+void AudioSpectrogram::loadComplexFrame(const float *samples, int sampleOffset,
+                                        int sampleNum, int start,
+                                        fftwf_complex *dst) {
+  int nfft = m_config.nfft;
+  const float *window = m_window.data();
+  const float *frame = samples + (start - sampleOffset);
+  int validNum = std::min(nfft, sampleNum - start);
+
+  // Apply the window in the same pass that loads the frame.
+#pragma omp simd
+  for (int i = 0; i < validNum; i++) {
+    dst[i][0] = frame[i] * window[i];
+    dst[i][1] = 0;
+  }
+
+  // Pad the partial frame.
+  for (int i = validNum; i < nfft; i++) {
+    float sample = 0;
+    if (m_config.padding == PaddingMode::Reflect) {
+      sample = samples[reflectIndex(start + i, sampleNum) - sampleOffset];
+    }
+    dst[i][0] = sample * window[i];
+    dst[i][1] = 0;
+  }
+}
+
+int AudioSpectrogram::getChunkFrameNum(const STFTConfig &config) {
+  int binNum = config.mode == SpectrogramMode::RealToComplex
+                   ? config.nfft / 2 + 1
+                   : config.nfft;
+  // Bytes of input and output touched by one frame.
+  int frameBytes =
+      config.hopSize * sizeof(float) + binNum * sizeof(fftwf_complex);
+  return std::max(1, SPECTROGRAM_CHUNK_BYTES / frameBytes);
+}
+
+int AudioSpectrogram::getThreadNum() {
+#ifdef _OPENMP
+  return m_config.threadNum > 0 ? m_config.threadNum : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+fftwf_complex *AudioSpectrogram::getChunkOutput(int channel, int firstFrame,
+                                                fftwf_complex *chunkBuffer) {
+  if (m_config.format != SpectrogramFormat::Complex32) {
+    return chunkBuffer;
+  }
+  return m_rawSpectrograms[channel]->getRawSpectrogram() +
+         (size_t)m_binNum * (firstFrame - m_firstFrame);
+}
+
+void AudioSpectrogram::storeChunk(int channel, int firstFrame, int lastFrame,
+                                  const fftwf_complex *bins) {
+  if (m_config.format == SpectrogramFormat::Complex32) {
+    return;
+  }
+
+  CompactSpectrogram &spectrogram = *m_compactSpectrograms[channel];
+  size_t offset = (size_t)m_binNum * (firstFrame - m_firstFrame);
+  int binNum = m_binNum * (lastFrame - firstFrame);
+
+  switch (m_config.format) {
+  case SpectrogramFormat::Magnitude32: {
+    float *dst = spectrogram.getMagnitudes() + offset;
+#pragma omp simd
+    for (int i = 0; i < binNum; i++) {
+      dst[i] = std::sqrt(bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1]);
+    }
+    break;
+  }
+  case SpectrogramFormat::Magnitude16: {
+    uint16_t *dst = spectrogram.getHalfMagnitudes() + offset;
+#pragma omp simd
+    for (int i = 0; i < binNum; i++) {
+      dst[i] = floatToHalf(
+          std::sqrt(bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1]));
     }
+    break;
   }
+  default: {
+    uint8_t *dst = spectrogram.getDecibels() + offset;
+    // 10 * log10(power) = 10 * log10(2) * log2(power), then map the dB range
+    // to [0, 255].
+    float scale = 255.f / (m_config.maxDecibels - m_config.minDecibels);
+    float logScale = 3.01029996f * scale;
+    float bias = (m_decibelOffset - m_config.minDecibels) * scale + 0.5f;
+#pragma omp simd
+    for (int i = 0; i < binNum; i++) {
+      // Offset silence instead of clamping it, a select here keeps the loop
+      // from vectorizing.
+      float power =
+          bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1] + 1e-30f;
+      float level = fastLog2(power) * logScale + bias;
+      level = level > 0.f ? level : 0.f;
+      level = level < 255.f ? level : 255.f;
+      dst[i] = (uint8_t)level;
+    }
+    break;
+  }
+  }
+}
+
+void AudioSpectrogram::generateComplexSpectrogram() {
+  int channelNum = m_audioSource->getNumChannels();
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
 
-  // Convert the input data into the raw spectrogram.
-  for (int channel = 0; channel < channelNum; channel++) {
-    for (int frame = 0; frame < m_spectrogramLength; frame++) {
-      // Offset the frame number to get the input and output fftw complex
-      // pointer.
-      fftwf_complex *in = inputs[channel] + m_nfft * frame;
-      fftwf_complex *out =
-          m_rawSpectrograms[channel]->getRawSpectrogram() + m_nfft * frame;
+  // Split the frames of all channels into cache sized chunks.
+  int chunkFrameNum = getChunkFrameNum(m_config);
+  int chunkNum = (m_spectrogramLength + chunkFrameNum - 1) / chunkFrameNum;
+  int taskNum = channelNum * chunkNum;
 
-      // Start the fftw plan.
-      fftwf_plan p =
-          fftwf_plan_dft_1d(m_nfft, in, out, FFTW_FORWARD, FFTW_MEASURE);
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
 
-      // Execute the plan.
-      fftwf_execute(p);
+#pragma omp parallel num_threads(getThreadNum())
+  {
+    // One frame of complex input for each thread.
+    fftwf_complex *in = fftwf_alloc_complex(m_config.nfft);
+    // The bins of a chunk before they are converted to a compact format.
+    fftwf_complex *chunkBins =
+        m_config.format == SpectrogramFormat::Complex32
+            ? nullptr
+            : fftwf_alloc_complex((size_t)m_binNum * chunkFrameNum);
+    // The samples of a chunk when the source is not resident.
+    std::vector<float> sampleBuffer;
+    fftwf_plan plan = nullptr;
+    int planAlignment = -1;
 
-      // Destroy the plan.
-      fftwf_destroy_plan(p);
+#pragma omp for schedule(dynamic)
+    for (int task = 0; task < taskNum; task++) {
+      int channel = task / chunkNum;
+      int firstFrame = m_firstFrame + (task % chunkNum) * chunkFrameNum;
+      int lastFrame = std::min(firstFrame + chunkFrameNum,
+                               m_firstFrame + m_spectrogramLength);
+      int sampleOffset;
+      const float *samples = loadChunkSamples(
+          channel, firstFrame, lastFrame, sampleBuffer, sampleOffset);
+
+      fftwf_complex *chunkOut = getChunkOutput(channel, firstFrame, chunkBins);
+      for (int frame = firstFrame; frame < lastFrame; frame++) {
+        // Offset the frame number to get the output fftw complex pointer.
+        fftwf_complex *out =
+            chunkOut + (size_t)m_binNum * (frame - firstFrame);
+
+        loadComplexFrame(samples, sampleOffset, sampleNum,
+                         frame * m_config.hopSize, in);
+
+        // Only look up the cached plan again when the frame alignment
+        // changes.
+        if (fftwf_alignment_of((float *)out) != planAlignment) {
+          planAlignment = fftwf_alignment_of((float *)out);
+          plan = planCache->getComplexPlan(m_config.nfft, FFTW_FORWARD, in,
+                                           out, FFTWisdom::getPlannerFlags());
+        }
+
+        // Execute the cached plan on the frame.
+        fftwf_execute_dft(plan, in, out);
+      }
+      storeChunk(channel, firstFrame, lastFrame, chunkOut);
+    }
+
+    fftwf_free(in);
+    fftwf_free(chunkBins);
+  }
+}
+
+void AudioSpectrogram::transformRealChunk(const float *samples,
+                                          int sampleOffset, int sampleNum,
+                                          int firstFrame, int lastFrame,
+                                          float *chunkBuffer,
+                                          fftwf_complex *out) {
+  int frameNum = lastFrame - firstFrame;
+  int lastStart = (lastFrame - 1) * m_config.hopSize;
+
+  // Overlapping rectangular frames are read straight from the samples, one
+  // hop apart. Everything else is loaded into the chunk buffer first. r2c
+  // plans preserve the input, the cast never leads to a write.
+  float *in = const_cast<float *>(samples) +
+              ((size_t)firstFrame * m_config.hopSize - sampleOffset);
+  int inDistance = m_config.hopSize;
+  if (!isDirectFrame(lastStart, sampleNum)) {
+    for (int frame = firstFrame; frame < lastFrame; frame++) {
+      loadFrame(samples, sampleOffset, sampleNum, frame * m_config.hopSize,
+                chunkBuffer + (size_t)(frame - firstFrame) * m_config.nfft);
+    }
+    in = chunkBuffer;
+    inDistance = m_config.nfft;
+  }
+
+  fftwf_plan plan = FFTPlanCache::getSingleton().lock()->getRealToComplexManyPlan(
+      m_config.nfft, frameNum, in, inDistance, out, m_binNum,
+      FFTWisdom::getPlannerFlags());
+
+  // Transform the whole chunk with one call.
+  fftwf_execute_dft_r2c(plan, in, out);
+}
+
+void AudioSpectrogram::generateRealSpectrogram() {
+  int channelNum = m_audioSource->getNumChannels();
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
+
+  // Split the frames of all channels into cache sized chunks.
+  int chunkFrameNum = getChunkFrameNum(m_config);
+  int chunkNum = (m_spectrogramLength + chunkFrameNum - 1) / chunkFrameNum;
+  int taskNum = channelNum * chunkNum;
+
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+
+  bool batched = m_config.execution == SpectrogramExecution::Batched;
+
+#pragma omp parallel num_threads(getThreadNum())
+  {
+    // One frame of windowed or padded input for each thread, or one chunk
+    // when the frames are batched.
+    float *frameBuffer =
+        fftwf_alloc_real((size_t)m_config.nfft * (batched ? chunkFrameNum : 1));
+    // The bins of a chunk before they are converted to a compact format.
+    fftwf_complex *chunkBins =
+        m_config.format == SpectrogramFormat::Complex32
+            ? nullptr
+            : fftwf_alloc_complex((size_t)m_binNum * chunkFrameNum);
+    // The samples of a chunk when the source is not resident.
+    std::vector<float> sampleBuffer;
+    fftwf_plan plan = nullptr;
+    int planInAlignment = -1;
+    int planOutAlignment = -1;
+
+#pragma omp for schedule(dynamic)
+    for (int task = 0; task < taskNum; task++) {
+      int channel = task / chunkNum;
+      int firstFrame = m_firstFrame + (task % chunkNum) * chunkFrameNum;
+      int lastFrame = std::min(firstFrame + chunkFrameNum,
+                               m_firstFrame + m_spectrogramLength);
+      int sampleOffset;
+      const float *samples = loadChunkSamples(
+          channel, firstFrame, lastFrame, sampleBuffer, sampleOffset);
+
+      fftwf_complex *chunkOut = getChunkOutput(channel, firstFrame, chunkBins);
+      if (batched) {
+        transformRealChunk(samples, sampleOffset, sampleNum, firstFrame,
+                           lastFrame, frameBuffer, chunkOut);
+        storeChunk(channel, firstFrame, lastFrame, chunkOut);
+        continue;
+      }
+
+      for (int frame = firstFrame; frame < lastFrame; frame++) {
+        int start = frame * m_config.hopSize;
+        fftwf_complex *out =
+            chunkOut + (size_t)m_binNum * (frame - firstFrame);
+
+        // Transform whole rectangular frames in place, r2c plans preserve the
+        // input.
+        float *in = const_cast<float *>(samples) + (start - sampleOffset);
+        if (!isDirectFrame(start, sampleNum)) {
+          loadFrame(samples, sampleOffset, sampleNum, start, frameBuffer);
+          in = frameBuffer;
+        }
+
+        // Only look up the cached plan again when the frame alignment
+        // changes.
+        if (fftwf_alignment_of(in) != planInAlignment ||
+            fftwf_alignment_of((float *)out) != planOutAlignment) {
+          planInAlignment = fftwf_alignment_of(in);
+          planOutAlignment = fftwf_alignment_of((float *)out);
+          plan = planCache->getRealToComplexPlan(m_config.nfft, in, out,
+                                                 FFTWisdom::getPlannerFlags());
+        }
+
+        // Execute the cached plan on the frame.
+        fftwf_execute_dft_r2c(plan, in, out);
+      }
+      storeChunk(channel, firstFrame, lastFrame, chunkOut);
+    }
+
+    fftwf_free(frameBuffer);
+    fftwf_free(chunkBins);
+  }
+}
+
+void AudioSpectrogram::overlapAddChunk(int channel, int firstFrame,
+                                       int lastFrame, fftwf_complex *bins,
+                                       float *frame, float *dst) {
+  int nfft = m_config.nfft;
+  // Only the non-redundant bins are inverse transformed, the complex mode
+  // spectrogram of real samples is symmetric.
+  int halfBinNum = nfft / 2 + 1;
+  const float *window = m_window.data();
+  fftwf_plan plan = FFTPlanCache::getSingleton().lock()->getComplexToRealPlan(
+      nfft, bins, frame, FFTWisdom::getPlannerFlags());
+
+  const fftwf_complex *frameBins =
+      m_rawSpectrograms[channel]->getRawSpectrogram() +
+      (size_t)m_binNum * firstFrame;
+  for (int i = firstFrame; i < lastFrame; i++) {
+    // c2r plans overwrite the input, transform a copy of the bins.
+    std::copy_n(&frameBins[0][0], 2 * halfBinNum, &bins[0][0]);
+    fftwf_execute_dft_c2r(plan, bins, frame);
+    frameBins += m_binNum;
+
+    float *frameDst = dst + (size_t)(i - firstFrame) * m_config.hopSize;
+#pragma omp simd
+    for (int j = 0; j < nfft; j++) {
+      frameDst[j] += frame[j] * window[j];
+    }
+  }
+}
+
+/**
+ * @brief Get the summed squared window of the frames covering a sample.
+ *
+ * @param window
+ * @param hopSize
+ * @param frameNum the number of frames.
+ * @param sample the sample relative to the start of the first frame.
+ * @return float
+ */
+static float getOverlapPower(const std::vector<float> &window, int hopSize,
+                             int frameNum, int sample) {
+  int nfft = window.size();
+  int firstFrame = sample < nfft ? 0 : (sample - nfft) / hopSize + 1;
+  int lastFrame = std::min(frameNum - 1, sample / hopSize);
+  float power = 0;
+  for (int frame = firstFrame; frame <= lastFrame; frame++) {
+    float coefficient = window[sample - frame * hopSize];
+    power += coefficient * coefficient;
+  }
+  return power;
+}
+
+std::shared_ptr<AudioFile<float>> AudioSpectrogram::generateISTFT() {
+  if (!m_audioSource || m_config.format != SpectrogramFormat::Complex32) {
+    throw std::invalid_argument("ISTFT needs a complex spectrogram.");
+  }
+
+  int nfft = m_config.nfft;
+  int hopSize = m_config.hopSize;
+  int channelNum = m_rawSpectrograms.size();
+  int frameNum = m_spectrogramLength;
+  // The samples under the frames, without the padding past the source.
+  int sampleNum = 0;
+  if (frameNum > 0) {
+    sampleNum = std::min((frameNum - 1) * hopSize + nfft,
+                         m_audioSource->getNumSamplesPerChannel() -
+                             m_firstFrame * hopSize);
+  }
+
+  std::shared_ptr<AudioFile<float>> audioFile =
+      std::make_shared<AudioFile<float>>();
+  audioFile->setSampleRate(getAudioSampleRate());
+  audioFile->setAudioBufferSize(channelNum, std::max(0, sampleNum));
+  if (sampleNum <= 0) {
+    return audioFile;
+  }
+
+  // Split the frames into chunks long enough that a chunk only overlaps the
+  // next one.
+  int chunkFrameNum =
+      std::max(getChunkFrameNum(m_config), (nfft + hopSize - 1) / hopSize);
+  int chunkNum = (frameNum + chunkFrameNum - 1) / chunkFrameNum;
+  int taskNum = channelNum * chunkNum;
+  int chunkSampleNum = chunkFrameNum * hopSize;
+  // The samples a chunk adds to the next chunk.
+  int seamNum = std::max(0, nfft - hopSize);
+  std::vector<float> seams((size_t)taskNum * seamNum);
+
+  // Samples covered by every frame overlapping them share the summed squared
+  // window of their offset in the hop. The scale also undoes the nfft gain of
+  // the unnormalized fftw transforms.
+  int interiorStart = seamNum;
+  int interiorEnd = std::min(sampleNum, frameNum * hopSize);
+  std::vector<float> hopScale(hopSize);
+  for (int i = 0; i < hopSize; i++) {
+    float power = 0;
+    for (int j = i; j < nfft; j += hopSize) {
+      power += m_window[j] * m_window[j];
+    }
+    hopScale[i] =
+        power > SPECTROGRAM_ISTFT_MIN_POWER ? 1.f / (nfft * power) : 0.f;
+  }
+
+#pragma omp parallel num_threads(getThreadNum())
+  {
+    // One frame of bins and samples, and the overlap-added samples of a
+    // chunk for each thread.
+    fftwf_complex *bins = fftwf_alloc_complex(nfft / 2 + 1);
+    float *frame = fftwf_alloc_real(nfft);
+    std::vector<float> block((size_t)chunkSampleNum + seamNum);
+
+    // Sum the frames of each chunk, the samples overlapping the next chunk
+    // are kept as its seam.
+#pragma omp for schedule(dynamic)
+    for (int task = 0; task < taskNum; task++) {
+      int channel = task / chunkNum;
+      int chunk = task % chunkNum;
+      int firstFrame = chunk * chunkFrameNum;
+      int lastFrame = std::min(firstFrame + chunkFrameNum, frameNum);
+      int start = firstFrame * hopSize;
+      if (start >= sampleNum) {
+        continue;
+      }
+
+      std::fill(block.begin(), block.end(), 0.f);
+      overlapAddChunk(channel, firstFrame, lastFrame, bins, frame,
+                      block.data());
+
+      bool lastChunk = chunk == chunkNum - 1;
+      int blockNum = lastChunk ? (int)block.size() : chunkSampleNum;
+      std::copy_n(block.data(), std::min(blockNum, sampleNum - start),
+                  audioFile->samples[channel].data() + start);
+      if (!lastChunk) {
+        std::copy_n(block.data() + chunkSampleNum, seamNum,
+                    seams.data() + (size_t)task * seamNum);
+      }
+    }
+
+    // Add the seam of the previous chunk and normalize, every chunk only
+    // touches its own samples.
+#pragma omp for schedule(static)
+    for (int task = 0; task < taskNum; task++) {
+      int channel = task / chunkNum;
+      int chunk = task % chunkNum;
+      int start = chunk * chunkSampleNum;
+      int end = chunk == chunkNum - 1
+                    ? sampleNum
+                    : std::min(start + chunkSampleNum, sampleNum);
+      float *samples = audioFile->samples[channel].data();
+
+      if (chunk > 0) {
+        const float *seam = seams.data() + (size_t)(task - 1) * seamNum;
+        int seamEnd = std::min(start + seamNum, end);
+#pragma omp simd
+        for (int i = start; i < seamEnd; i++) {
+          samples[i] += seam[i - start];
+        }
+      }
+
+      for (int i = start; i < end;) {
+        if (i < interiorStart || i >= interiorEnd) {
+          // The first and last samples are covered by fewer frames.
+          float power = getOverlapPower(m_window, hopSize, frameNum, i);
+          samples[i] = power > SPECTROGRAM_ISTFT_MIN_POWER
+                           ? samples[i] / (nfft * power)
+                           : 0.f;
+          i++;
+          continue;
+        }
+        // Scale the interior one hop at a time.
+        int offset = i % hopSize;
+        int hopEnd = std::min({end, interiorEnd, i - offset + hopSize});
+        const float *scale = hopScale.data() + offset;
+        float *hopSamples = samples + i;
+        int count = hopEnd - i;
+#pragma omp simd
+        for (int j = 0; j < count; j++) {
+          hopSamples[j] *= scale[j];
+        }
+        i = hopEnd;
+      }
+    }
+
+    fftwf_free(bins);
+    fftwf_free(frame);
+  }
+
+  return audioFile;
+}
+
+void AudioSpectrogram::generateSpectrogram(
+    std::shared_ptr<AudioFile<float>> audioFile, int nfft,
+    SpectrogramMode mode) {
+  generateSpectrogram(std::make_shared<MemoryAudioSource>(audioFile), nfft,
+                      mode);
+}
+
+void AudioSpectrogram::generateSpectrogram(
+    std::shared_ptr<AudioSource> audioSource, int nfft, SpectrogramMode mode) {
+  STFTConfig config;
+  config.nfft = nfft;
+  config.hopSize = nfft;
+  config.window = WindowFunction::Rectangular;
+  config.padding = PaddingMode::Drop;
+  config.mode = mode;
+  generateSTFT(audioSource, config);
+}
+
+void AudioSpectrogram::generateSTFT(std::shared_ptr<AudioFile<float>> audioFile,
+                                    const STFTConfig &config) {
+  generateSTFT(std::make_shared<MemoryAudioSource>(audioFile), config);
+}
+
+void AudioSpectrogram::generateSTFT(std::shared_ptr<AudioSource> audioSource,
+                                    const STFTConfig &config) {
+  generateSTFT(audioSource, config, 0, INT_MAX);
+}
+
+void AudioSpectrogram::generateSTFT(std::shared_ptr<AudioSource> audioSource,
+                                    const STFTConfig &config, int firstFrame,
+                                    int frameNum) {
+  if (firstFrame < 0 || frameNum < 0) {
+    throw std::invalid_argument("STFT frame range must not be negative.");
+  }
+  if (config.nfft <= 0 || config.hopSize <= 0) {
+    throw std::invalid_argument("STFT nfft and hop size must be positive.");
+  }
+  if (config.format == SpectrogramFormat::Decibel8 &&
+      !(config.minDecibels < config.maxDecibels)) {
+    throw std::invalid_argument("STFT dB range must not be empty.");
+  }
+
+  // Set the audio source and STFT parameters.
+  m_audioSource = audioSource;
+  m_config = config;
+  m_binNum = m_config.mode == SpectrogramMode::RealToComplex
+                 ? m_config.nfft / 2 + 1
+                 : m_config.nfft;
+  // Clamp the range to the frames of the source.
+  int totalFrameNum =
+      getFrameNum(m_config, m_audioSource->getNumSamplesPerChannel());
+  m_firstFrame = std::min(firstFrame, totalFrameNum);
+  m_spectrogramLength = std::min(frameNum, totalFrameNum - m_firstFrame);
+
+  // Precompute the window.
+  m_window = generateWindow(m_config.window, m_config.nfft, m_config.kaiserBeta);
+  // Scale a full scale sine to 0 dB.
+  m_decibelOffset = getFullScaleDecibelOffset(m_window);
+
+  /* ---------------- Generate the spectrogram ---------------- */
+
+  int channelNum = m_audioSource->getNumChannels();
+
+  // Clear the old spectrogram for all channels.
+  m_rawSpectrograms.clear();
+  m_compactSpectrograms.clear();
+  // Init the spectrogram of the format for all channels.
+  for (int i = 0; i < channelNum; i++) {
+    if (m_config.format == SpectrogramFormat::Complex32) {
+      m_rawSpectrograms.push_back(
+          std::make_unique<RawSpectrogram>(m_binNum * m_spectrogramLength));
+    } else {
+      m_compactSpectrograms.push_back(std::make_unique<CompactSpectrogram>(
+          m_config.format, m_binNum * m_spectrogramLength));
     }
   }
 
-  // Free the input array.
-  for (int channel = 0; channel < channelNum; channel++) {
-    fftwf_free(inputs[channel]);
+  if (m_config.mode == SpectrogramMode::RealToComplex) {
+    generateRealSpectrogram();
+  } else {
+    generateComplexSpectrogram();
   }
 }
 
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <AudioFile.h>
 #include <fftw3.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
-#include "core/audio_object/audio_object.h"
+#include "core/audio_source/audio_source.h"
+#include "core/window_function/window_function.h"
 
 namespace hpaslt {
 
@@ -12,14 +18,14 @@ class RawSpectrogram {
 private:
   /**
    * @brief the raw spectrogram of the fft conversion.
-   * The size of this vector should be m_nfft * m_spectrogramLength.
+   * The size of this vector should be m_binNum * m_spectrogramLength.
    *
    */
   fftwf_complex *m_rawSpectrogram;
 
   /**
    * @brief The size of the spectrogram.
-   * The size should be m_nfft * m_spectrogramLength.
+   * The size should be m_binNum * m_spectrogramLength.
    *
    */
   int m_spectrogramSize;
@@ -53,19 +59,219 @@ class RawSpectrogram {
   ~RawSpectrogram();
 };
 
+/**
+ * @brief How the bins of a spectrogram are stored.
+ * Complex32 keeps the fftw output in RawSpectrogram. The other formats only
+ * keep the magnitude in CompactSpectrogram: 32 bit floats, IEEE half floats,
+ * or dB quantized to 8 bits over STFTConfig::minDecibels to maxDecibels.
+ *
+ */
+enum class SpectrogramFormat { Complex32, Magnitude32, Magnitude16, Decibel8 };
+
+/**
+ * @brief Get the number of bytes of one bin in the format.
+ *
+ * @param format
+ * @return size_t
+ */
+inline size_t getSpectrogramFormatBytes(SpectrogramFormat format) {
+  switch (format) {
+  case SpectrogramFormat::Complex32:
+    return sizeof(fftwf_complex);
+  case SpectrogramFormat::Magnitude32:
+    return sizeof(float);
+  case SpectrogramFormat::Magnitude16:
+    return sizeof(uint16_t);
+  default:
+    return sizeof(uint8_t);
+  }
+}
+
+/**
+ * @brief Convert an IEEE half float of SpectrogramFormat::Magnitude16 back to
+ * a float.
+ *
+ * @param half
+ * @return float
+ */
+inline float halfToFloat(uint16_t half) {
+  const uint32_t shiftedExponent = 0x7c00 << 13;
+  uint32_t bits = (uint32_t)(half & 0x7fff) << 13;
+  uint32_t exponent = bits & shiftedExponent;
+  // Rebias the exponent.
+  bits += (127 - 15) << 23;
+  if (exponent == shiftedExponent) {
+    // Inf and NaN.
+    bits += (128 - 16) << 23;
+  } else if (exponent == 0) {
+    // Renormalize the subnormals.
+    bits += 1 << 23;
+    bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) -
+                                   std::bit_cast<float>(113u << 23));
+  }
+  bits |= (uint32_t)(half & 0x8000) << 16;
+  return std::bit_cast<float>(bits);
+}
+
+/**
+ * @brief Convert a bin of SpectrogramFormat::Decibel8 back to dB.
+ *
+ * @param value
+ * @param minDecibels
+ * @param maxDecibels
+ * @return float
+ */
+inline float dequantizeDecibels(uint8_t value, float minDecibels,
+                                float maxDecibels) {
+  return minDecibels + value * ((maxDecibels - minDecibels) / 255.f);
+}
+
+/**
+ * @brief The storage of one channel of a spectrogram in a compact format.
+ * Holds getSpectrogramSize() elements of the format, frame by frame.
+ *
+ */
+class CompactSpectrogram {
+private:
+  SpectrogramFormat m_format;
+
+  /**
+   * @brief The fftw allocated elements, aligned for vectorized stores.
+   *
+   */
+  void *m_data;
+
+  int m_spectrogramSize;
+
+public:
+  /**
+   * @brief Construct a new CompactSpectrogram object.
+   *
+   * @param format any format but SpectrogramFormat::Complex32.
+   * @param size the number of bins.
+   */
+  CompactSpectrogram(SpectrogramFormat format, int size);
+
+  /**
+   * @brief Disable the default copy constructor for CompactSpectrogram.
+   *
+   */
+  CompactSpectrogram(const CompactSpectrogram &) = delete;
+
+  /**
+   * @brief Destroy the CompactSpectrogram object.
+   *
+   */
+  ~CompactSpectrogram();
+
+  SpectrogramFormat getFormat() { return m_format; }
+
+  int getSpectrogramSize() { return m_spectrogramSize; }
+
+  /**
+   * @brief Get the number of bytes of the stored bins.
+   *
+   * @return size_t
+   */
+  size_t getBytes() {
+    return (size_t)m_spectrogramSize * getSpectrogramFormatBytes(m_format);
+  }
+
+  /**
+   * @brief Get the bins of SpectrogramFormat::Magnitude32.
+   *
+   * @return float*
+   */
+  float *getMagnitudes() { return (float *)m_data; }
+
+  /**
+   * @brief Get the bins of SpectrogramFormat::Magnitude16, see halfToFloat.
+   *
+   * @return uint16_t*
+   */
+  uint16_t *getHalfMagnitudes() { return (uint16_t *)m_data; }
+
+  /**
+   * @brief Get the bins of SpectrogramFormat::Decibel8, see
+   * dequantizeDecibels.
+   *
+   * @return uint8_t*
+   */
+  uint8_t *getDecibels() { return (uint8_t *)m_data; }
+};
+
+/**
+ * @brief How the spectrogram frames are transformed.
+ * Complex runs a full complex dft and keeps all nfft bins. RealToComplex reads
+ * the samples directly and keeps only the nfft / 2 + 1 non-redundant bins.
+ *
+ */
+enum class SpectrogramMode { Complex, RealToComplex };
+
+/**
+ * @brief How the frames are handed to fftw.
+ * PerFrame executes one transform for each frame. Batched describes a chunk of
+ * frames as one fftw "many" plan so fftw can vectorize across frames. Batched
+ * only applies to SpectrogramMode::RealToComplex, the complex mode always runs
+ * per frame.
+ *
+ */
+enum class SpectrogramExecution { PerFrame, Batched };
+
+/**
+ * @brief How the last partial frame of an STFT is handled.
+ * Drop ignores the samples that do not fill a whole frame. Zero pads the
+ * frame with zeros. Reflect mirrors the samples at the end of the audio.
+ *
+ */
+enum class PaddingMode { Drop, Zero, Reflect };
+
+/**
+ * @class STFTConfig
+ * @brief The parameters of a short time fourier transform.
+ *
+ */
+struct STFTConfig {
+  int nfft = 512;
+  int hopSize = 512;
+  WindowFunction window = WindowFunction::Rectangular;
+  float kaiserBeta = 8.6f;
+  PaddingMode padding = PaddingMode::Drop;
+  SpectrogramMode mode = SpectrogramMode::RealToComplex;
+  SpectrogramExecution execution = SpectrogramExecution::PerFrame;
+  // Number of worker threads, 0 to use all the OpenMP threads.
+  int threadNum = 0;
+  SpectrogramFormat format = SpectrogramFormat::Complex32;
+  // The dB range of SpectrogramFormat::Decibel8, 0 dB is a full scale sine.
+  float minDecibels = -100;
+  float maxDecibels = 0;
+};
+
 class AudioSpectrogram {
 private:
   /**
-   * @brief The audio object shared pointer.
+   * @brief The samples of the current spectrogram.
+   *
+   */
+  std::shared_ptr<AudioSource> m_audioSource;
+
+  /**
+   * @brief The STFT parameters of the current spectrogram.
    *
    */
-  std::shared_ptr<AudioFile<float>> m_audioFile;
+  STFTConfig m_config;
 
   /**
-   * @brief The fft bin size.
+   * @brief The precomputed window coefficients, m_config.nfft in size.
    *
    */
-  int m_nfft;
+  std::vector<float> m_window;
+
+  /**
+   * @brief The number of bins stored for each frame.
+   *
+   */
+  int m_binNum;
 
   /**
    * @brief The length of the spectrogram.
@@ -73,19 +279,208 @@ class AudioSpectrogram {
    */
   int m_spectrogramLength;
 
+  /**
+   * @brief The frame of the source stored as the first frame.
+   *
+   */
+  int m_firstFrame;
+
+  /**
+   * @brief Added to the power in dB so a full scale sine is 0 dB.
+   *
+   */
+  float m_decibelOffset;
+
   /**
    * @brief the raw spectrogram of all channels.
    *
    */
   std::vector<std::unique_ptr<RawSpectrogram>> m_rawSpectrograms;
 
+  /**
+   * @brief the compact spectrogram of all channels, empty for
+   * SpectrogramFormat::Complex32.
+   *
+   */
+  std::vector<std::unique_ptr<CompactSpectrogram>> m_compactSpectrograms;
+
+  /**
+   * @brief Get the number of worker threads for the current config.
+   *
+   * @return int
+   */
+  int getThreadNum();
+
+  /**
+   * @brief Check if a frame can be transformed directly on the samples.
+   * True when the window is rectangular and the frame needs no padding.
+   *
+   * @param start the first sample of the frame.
+   * @param sampleNum the number of samples per channel.
+   * @return bool
+   */
+  bool isDirectFrame(int start, int sampleNum) {
+    return m_config.window == WindowFunction::Rectangular &&
+           start + m_config.nfft <= sampleNum;
+  }
+
+  /**
+   * @brief Get the samples a chunk of frames reads, including the samples
+   * reflect padding mirrors.
+   * Points into the source when the channel is resident in memory, otherwise
+   * reads the range into the buffer.
+   *
+   * @param channel
+   * @param firstFrame the first frame of the chunk.
+   * @param lastFrame one past the last frame of the chunk.
+   * @param buffer resized to hold the range if it has to be read.
+   * @param sampleOffset set to the index of the first returned sample.
+   * @return const float*
+   */
+  const float *loadChunkSamples(int channel, int firstFrame, int lastFrame,
+                                std::vector<float> &buffer, int &sampleOffset);
+
+  /**
+   * @brief Get where a chunk of frames is transformed to.
+   * The raw spectrogram for SpectrogramFormat::Complex32, otherwise the
+   * chunk buffer converted by storeChunk.
+   *
+   * @param channel
+   * @param firstFrame the first frame of the chunk.
+   * @param chunkBuffer space for the bins of a chunk.
+   * @return fftwf_complex*
+   */
+  fftwf_complex *getChunkOutput(int channel, int firstFrame,
+                                fftwf_complex *chunkBuffer);
+
+  /**
+   * @brief Convert a transformed chunk into the compact spectrogram in one
+   * vectorized pass. Does nothing for SpectrogramFormat::Complex32.
+   *
+   * @param channel
+   * @param firstFrame the first frame of the chunk.
+   * @param lastFrame one past the last frame of the chunk.
+   * @param bins the bins returned by getChunkOutput.
+   */
+  void storeChunk(int channel, int firstFrame, int lastFrame,
+                  const fftwf_complex *bins);
+
+  /**
+   * @brief Load one frame of samples multiplied by the window.
+   * Samples past the end are filled according to the padding mode.
+   *
+   * @param samples the samples of one channel, starting at sampleOffset.
+   * @param sampleOffset the index of the first sample in samples.
+   * @param sampleNum the number of samples per channel.
+   * @param start the first sample of the frame.
+   * @param dst nfft real numbers.
+   */
+  void loadFrame(const float *samples, int sampleOffset, int sampleNum,
+                 int start, float *dst);
+
+  /**
+   * @brief Load one frame of samples multiplied by the window as the real part
+   * of complex numbers.
+   *
+   * @param samples the samples of one channel, starting at sampleOffset.
+   * @param sampleOffset the index of the first sample in samples.
+   * @param sampleNum the number of samples per channel.
+   * @param start the first sample of the frame.
+   * @param dst nfft complex numbers.
+   */
+  void loadComplexFrame(const float *samples, int sampleOffset, int sampleNum,
+                        int start, fftwf_complex *dst);
+
+  /**
+   * @brief Run one batched real to complex dft on a chunk of frames.
+   *
+   * @param samples the samples of the channel, starting at sampleOffset.
+   * @param sampleOffset the index of the first sample in samples.
+   * @param sampleNum the number of samples per channel.
+   * @param firstFrame the first frame of the chunk.
+   * @param lastFrame one past the last frame of the chunk.
+   * @param chunkBuffer space for nfft real numbers per frame of the chunk.
+   * @param out the bins of the chunk.
+   */
+  void transformRealChunk(const float *samples, int sampleOffset,
+                          int sampleNum, int firstFrame, int lastFrame,
+                          float *chunkBuffer, fftwf_complex *out);
+
+  /**
+   * @brief Inverse transform a chunk of frames and overlap-add them.
+   * The frames are windowed again before they are summed, the sum is not
+   * normalized.
+   *
+   * @param channel
+   * @param firstFrame the first frame of the chunk, relative to m_firstFrame.
+   * @param lastFrame one past the last frame of the chunk.
+   * @param bins space for nfft / 2 + 1 complex numbers.
+   * @param frame space for nfft real numbers.
+   * @param dst the samples from the start of the first frame, zeroed.
+   */
+  void overlapAddChunk(int channel, int firstFrame, int lastFrame,
+                       fftwf_complex *bins, float *frame, float *dst);
+
+  /**
+   * @brief Load the frames into complex arrays and run complex dft.
+   * Frames of all channels are split into chunks transformed in parallel,
+   * every thread has its own scratch frame and shares the cached plan.
+   *
+   */
+  void generateComplexSpectrogram();
+
+  /**
+   * @brief Run real to complex dft on the frames.
+   * Frames that need no windowing or padding are transformed directly on the
+   * samples without a copy. Parallelized the same way as the complex path.
+   *
+   */
+  void generateRealSpectrogram();
+
 public:
   /**
    * @brief Get the fft bin size of the spectrogram.
    *
    * @return int
    */
-  int getNfft() { return m_nfft; }
+  int getNfft() { return m_config.nfft; }
+
+  /**
+   * @brief Get the number of samples between two frames.
+   *
+   * @return int
+   */
+  int getHopSize() { return m_config.hopSize; }
+
+  /**
+   * @brief Get the STFT parameters of the spectrogram.
+   *
+   * @return const STFTConfig&
+   */
+  const STFTConfig &getConfig() { return m_config; }
+
+  /**
+   * @brief Get the precomputed window coefficients.
+   *
+   * @return const std::vector<float>&
+   */
+  const std::vector<float> &getWindow() { return m_window; }
+
+  /**
+   * @brief Get the transform mode of the spectrogram.
+   *
+   * @return SpectrogramMode
+   */
+  SpectrogramMode getMode() { return m_config.mode; }
+
+  /**
+   * @brief Get the number of bins stored for each frame.
+   * nfft for SpectrogramMode::Complex, nfft / 2 + 1 for
+   * SpectrogramMode::RealToComplex.
+   *
+   * @return int
+   */
+  int getBinNum() { return m_binNum; }
 
   /**
    * @brief Get the frame number of the spectrogram.
@@ -94,25 +489,36 @@ class AudioSpectrogram {
    */
   int getSpectrogramLength() { return m_spectrogramLength; }
 
+  /**
+   * @brief Get the frame of the source the spectrogram starts at.
+   * Frame i of the spectrogram starts at sample (getFirstFrame() + i) *
+   * hopSize.
+   *
+   * @return int
+   */
+  int getFirstFrame() { return m_firstFrame; }
+
   /**
    * @brief Get the original audio object sample rate.
    *
    * @return int
    */
-  int getAudioSampleRate() { return m_audioFile->getSampleRate(); }
+  int getAudioSampleRate() { return m_audioSource->getSampleRate(); }
 
   /**
    * @brief Get the sample rate of the spectrogram.
-   * The spectrogram sample rate should be original audio sample rate / nfft.
+   * The spectrogram sample rate should be original audio sample rate / hop
+   * size.
    *
    * @return int
    */
   float getSpectrogramSampleRate() {
-    return (float)getAudioSampleRate() / (float)m_nfft;
+    return (float)getAudioSampleRate() / (float)m_config.hopSize;
   }
 
   /**
    * @brief Get the reference to the raw spectrogram reference.
+   * Empty unless the format is SpectrogramFormat::Complex32.
    *
    * @return std::vector<RawSpectrogram>&
    */
@@ -120,11 +526,41 @@ class AudioSpectrogram {
     return m_rawSpectrograms;
   }
 
+  /**
+   * @brief Get the storage format of the spectrogram.
+   *
+   * @return SpectrogramFormat
+   */
+  SpectrogramFormat getFormat() { return m_config.format; }
+
+  /**
+   * @brief Get the compact spectrogram of all channels.
+   * Empty for SpectrogramFormat::Complex32.
+   *
+   * @return std::vector<std::unique_ptr<CompactSpectrogram>>&
+   */
+  std::vector<std::unique_ptr<CompactSpectrogram>> &getCompactSpectrogram() {
+    return m_compactSpectrograms;
+  }
+
+  /**
+   * @brief Get the number of bytes of the stored bins of all channels.
+   *
+   * @return size_t
+   */
+  size_t getSpectrogramBytes() {
+    return (size_t)m_binNum * m_spectrogramLength *
+           getSpectrogramFormatBytes(m_config.format) *
+           std::max(m_rawSpectrograms.size(), m_compactSpectrograms.size());
+  }
+
   /**
    * @brief Construct a new AudioSpectrogram object.
    *
    */
-  AudioSpectrogram() {}
+  AudioSpectrogram()
+      : m_binNum(0), m_spectrogramLength(0), m_firstFrame(0),
+        m_decibelOffset(0) {}
 
   /**
    * @brief Destroy the AudioSpectrogram object.
@@ -133,15 +569,109 @@ class AudioSpectrogram {
   ~AudioSpectrogram() {}
 
   /**
-   * @brief Generate a new spectrogram with the audio object and fft bin size.
+   * @brief Get the number of frames of an STFT.
+   *
+   * @param config the STFT parameters.
+   * @param sampleNum the number of samples per channel.
+   * @return int
+   */
+  static int getFrameNum(const STFTConfig &config, int sampleNum);
+
+  /**
+   * @brief Get the number of frames transformed as one parallel task.
+   * A chunk touches about SPECTROGRAM_CHUNK_BYTES of input and output.
+   *
+   * @param config the STFT parameters.
+   * @return int
+   */
+  static int getChunkFrameNum(const STFTConfig &config);
+
+  /**
+   * @brief Create the cached fftw plans generateSpectrogram and generateISTFT
+   * use for nfft, for every alignment a frame can have.
+   * This method is thread safe.
+   *
+   * @param nfft
+   */
+  static void preparePlans(int nfft);
+
+  /**
+   * @brief Create the cached fftw plans generateSTFT uses for the config,
+   * including the batched plans of a full chunk.
+   * This method is thread safe.
    *
-   * @param audioObj
+   * @param config
+   */
+  static void preparePlans(const STFTConfig &config);
+
+  /**
+   * @brief Generate a new spectrogram with the audio source and fft bin size.
+   * Frames do not overlap and are not windowed.
+   *
+   * @param audioSource
    * @param nfft
+   * @param mode the transform mode, decides the number of bins per frame.
+   */
+  void generateSpectrogram(std::shared_ptr<AudioSource> audioSource, int nfft,
+                           SpectrogramMode mode = SpectrogramMode::Complex);
+
+  /**
+   * @brief Generate a new spectrogram of a decoded AudioFile.
+   *
+   * @param audioFile
+   * @param nfft
+   * @param mode the transform mode, decides the number of bins per frame.
    */
   void generateSpectrogram(std::shared_ptr<AudioFile<float>> audioFile,
-                           int nfft);
+                           int nfft,
+                           SpectrogramMode mode = SpectrogramMode::Complex);
 
-  // TODO: Use IFFT to get the original audio from the spectrogram.
+  /**
+   * @brief Generate a new spectrogram with overlapping windowed frames.
+   * Frame i starts at sample i * hopSize.
+   *
+   * @param audioSource
+   * @param config the STFT parameters.
+   */
+  void generateSTFT(std::shared_ptr<AudioSource> audioSource,
+                    const STFTConfig &config);
+
+  /**
+   * @brief Generate the frames [firstFrame, firstFrame + frameNum) of an STFT.
+   * Only the samples under those frames are read, so a view can transform a
+   * slice of a long source. The range is clamped to the frames of the source.
+   *
+   * @param audioSource
+   * @param config the STFT parameters.
+   * @param firstFrame
+   * @param frameNum
+   */
+  void generateSTFT(std::shared_ptr<AudioSource> audioSource,
+                    const STFTConfig &config, int firstFrame, int frameNum);
+
+  /**
+   * @brief Generate a new STFT of a decoded AudioFile.
+   *
+   * @param audioFile
+   * @param config the STFT parameters.
+   */
+  void generateSTFT(std::shared_ptr<AudioFile<float>> audioFile,
+                    const STFTConfig &config);
+
+  /**
+   * @brief Resynthesize the audio of the spectrogram with overlap-add.
+   * Every frame is inverse transformed, windowed again and summed, then each
+   * sample is divided by the summed squared window of the frames covering it.
+   * Sample i of the audio is sample getFirstFrame() * hopSize + i of the
+   * source, padding past the end of the source is dropped. Samples no window
+   * covers are zero. Chunks of frames are summed in parallel and their seams
+   * merged in a fixed order, so the result does not depend on the number of
+   * threads.
+   * Needs SpectrogramFormat::Complex32.
+   *
+   * @return std::shared_ptr<AudioFile<float>>
+   */
+  std::shared_ptr<AudioFile<float>> generateISTFT();
 };
 
 } // namespace hpaslt
@@ -1,8 +1,7 @@
 #include "audio_workspace.h"
 
-#include <thread>
-
 #include "commands/commands.h"
+#include "core/audio_source/progressive_audio_source.h"
 #include "logger/logger.h"
 
 namespace hpaslt {
@@ -12,6 +11,9 @@ std::shared_ptr<AudioWorkspace> AudioWorkspace::s_audioWorkspace = nullptr;
 eventpp::CallbackList<void(std::weak_ptr<AudioObject>)>
     AudioWorkspace::s_onAudioLoaded;
 
+eventpp::CallbackList<void(std::weak_ptr<AudioObject>, float)>
+    AudioWorkspace::s_onAudioProgress;
+
 void AudioWorkspace::registerConosleCommands() {
   // Get the console system.
   std::shared_ptr<csys::System> system =
@@ -66,35 +68,105 @@ AudioWorkspace::AudioWorkspace() {
   // Alloc members.
   m_player = std::make_shared<AudioPlayer>();
   m_audioObject = std::make_shared<AudioObject>();
+  m_jobScheduler = std::make_shared<JobScheduler>();
+  m_loadToken = std::make_shared<CancellationToken>();
 }
 
 AudioWorkspace::~AudioWorkspace() {
+  // Stop the jobs before the objects they work on are freed.
+  {
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    m_loadToken->cancel();
+    if (m_pendingLoadToken) {
+      m_pendingLoadToken->cancel();
+    }
+  }
+  m_jobScheduler = nullptr;
   m_player = nullptr;
   m_audioObject = nullptr;
 }
 
+std::shared_ptr<CancellationToken> AudioWorkspace::getLoadToken() {
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  return m_loadToken;
+}
+
 void AudioWorkspace::loadAudioFile(const std::string &filePath) {
-  // Launch the loading thread.
-  std::thread loadThread([this, filePath]() {
-    try {
-      m_audioObject->loadAudioFile(filePath);
-    } catch (const std::invalid_argument &e) {
-      logger->coreLogger->error(
-          "AudioWorkspace cannot load audio file at {}, error: {}.", filePath,
-          e.what());
-      return;
+  // Drop an older load that has not opened its file yet. The work on the
+  // current file goes on until the new file is opened.
+  std::shared_ptr<CancellationToken> loadToken =
+      std::make_shared<CancellationToken>();
+  {
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    if (m_pendingLoadToken && m_pendingLoadToken != m_loadToken) {
+      m_pendingLoadToken->cancel();
     }
-
-    logger->coreLogger->info("AudioWorkspace loaded audio file {}.", filePath);
-
-    // Bind audio object to the player.
-    m_player->loadAudioObject(m_audioObject);
-
-    // Call the callback list.
-    s_onAudioLoaded(m_audioObject);
-  });
-  logger->coreLogger->debug("Audio loading thread started.");
-  loadThread.detach();
+    m_pendingLoadToken = loadToken;
+  }
+
+  // Launch the loading job.
+  m_jobScheduler->submit(
+      [this, filePath, loadToken](const CancellationToken &token) {
+        {
+          // Only the latest load may replace the audio object.
+          std::lock_guard<std::mutex> lock(m_loadMutex);
+          if (token.isCancelled()) {
+            return;
+          }
+
+          try {
+            m_audioObject->loadAudioFile(filePath, true);
+          } catch (const std::exception &e) {
+            logger->coreLogger->error(
+                "AudioWorkspace cannot load audio file at {}, error: {}.",
+                filePath, e.what());
+            return;
+          }
+
+          logger->coreLogger->info("AudioWorkspace opened audio file {}.",
+                                   filePath);
+
+          // The new source is bound, cancel the work on the previous file.
+          m_loadToken->cancel();
+          m_loadToken = loadToken;
+
+          // Bind audio object to the player.
+          m_player->loadAudioObject(m_audioObject);
+        }
+
+        // Call the callback list.
+        s_onAudioLoaded(m_audioObject);
+
+        // Decode the rest of the audio, the loaded prefix is usable already.
+        std::shared_ptr<ProgressiveAudioSource> progressiveSource =
+            std::dynamic_pointer_cast<ProgressiveAudioSource>(
+                m_audioObject->getAudioSource());
+        if (progressiveSource) {
+          bool loading = true;
+          while (loading) {
+            if (token.isCancelled()) {
+              logger->coreLogger->debug(
+                  "AudioWorkspace loading {} cancelled.", filePath);
+              return;
+            }
+            loading = progressiveSource->loadNextBlock();
+            // An empty file is fully loaded.
+            int sampleNum = progressiveSource->getNumSamplesPerChannel();
+            s_onAudioProgress(
+                m_audioObject,
+                sampleNum > 0
+                    ? (float)progressiveSource->getLoadedSamples() / sampleNum
+                    : 1.f);
+          }
+        } else {
+          s_onAudioProgress(m_audioObject, 1);
+        }
+
+        logger->coreLogger->info("AudioWorkspace loaded audio file {}.",
+                                 filePath);
+      },
+      JobPriority::High, loadToken);
+  logger->coreLogger->debug("Audio loading job submitted.");
 }
 
 } // namespace hpaslt
@@ -4,10 +4,12 @@
 #include <eventpp/callbacklist.h>
 
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "core/audio_object/audio_object.h"
 #include "core/audio_player/audio_player.h"
+#include "core/job_scheduler/job_scheduler.h"
 
 namespace hpaslt {
 
@@ -35,6 +37,33 @@ class AudioWorkspace {
    */
   std::shared_ptr<AudioObject> m_audioObject;
 
+  /**
+   * @brief Background jobs of the workspace.
+   *
+   */
+  std::shared_ptr<JobScheduler> m_jobScheduler;
+
+  /**
+   * @brief Guard the load tokens and serialize the audio loading.
+   *
+   */
+  std::mutex m_loadMutex;
+
+  /**
+   * @brief The cancellation token of all the jobs working on the current
+   * audio file.
+   *
+   */
+  std::shared_ptr<CancellationToken> m_loadToken;
+
+  /**
+   * @brief The token of the latest requested load.
+   * It becomes m_loadToken once the new file is opened, so a file that fails
+   * to open leaves the current one loading.
+   *
+   */
+  std::shared_ptr<CancellationToken> m_pendingLoadToken;
+
 public:
   /**
    * @brief Get the AudioWorkspace singleton.
@@ -63,12 +92,22 @@ class AudioWorkspace {
 
   /**
    * @brief Callback list invoked when audio is loaded successfully.
+   * Invoked once the header is parsed, the samples may still be loading.
    * The function callback list may be executed on another thread.
    *
    */
   static eventpp::CallbackList<void(std::weak_ptr<AudioObject>)>
       s_onAudioLoaded;
 
+  /**
+   * @brief Callback list invoked when more of the audio is loaded.
+   * The second argument is the loaded ratio, 1 when the load is complete.
+   * The function callback list may be executed on another thread.
+   *
+   */
+  static eventpp::CallbackList<void(std::weak_ptr<AudioObject>, float)>
+      s_onAudioProgress;
+
   /**
    * @brief Construct a new AudioWorkspace object.
    *
@@ -87,8 +126,28 @@ class AudioWorkspace {
    */
   std::weak_ptr<AudioPlayer> getAudioPlayer() { return m_player; }
 
+  /**
+   * @brief Get the JobScheduler.
+   * Completion callbacks are drained on the UI thread every frame.
+   *
+   * @return std::weak_ptr<JobScheduler>
+   */
+  std::weak_ptr<JobScheduler> getJobScheduler() { return m_jobScheduler; }
+
+  /**
+   * @brief Get the cancellation token of the current audio file.
+   * Jobs working on the audio should use it, so they are cancelled when
+   * another file is loaded.
+   *
+   * @return std::shared_ptr<CancellationToken>
+   */
+  std::shared_ptr<CancellationToken> getLoadToken();
+
   /**
    * @brief Load a .wav audio file into m_audioFile.
+   * The load runs on the JobScheduler and cancels all the jobs of the
+   * previous file once the new file is opened. An older load that has not
+   * opened its file yet is dropped.
    *
    * @param filePath
    */
@@ -0,0 +1,211 @@
+#include "fft_plan_cache.h"
+
+#include <algorithm>
+
+namespace hpaslt {
+
+std::shared_ptr<FFTPlanCache> FFTPlanCache::s_fftPlanCache = nullptr;
+
+fftwf_plan FFTPlanCache::createPlan(const FFTPlanKey &key) {
+  // Number of elements in one transform of the input and output array.
+  int complexNum = key.nfft;
+  int halfComplexNum = key.nfft / 2 + 1;
+  size_t inElementBytes = sizeof(fftwf_complex);
+  size_t outElementBytes = sizeof(fftwf_complex);
+  int inNum = complexNum;
+  int outNum = complexNum;
+  if (key.type == FFTPlanType::RealToComplex) {
+    inElementBytes = sizeof(float);
+    inNum = key.inPlace ? 2 * halfComplexNum : key.nfft;
+    outNum = halfComplexNum;
+  } else if (key.type == FFTPlanType::ComplexToReal) {
+    outElementBytes = sizeof(float);
+    inNum = halfComplexNum;
+    outNum = key.inPlace ? 2 * halfComplexNum : key.nfft;
+  } else if (key.type == FFTPlanType::DCT2) {
+    inElementBytes = sizeof(float);
+    outElementBytes = sizeof(float);
+  }
+
+  // Number of bytes used by all the transforms of the input and output array.
+  size_t inBytes =
+      ((size_t)(key.howmany - 1) * key.inDistance + inNum) * inElementBytes;
+  size_t outBytes =
+      ((size_t)(key.howmany - 1) * key.outDistance + outNum) * outElementBytes;
+  if (key.inPlace) {
+    inBytes = std::max(inBytes, outBytes);
+  }
+
+  // Allocate scratch buffers with the same alignment as the target arrays.
+  // The planner may overwrite the arrays, so the real data is never used.
+  char *inScratch = (char *)fftwf_malloc(inBytes + 64);
+  char *outScratch =
+      key.inPlace ? inScratch : (char *)fftwf_malloc(outBytes + 64);
+  char *in = inScratch + key.inAlignment;
+  char *out = key.inPlace ? in : outScratch + key.outAlignment;
+
+  fftwf_plan plan = nullptr;
+  switch (key.type) {
+  case FFTPlanType::Complex:
+    plan = fftwf_plan_many_dft(1, &key.nfft, key.howmany, (fftwf_complex *)in,
+                               nullptr, 1, key.inDistance,
+                               (fftwf_complex *)out, nullptr, 1,
+                               key.outDistance, key.sign, key.flags);
+    break;
+  case FFTPlanType::RealToComplex:
+    plan = fftwf_plan_many_dft_r2c(1, &key.nfft, key.howmany, (float *)in,
+                                   nullptr, 1, key.inDistance,
+                                   (fftwf_complex *)out, nullptr, 1,
+                                   key.outDistance, key.flags);
+    break;
+  case FFTPlanType::ComplexToReal:
+    plan = fftwf_plan_many_dft_c2r(1, &key.nfft, key.howmany,
+                                   (fftwf_complex *)in, nullptr, 1,
+                                   key.inDistance, (float *)out, nullptr, 1,
+                                   key.outDistance, key.flags);
+    break;
+  case FFTPlanType::DCT2: {
+    fftwf_r2r_kind kind = FFTW_REDFT10;
+    plan = fftwf_plan_many_r2r(1, &key.nfft, key.howmany, (float *)in,
+                               nullptr, 1, key.inDistance, (float *)out,
+                               nullptr, 1, key.outDistance, &kind, key.flags);
+    break;
+  }
+  }
+
+  // Free the scratch buffers.
+  fftwf_free(inScratch);
+  if (!key.inPlace) {
+    fftwf_free(outScratch);
+  }
+
+  return plan;
+}
+
+FFTPlanCache::~FFTPlanCache() { clear(); }
+
+fftwf_plan FFTPlanCache::getPlan(const FFTPlanKey &key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_plans.find(key);
+  if (it != m_plans.end()) {
+    return it->second;
+  }
+
+  fftwf_plan plan = createPlan(key);
+  if (plan) {
+    m_plans[key] = plan;
+  }
+
+  return plan;
+}
+
+fftwf_plan FFTPlanCache::getComplexPlan(int nfft, int sign, fftwf_complex *in,
+                                        fftwf_complex *out, unsigned flags) {
+  FFTPlanKey key{nfft,
+                 sign,
+                 FFTPlanType::Complex,
+                 fftwf_alignment_of((float *)in),
+                 fftwf_alignment_of((float *)out),
+                 in == out,
+                 flags};
+  return getPlan(key);
+}
+
+fftwf_plan FFTPlanCache::getRealToComplexPlan(int nfft, float *in,
+                                              fftwf_complex *out,
+                                              unsigned flags) {
+  FFTPlanKey key{nfft,
+                 FFTW_FORWARD,
+                 FFTPlanType::RealToComplex,
+                 fftwf_alignment_of(in),
+                 fftwf_alignment_of((float *)out),
+                 (void *)in == (void *)out,
+                 flags};
+  return getPlan(key);
+}
+
+fftwf_plan FFTPlanCache::getComplexToRealPlan(int nfft, fftwf_complex *in,
+                                              float *out, unsigned flags) {
+  FFTPlanKey key{nfft,
+                 FFTW_BACKWARD,
+                 FFTPlanType::ComplexToReal,
+                 fftwf_alignment_of((float *)in),
+                 fftwf_alignment_of(out),
+                 (void *)in == (void *)out,
+                 flags};
+  return getPlan(key);
+}
+
+bool FFTPlanCache::importWisdom(const std::string &filePath) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  return fftwf_import_wisdom_from_filename(filePath.c_str());
+}
+
+bool FFTPlanCache::exportWisdom(const std::string &filePath) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  return fftwf_export_wisdom_to_filename(filePath.c_str());
+}
+
+fftwf_plan FFTPlanCache::getRealToComplexManyPlan(int nfft, int howmany,
+                                                  float *in, int inDistance,
+                                                  fftwf_complex *out,
+                                                  int outDistance,
+                                                  unsigned flags) {
+  FFTPlanKey key{nfft,
+                 FFTW_FORWARD,
+                 FFTPlanType::RealToComplex,
+                 fftwf_alignment_of(in),
+                 fftwf_alignment_of((float *)out),
+                 (void *)in == (void *)out,
+                 flags,
+                 howmany,
+                 inDistance,
+                 outDistance};
+  return getPlan(key);
+}
+
+fftwf_plan FFTPlanCache::getDCTManyPlan(int n, int howmany, float *in,
+                                        int inDistance, float *out,
+                                        int outDistance, unsigned flags) {
+  FFTPlanKey key{n,
+                 FFTW_REDFT10,
+                 FFTPlanType::DCT2,
+                 fftwf_alignment_of(in),
+                 fftwf_alignment_of(out),
+                 in == out,
+                 flags,
+                 howmany,
+                 inDistance,
+                 outDistance};
+  return getPlan(key);
+}
+
+int FFTPlanCache::getAlignmentNum() {
+  float *probe = fftwf_alloc_real(64);
+  int alignmentNum = 1;
+  while (alignmentNum < 64 && fftwf_alignment_of(probe + alignmentNum) != 0) {
+    alignmentNum++;
+  }
+  fftwf_free(probe);
+  return alignmentNum;
+}
+
+int FFTPlanCache::size() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  return m_plans.size();
+}
+
+void FFTPlanCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (auto &[key, plan] : m_plans) {
+    fftwf_destroy_plan(plan);
+  }
+  m_plans.clear();
+}
+
+} // namespace hpaslt
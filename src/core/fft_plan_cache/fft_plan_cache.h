@@ -0,0 +1,253 @@
+#pragma once
+
+#include <fftw3.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace hpaslt {
+
+/**
+ * @brief The data layout of a cached fftw plan.
+ *
+ */
+enum class FFTPlanType { Complex, RealToComplex, ComplexToReal, DCT2 };
+
+/**
+ * @class FFTPlanKey
+ * @brief Everything that decides if an fftw plan can be reused.
+ * fftw new-array execute functions require the new arrays to have the same
+ * alignment and in-place property as the arrays used for planning, so both are
+ * part of the key.
+ *
+ */
+struct FFTPlanKey {
+  int nfft;
+  int sign;
+  FFTPlanType type;
+  int inAlignment;
+  int outAlignment;
+  bool inPlace;
+  unsigned flags;
+  // Number of transforms executed by one plan, and the number of elements
+  // between the first element of two transforms.
+  int howmany = 1;
+  int inDistance = 0;
+  int outDistance = 0;
+
+  bool operator<(const FFTPlanKey &other) const {
+    return std::tie(nfft, sign, type, inAlignment, outAlignment, inPlace,
+                    flags, howmany, inDistance, outDistance) <
+           std::tie(other.nfft, other.sign, other.type, other.inAlignment,
+                    other.outAlignment, other.inPlace, other.flags,
+                    other.howmany, other.inDistance, other.outDistance);
+  }
+};
+
+class FFTPlanCache {
+private:
+  /**
+   * @brief FFTPlanCache singleton.
+   *
+   */
+  static std::shared_ptr<FFTPlanCache> s_fftPlanCache;
+
+  /**
+   * @brief The lock to protect the fftw planner.
+   * The fftw planner is not thread safe, but executing a created plan is.
+   *
+   */
+  std::mutex m_mutex;
+
+  /**
+   * @brief All the plans created by the cache.
+   *
+   */
+  std::map<FFTPlanKey, fftwf_plan> m_plans;
+
+  /**
+   * @brief Create a new plan on scratch buffers matching the key.
+   * The caller must hold m_mutex.
+   *
+   * @param key
+   * @return fftwf_plan nullptr if fftw cannot create the plan.
+   */
+  fftwf_plan createPlan(const FFTPlanKey &key);
+
+public:
+  /**
+   * @brief Get the FFTPlanCache singleton.
+   *
+   * @return std::weak_ptr<FFTPlanCache>
+   */
+  static std::weak_ptr<FFTPlanCache> getSingleton() {
+    if (!s_fftPlanCache) {
+      s_fftPlanCache = std::make_shared<FFTPlanCache>();
+    }
+
+    return s_fftPlanCache;
+  }
+
+  /**
+   * @brief Free the FFTPlanCache singleton and destroy all cached plans.
+   *
+   */
+  static void freeSingleton() { s_fftPlanCache = nullptr; }
+
+  /**
+   * @brief Disable the default copy constructor for FFTPlanCache.
+   *
+   */
+  FFTPlanCache(const FFTPlanCache &) = delete;
+
+  /**
+   * @brief Construct a new FFTPlanCache object.
+   *
+   */
+  FFTPlanCache() {}
+
+  /**
+   * @brief Destroy the FFTPlanCache object and all the cached plans.
+   *
+   */
+  ~FFTPlanCache();
+
+  /**
+   * @brief Get the plan for the key, create it if not exists.
+   * This method is thread safe.
+   *
+   * @param key
+   * @return fftwf_plan
+   */
+  fftwf_plan getPlan(const FFTPlanKey &key);
+
+  /**
+   * @brief Get a complex dft plan that can be executed on in and out with
+   * fftwf_execute_dft.
+   * This method is thread safe.
+   *
+   * @param nfft the fft bin size.
+   * @param sign FFTW_FORWARD or FFTW_BACKWARD.
+   * @param in the input array the plan will be executed on.
+   * @param out the output array the plan will be executed on.
+   * @param flags fftw planner flags.
+   * @return fftwf_plan
+   */
+  fftwf_plan getComplexPlan(int nfft, int sign, fftwf_complex *in,
+                            fftwf_complex *out, unsigned flags);
+
+  /**
+   * @brief Get a real to complex dft plan that can be executed on in and out
+   * with fftwf_execute_dft_r2c.
+   * This method is thread safe.
+   *
+   * @param nfft the fft bin size.
+   * @param in the input array of nfft real numbers.
+   * @param out the output array of nfft / 2 + 1 complex numbers.
+   * @param flags fftw planner flags.
+   * @return fftwf_plan
+   */
+  fftwf_plan getRealToComplexPlan(int nfft, float *in, fftwf_complex *out,
+                                  unsigned flags);
+
+  /**
+   * @brief Get a complex to real dft plan that can be executed on in and out
+   * with fftwf_execute_dft_c2r.
+   * This method is thread safe.
+   *
+   * @param nfft the fft bin size.
+   * @param in the input array of nfft / 2 + 1 complex numbers.
+   * @param out the output array of nfft real numbers.
+   * @param flags fftw planner flags.
+   * @return fftwf_plan
+   */
+  fftwf_plan getComplexToRealPlan(int nfft, fftwf_complex *in, float *out,
+                                  unsigned flags);
+
+  /**
+   * @brief Get a real to complex dft plan that transforms howmany frames in
+   * one fftwf_execute_dft_r2c call.
+   * Input frames may overlap, r2c plans do not overwrite the input.
+   * This method is thread safe.
+   *
+   * @param nfft the fft bin size.
+   * @param howmany the number of frames.
+   * @param in the input array of the first frame.
+   * @param inDistance the number of real numbers between two input frames.
+   * @param out the output array of the first frame.
+   * @param outDistance the number of complex numbers between two output
+   * frames.
+   * @param flags fftw planner flags.
+   * @return fftwf_plan
+   */
+  fftwf_plan getRealToComplexManyPlan(int nfft, int howmany, float *in,
+                                      int inDistance, fftwf_complex *out,
+                                      int outDistance, unsigned flags);
+
+  /**
+   * @brief Get an unnormalized DCT-II (FFTW_REDFT10) plan that transforms
+   * howmany arrays of n real numbers in one fftwf_execute_r2r call.
+   * This method is thread safe.
+   *
+   * @param n the number of real numbers of one transform.
+   * @param howmany the number of transforms.
+   * @param in the input array of the first transform.
+   * @param inDistance the number of real numbers between two input arrays.
+   * @param out the output array of the first transform.
+   * @param outDistance the number of real numbers between two output arrays.
+   * @param flags fftw planner flags.
+   * @return fftwf_plan
+   */
+  fftwf_plan getDCTManyPlan(int n, int howmany, float *in, int inDistance,
+                            float *out, int outDistance, unsigned flags);
+
+  /**
+   * @brief Import fftw wisdom from a file.
+   * Holds the planner lock so no plan is created during the import.
+   * This method is thread safe.
+   *
+   * @param filePath
+   * @return true if the wisdom is imported.
+   */
+  bool importWisdom(const std::string &filePath);
+
+  /**
+   * @brief Export all the accumulated fftw wisdom to a file.
+   * Holds the planner lock so no plan is created during the export.
+   * This method is thread safe.
+   *
+   * @param filePath
+   * @return true if the wisdom is exported.
+   */
+  bool exportWisdom(const std::string &filePath);
+
+  /**
+   * @brief Get the number of float offsets fftw plans distinguish by their
+   * alignment. Arrays starting k and k + getAlignmentNum() floats after an
+   * fftw allocated array reuse the same plans.
+   *
+   * @return int 1 if fftw has no SIMD alignment.
+   */
+  static int getAlignmentNum();
+
+  /**
+   * @brief Get the number of cached plans.
+   * This method is thread safe.
+   *
+   * @return int
+   */
+  int size();
+
+  /**
+   * @brief Destroy all the cached plans.
+   * No plan returned by this cache may be executed after this call.
+   * This method is thread safe.
+   *
+   */
+  void clear();
+};
+
+} // namespace hpaslt
@@ -0,0 +1,109 @@
+#include "fft_wisdom.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "commands/commands.h"
+#include "core/audio_features/audio_features.h"
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/fft_plan_cache/fft_plan_cache.h"
+#include "logger/logger.h"
+#include "serialization/config.h"
+
+namespace hpaslt {
+
+std::string FFTWisdom::s_wisdomPath;
+
+unsigned FFTWisdom::s_plannerFlags = FFTW_MEASURE;
+
+void FFTWisdom::initFFTWisdom(unsigned plannerFlags) {
+  namespace fs = std::filesystem;
+  fs::path wisdomPath = Config::getConfigDirectory() / "fftw_wisdom.dat";
+  s_wisdomPath = wisdomPath.string();
+  s_plannerFlags = plannerFlags;
+
+  if (!fs::exists(wisdomPath)) {
+    logger->coreLogger->info(
+        "FFTW wisdom not found at {}, plans will be measured on first use.",
+        s_wisdomPath);
+    return;
+  }
+
+  if (!FFTPlanCache::getSingleton().lock()->importWisdom(s_wisdomPath)) {
+    logger->coreLogger->error("FFTW wisdom at {} cannot be imported.",
+                              s_wisdomPath);
+    return;
+  }
+
+  logger->coreLogger->debug("FFTW wisdom imported from {}.", s_wisdomPath);
+}
+
+void FFTWisdom::terminateFFTWisdom() {
+  saveFFTWisdom();
+
+  // Plans must be destroyed before the wisdom path is reset.
+  FFTPlanCache::freeSingleton();
+  s_wisdomPath.clear();
+  s_plannerFlags = FFTW_MEASURE;
+}
+
+void FFTWisdom::saveFFTWisdom() {
+  if (s_wisdomPath.empty()) {
+    logger->coreLogger->warn("FFTW wisdom not initialized, skip saving.");
+    return;
+  }
+
+  // Make sure the config directory exists.
+  std::filesystem::create_directories(
+      std::filesystem::path(s_wisdomPath).parent_path());
+
+  if (!FFTPlanCache::getSingleton().lock()->exportWisdom(s_wisdomPath)) {
+    logger->coreLogger->error("FFTW wisdom cannot be exported to {}.",
+                              s_wisdomPath);
+    return;
+  }
+
+  logger->coreLogger->debug("FFTW wisdom exported to {}.", s_wisdomPath);
+}
+
+void FFTWisdom::prewarmFFTWisdom(const std::vector<int> &nffts) {
+  for (int nfft : nffts) {
+    if (nfft <= 0) {
+      logger->coreLogger->warn("Skip prewarming invalid nfft {}.", nfft);
+      continue;
+    }
+    // The batched plans of every overlap the spectrogram window offers.
+    STFTConfig config;
+    config.nfft = nfft;
+    config.execution = SpectrogramExecution::Batched;
+    for (int overlapDivisor : {1, 2, 4}) {
+      config.hopSize = std::max(1, nfft / overlapDivisor);
+      AudioSpectrogram::preparePlans(config);
+    }
+    logger->coreLogger->info("FFTW plans prewarmed for nfft {}.", nfft);
+  }
+  AudioFeatures::preparePlans(FeatureConfig());
+
+  // Save immediately so the work survives an abnormal exit.
+  saveFFTWisdom();
+}
+
+void FFTWisdom::registerConosleCommands() {
+  // Get the console system.
+  std::shared_ptr<csys::System> system =
+      Commands::getSingleton().lock()->getSystem().lock();
+
+  system->RegisterCommand(
+      "prewarmFFTWisdom", "Create and save fftw plans for a list of nfft.",
+      [](const std::vector<int> &nffts) {
+        FFTWisdom::prewarmFFTWisdom(nffts);
+      },
+      csys::Arg<std::vector<int>>("nffts"));
+
+  system->RegisterCommand("saveFFTWisdom", "Save the accumulated fftw wisdom.",
+                          []() { FFTWisdom::saveFFTWisdom(); });
+
+  logger->coreLogger->debug("FFTWisdom commands registered.");
+}
+
+} // namespace hpaslt
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <fftw3.h>
+
+#include <string>
+#include <vector>
+
+namespace hpaslt {
+
+class FFTWisdom {
+private:
+  /**
+   * @brief The file the fftw wisdom is loaded from and saved to.
+   * Empty before initFFTWisdom is called.
+   *
+   */
+  static std::string s_wisdomPath;
+
+  /**
+   * @brief The fftw planner flags used by all the spectrogram plans.
+   *
+   */
+  static unsigned s_plannerFlags;
+
+public:
+  /**
+   * @brief Load the fftw wisdom file from the config directory.
+   * After this call, all the spectrogram plans are created with plannerFlags.
+   *
+   * @param plannerFlags FFTW_MEASURE, FFTW_PATIENT or FFTW_EXHAUSTIVE.
+   */
+  static void initFFTWisdom(unsigned plannerFlags = FFTW_PATIENT);
+
+  /**
+   * @brief Save the accumulated fftw wisdom to the config directory.
+   *
+   */
+  static void terminateFFTWisdom();
+
+  /**
+   * @brief Save the accumulated fftw wisdom without terminating.
+   *
+   */
+  static void saveFFTWisdom();
+
+  /**
+   * @brief Get the fftw planner flags for spectrogram plans.
+   * FFTW_MEASURE if the wisdom is not initialized.
+   *
+   * @return unsigned
+   */
+  static unsigned getPlannerFlags() { return s_plannerFlags; }
+
+  /**
+   * @brief Create the spectrogram plans for a list of fft bin sizes, so the
+   * planning cost is paid now instead of on the first spectrogram.
+   * The single frame plans of every alignment, the batched plans of a full
+   * chunk for the overlaps of the spectrogram window and the DCT plans of the
+   * default features are created. Partial chunks at the end of a source are
+   * still planned on first use.
+   *
+   * @param nffts the fft bin sizes to plan.
+   */
+  static void prewarmFFTWisdom(const std::vector<int> &nffts);
+
+  /**
+   * @brief Register all the commands related to FFTWisdom.
+   *
+   */
+  static void registerConosleCommands();
+};
+
+} // namespace hpaslt
@@ -0,0 +1,150 @@
+#include "job_scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "logger/logger.h"
+
+namespace hpaslt {
+
+void JobHandle::setStatus(JobStatus status) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_status = status;
+  }
+  m_statusCondition.notify_all();
+}
+
+JobStatus JobHandle::getStatus() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_status;
+}
+
+void JobHandle::wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_statusCondition.wait(lock, [this]() {
+    return m_status != JobStatus::Pending && m_status != JobStatus::Running;
+  });
+}
+
+JobScheduler::JobScheduler(int workerNum) : m_sequence(0), m_stop(false) {
+  if (workerNum <= 0) {
+    workerNum = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < workerNum; i++) {
+    m_workers.emplace_back(&JobScheduler::workerLoop, this);
+  }
+}
+
+JobScheduler::~JobScheduler() {
+  std::vector<std::shared_ptr<JobHandle>> pendingJobs;
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_stop = true;
+    while (!m_jobs.empty()) {
+      pendingJobs.push_back(m_jobs.top().handle);
+      m_jobs.pop();
+    }
+  }
+  m_jobCondition.notify_all();
+
+  for (std::shared_ptr<JobHandle> &handle : pendingJobs) {
+    handle->cancel();
+    handle->setStatus(JobStatus::Cancelled);
+  }
+
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+void JobScheduler::workerLoop() {
+  while (true) {
+    QueuedJob job;
+    {
+      std::unique_lock<std::mutex> lock(m_jobMutex);
+      m_jobCondition.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+      if (m_stop) {
+        return;
+      }
+      job = m_jobs.top();
+      m_jobs.pop();
+    }
+
+    // Drop the jobs cancelled while waiting in the queue.
+    if (job.handle->isCancelled()) {
+      job.handle->setStatus(JobStatus::Cancelled);
+      continue;
+    }
+
+    job.handle->setStatus(JobStatus::Running);
+    JobStatus status = JobStatus::Finished;
+    try {
+      job.function(*job.handle->m_token);
+    } catch (const std::exception &e) {
+      logger->coreLogger->error("JobScheduler job failed, error: {}.",
+                                e.what());
+      status = JobStatus::Failed;
+    } catch (...) {
+      logger->coreLogger->error("JobScheduler job failed, unknown error.");
+      status = JobStatus::Failed;
+    }
+    if (status == JobStatus::Finished && job.handle->isCancelled()) {
+      status = JobStatus::Cancelled;
+    }
+
+    if (status == JobStatus::Finished && job.onComplete) {
+      postCompletion(job.handle->m_token, job.onComplete);
+    }
+    job.handle->setStatus(status);
+  }
+}
+
+std::shared_ptr<JobHandle>
+JobScheduler::submit(JobFunction function, JobPriority priority,
+                     std::shared_ptr<CancellationToken> token,
+                     CompletionFunction onComplete) {
+  if (!token) {
+    token = std::make_shared<CancellationToken>();
+  }
+  std::shared_ptr<JobHandle> handle =
+      std::make_shared<JobHandle>(token, priority);
+
+  {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    m_jobs.push({priority, m_sequence++, handle, std::move(function),
+                 std::move(onComplete)});
+  }
+  m_jobCondition.notify_one();
+
+  return handle;
+}
+
+void JobScheduler::postCompletion(std::shared_ptr<CancellationToken> token,
+                                  CompletionFunction function) {
+  std::lock_guard<std::mutex> lock(m_completionMutex);
+  m_completions.emplace_back(token, std::move(function));
+}
+
+int JobScheduler::drainCompletions() {
+  std::vector<std::pair<std::shared_ptr<CancellationToken>, CompletionFunction>>
+      completions;
+  {
+    std::lock_guard<std::mutex> lock(m_completionMutex);
+    completions.swap(m_completions);
+  }
+
+  int completionNum = 0;
+  for (auto &[token, function] : completions) {
+    // The result of a cancelled job group is stale.
+    if (token && token->isCancelled()) {
+      continue;
+    }
+    function();
+    completionNum++;
+  }
+
+  return completionNum;
+}
+
+} // namespace hpaslt
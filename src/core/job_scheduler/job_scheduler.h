@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace hpaslt {
+
+/**
+ * @brief Jobs with a higher priority are started first, jobs with the same
+ * priority in submission order.
+ *
+ */
+enum class JobPriority { Low, Normal, High };
+
+enum class JobStatus { Pending, Running, Finished, Cancelled, Failed };
+
+/**
+ * @brief A flag shared by a group of jobs, for example all the work on one
+ * audio file. Long running jobs should poll isCancelled and return early.
+ * A token chained to a parent is also cancelled with the parent, so one job
+ * of a group can be cancelled without the rest of the group.
+ *
+ */
+class CancellationToken {
+private:
+  std::atomic<bool> m_cancelled;
+  std::shared_ptr<const CancellationToken> m_parent;
+
+public:
+  CancellationToken() : m_cancelled(false) {}
+
+  /**
+   * @brief Construct a token cancelled with its parent.
+   *
+   * @param parent
+   */
+  explicit CancellationToken(std::shared_ptr<const CancellationToken> parent)
+      : m_cancelled(false), m_parent(parent) {}
+
+  void cancel() { m_cancelled.store(true, std::memory_order_release); }
+
+  bool isCancelled() const {
+    return m_cancelled.load(std::memory_order_acquire) ||
+           (m_parent && m_parent->isCancelled());
+  }
+};
+
+/**
+ * @brief The handle of a submitted job.
+ *
+ */
+class JobHandle {
+  friend class JobScheduler;
+
+private:
+  std::shared_ptr<CancellationToken> m_token;
+  JobPriority m_priority;
+
+  /**
+   * @brief Guard m_status for wait.
+   *
+   */
+  std::mutex m_mutex;
+  std::condition_variable m_statusCondition;
+  JobStatus m_status;
+
+  void setStatus(JobStatus status);
+
+public:
+  JobHandle(std::shared_ptr<CancellationToken> token, JobPriority priority)
+      : m_token(token), m_priority(priority), m_status(JobStatus::Pending) {}
+
+  /**
+   * @brief Cancel the token of the job.
+   * A pending job is dropped, a running job sees it through the token. Jobs
+   * sharing the token are cancelled as well.
+   *
+   */
+  void cancel() { m_token->cancel(); }
+
+  bool isCancelled() const { return m_token->isCancelled(); }
+
+  std::shared_ptr<CancellationToken> getToken() const { return m_token; }
+
+  JobPriority getPriority() const { return m_priority; }
+
+  JobStatus getStatus();
+
+  /**
+   * @brief Block until the job finished, failed or is cancelled.
+   *
+   */
+  void wait();
+};
+
+/**
+ * @brief A fixed pool of worker threads running prioritized, cancellable
+ * jobs. Completion callbacks are queued and run by drainCompletions, so the
+ * UI thread decides when they are executed.
+ *
+ */
+class JobScheduler {
+public:
+  /**
+   * @brief The job body, it should return early once the token is cancelled.
+   *
+   */
+  using JobFunction = std::function<void(const CancellationToken &)>;
+
+  using CompletionFunction = std::function<void()>;
+
+private:
+  struct QueuedJob {
+    JobPriority priority;
+    uint64_t sequence;
+    std::shared_ptr<JobHandle> handle;
+    JobFunction function;
+    CompletionFunction onComplete;
+  };
+
+  /**
+   * @brief Order the queue by priority, then by submission order.
+   *
+   */
+  struct QueuedJobCompare {
+    bool operator()(const QueuedJob &a, const QueuedJob &b) const {
+      if (a.priority != b.priority) {
+        return a.priority < b.priority;
+      }
+      return a.sequence > b.sequence;
+    }
+  };
+
+  std::vector<std::thread> m_workers;
+
+  /**
+   * @brief Guard m_jobs, m_sequence and m_stop.
+   *
+   */
+  std::mutex m_jobMutex;
+  std::condition_variable m_jobCondition;
+  std::priority_queue<QueuedJob, std::vector<QueuedJob>, QueuedJobCompare>
+      m_jobs;
+  uint64_t m_sequence;
+  bool m_stop;
+
+  /**
+   * @brief Completion callbacks waiting for drainCompletions.
+   *
+   */
+  std::mutex m_completionMutex;
+  std::vector<std::pair<std::shared_ptr<CancellationToken>, CompletionFunction>>
+      m_completions;
+
+  void workerLoop();
+
+public:
+  /**
+   * @brief Construct a new JobScheduler object and start the workers.
+   *
+   * @param workerNum the number of worker threads, 0 for one per hardware
+   * thread.
+   */
+  explicit JobScheduler(int workerNum = 0);
+
+  /**
+   * @brief Disable the default copy constructor for JobScheduler.
+   *
+   */
+  JobScheduler(const JobScheduler &) = delete;
+
+  /**
+   * @brief Cancel the pending jobs and join the workers after the running
+   * jobs return.
+   *
+   */
+  ~JobScheduler();
+
+  int getNumWorkers() const { return m_workers.size(); }
+
+  /**
+   * @brief Queue a job.
+   *
+   * @param function the job body, executed on a worker thread.
+   * @param priority
+   * @param token the token of the job group, a new token if nullptr.
+   * @param onComplete queued for drainCompletions when the job finished
+   * without being cancelled.
+   * @return std::shared_ptr<JobHandle>
+   */
+  std::shared_ptr<JobHandle>
+  submit(JobFunction function, JobPriority priority = JobPriority::Normal,
+         std::shared_ptr<CancellationToken> token = nullptr,
+         CompletionFunction onComplete = nullptr);
+
+  /**
+   * @brief Queue a callback for drainCompletions.
+   *
+   * @param token the callback is dropped if the token is cancelled, may be
+   * nullptr.
+   * @param function
+   */
+  void postCompletion(std::shared_ptr<CancellationToken> token,
+                      CompletionFunction function);
+
+  /**
+   * @brief Run all the queued completion callbacks on the calling thread.
+   *
+   * @return int the number of callbacks executed.
+   */
+  int drainCompletions();
+};
+
+} // namespace hpaslt
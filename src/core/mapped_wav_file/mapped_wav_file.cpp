@@ -0,0 +1,354 @@
+#include "mapped_wav_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief WAVE format tags.
+ *
+ */
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+namespace hpaslt {
+
+/**
+ * @brief Read a little endian unsigned integer of the byte number.
+ *
+ * @param data
+ * @param byteNum
+ * @return uint32_t
+ */
+static uint32_t readLittleEndian(const uint8_t *data, int byteNum) {
+  uint32_t value = 0;
+  for (int i = byteNum - 1; i >= 0; i--) {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+/**
+ * @brief Convert strided samples of the encoding to float in [-1, 1].
+ *
+ * @param src the first sample.
+ * @param stride the number of bytes between two samples.
+ * @param count
+ * @param dst
+ * @param dstStride the number of floats between two output samples.
+ * @param format
+ * @param bitDepth
+ */
+static void convertSamples(const uint8_t *src, int stride, int64_t count,
+                           float *dst, int dstStride, WavSampleFormat format,
+                           int bitDepth) {
+  if (format == WavSampleFormat::Float) {
+    if (bitDepth == 32) {
+      for (int64_t i = 0; i < count; i++) {
+        float value;
+        std::memcpy(&value, src + i * stride, sizeof(float));
+        dst[i * dstStride] = value;
+      }
+    } else {
+      for (int64_t i = 0; i < count; i++) {
+        double value;
+        std::memcpy(&value, src + i * stride, sizeof(double));
+        dst[i * dstStride] = (float)value;
+      }
+    }
+    return;
+  }
+
+  switch (bitDepth) {
+  case 8:
+    // 8 bit PCM is unsigned.
+    for (int64_t i = 0; i < count; i++) {
+      dst[i * dstStride] = ((float)src[i * stride] - 128.f) / 128.f;
+    }
+    break;
+  case 16:
+    for (int64_t i = 0; i < count; i++) {
+      int16_t value = (int16_t)readLittleEndian(src + i * stride, 2);
+      dst[i * dstStride] = (float)value / 32768.f;
+    }
+    break;
+  case 24:
+    for (int64_t i = 0; i < count; i++) {
+      // Shift into the top of an int32 to extend the sign.
+      int32_t value = (int32_t)(readLittleEndian(src + i * stride, 3) << 8);
+      dst[i * dstStride] = (float)(value >> 8) / 8388608.f;
+    }
+    break;
+  case 32:
+    for (int64_t i = 0; i < count; i++) {
+      int32_t value = (int32_t)readLittleEndian(src + i * stride, 4);
+      dst[i * dstStride] = (float)((double)value / 2147483648.0);
+    }
+    break;
+  }
+}
+
+MappedWavFile::MappedWavFile(const std::string &filePath)
+    : m_mapping(nullptr), m_mappingSize(0),
+#ifdef _WIN32
+      m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(nullptr),
+#else
+      m_fd(-1),
+#endif
+      m_data(nullptr), m_sampleFormat(WavSampleFormat::Int), m_channelNum(0),
+      m_sampleRate(0), m_bitDepth(0), m_blockAlign(0), m_sampleNum(0) {
+#ifdef _WIN32
+  m_fileHandle =
+      CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_fileHandle == INVALID_HANDLE_VALUE) {
+    throw std::invalid_argument("Audio file at path cannot be opened.");
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+    unmap();
+    throw std::invalid_argument("Audio file at path is empty.");
+  }
+  m_mappingSize = (size_t)fileSize.QuadPart;
+  m_mappingHandle =
+      CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mappingHandle) {
+    m_mapping = (const uint8_t *)MapViewOfFile(m_mappingHandle, FILE_MAP_READ,
+                                               0, 0, 0);
+  }
+#else
+  m_fd = open(filePath.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    throw std::invalid_argument("Audio file at path cannot be opened.");
+  }
+  struct stat fileStat;
+  if (fstat(m_fd, &fileStat) != 0 || fileStat.st_size == 0) {
+    unmap();
+    throw std::invalid_argument("Audio file at path is empty.");
+  }
+  m_mappingSize = (size_t)fileStat.st_size;
+  void *mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (mapping != MAP_FAILED) {
+    m_mapping = (const uint8_t *)mapping;
+  }
+#endif
+
+  if (!m_mapping) {
+    unmap();
+    throw std::invalid_argument("Audio file at path cannot be mapped.");
+  }
+
+  try {
+    parseHeader();
+  } catch (const std::invalid_argument &) {
+    unmap();
+    throw;
+  }
+}
+
+MappedWavFile::~MappedWavFile() { unmap(); }
+
+void MappedWavFile::unmap() {
+#ifdef _WIN32
+  if (m_mapping) {
+    UnmapViewOfFile(m_mapping);
+  }
+  if (m_mappingHandle) {
+    CloseHandle(m_mappingHandle);
+  }
+  if (m_fileHandle != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_fileHandle);
+  }
+  m_mappingHandle = nullptr;
+  m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+  if (m_mapping) {
+    munmap((void *)m_mapping, m_mappingSize);
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+  m_fd = -1;
+#endif
+  m_mapping = nullptr;
+  m_data = nullptr;
+}
+
+void MappedWavFile::parseHeader() {
+  if (m_mappingSize < 12 || std::memcmp(m_mapping, "RIFF", 4) != 0 ||
+      std::memcmp(m_mapping + 8, "WAVE", 4) != 0) {
+    throw std::invalid_argument("Audio file is not a RIFF/WAVE file.");
+  }
+
+  bool foundFormat = false;
+  int formatTag = 0;
+  size_t position = 12;
+
+  // Walk the chunks until the data chunk.
+  while (position + 8 <= m_mappingSize) {
+    const uint8_t *chunk = m_mapping + position;
+    size_t chunkSize = readLittleEndian(chunk + 4, 4);
+    const uint8_t *body = chunk + 8;
+    size_t bodySize = std::min(chunkSize, m_mappingSize - position - 8);
+
+    if (std::memcmp(chunk, "fmt ", 4) == 0) {
+      if (bodySize < 16) {
+        throw std::invalid_argument("Audio file format chunk is truncated.");
+      }
+      formatTag = readLittleEndian(body, 2);
+      m_channelNum = readLittleEndian(body + 2, 2);
+      m_sampleRate = readLittleEndian(body + 4, 4);
+      m_blockAlign = readLittleEndian(body + 12, 2);
+      m_bitDepth = readLittleEndian(body + 14, 2);
+      // The sub format GUID starts with the actual format tag.
+      if (formatTag == WAVE_FORMAT_EXTENSIBLE && bodySize >= 26) {
+        formatTag = readLittleEndian(body + 24, 2);
+      }
+      foundFormat = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      if (!foundFormat) {
+        throw std::invalid_argument("Audio file data chunk before format.");
+      }
+      m_data = body;
+      // A truncated recording still plays what was written.
+      m_sampleNum = (int64_t)(bodySize / std::max(m_blockAlign, 1));
+      break;
+    }
+
+    // Chunks are padded to an even size.
+    position += 8 + chunkSize + (chunkSize & 1);
+  }
+
+  if (!m_data) {
+    throw std::invalid_argument("Audio file has no data chunk.");
+  }
+
+  if (formatTag == WAVE_FORMAT_PCM &&
+      (m_bitDepth == 8 || m_bitDepth == 16 || m_bitDepth == 24 ||
+       m_bitDepth == 32)) {
+    m_sampleFormat = WavSampleFormat::Int;
+  } else if (formatTag == WAVE_FORMAT_IEEE_FLOAT &&
+             (m_bitDepth == 32 || m_bitDepth == 64)) {
+    m_sampleFormat = WavSampleFormat::Float;
+  } else {
+    throw std::invalid_argument("Audio file sample format not supported.");
+  }
+
+  if (m_channelNum <= 0 || m_sampleRate <= 0 ||
+      m_blockAlign != m_channelNum * m_bitDepth / 8) {
+    throw std::invalid_argument("Audio file format chunk is invalid.");
+  }
+}
+
+int64_t MappedWavFile::readSamples(int channel, int64_t offset, int64_t count,
+                                   float *dst) const {
+  if (channel < 0 || channel >= m_channelNum || offset < 0 ||
+      offset >= m_sampleNum) {
+    return 0;
+  }
+  count = std::min(count, m_sampleNum - offset);
+
+  const uint8_t *src =
+      m_data + offset * m_blockAlign + channel * (m_bitDepth / 8);
+  convertSamples(src, m_blockAlign, count, dst, 1, m_sampleFormat,
+                 m_bitDepth);
+  return count;
+}
+
+int64_t MappedWavFile::readFrames(int64_t offset, int64_t count,
+                                  float *dst) const {
+  if (offset < 0 || offset >= m_sampleNum) {
+    return 0;
+  }
+  count = std::min(count, m_sampleNum - offset);
+
+  for (int channel = 0; channel < m_channelNum; channel++) {
+    const uint8_t *src =
+        m_data + offset * m_blockAlign + channel * (m_bitDepth / 8);
+    convertSamples(src, m_blockAlign, count, dst + channel, m_channelNum,
+                   m_sampleFormat, m_bitDepth);
+  }
+  return count;
+}
+
+/**
+ * @brief Get the page aligned byte range of the frames in the mapping.
+ *
+ * @param mapping
+ * @param data
+ * @param blockAlign
+ * @param offset
+ * @param count
+ * @param begin the page aligned first byte.
+ * @param length
+ */
+static void getPageRange(const uint8_t *mapping, const uint8_t *data,
+                         int blockAlign, int64_t offset, int64_t count,
+                         const uint8_t *&begin, size_t &length) {
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  size_t pageSize = systemInfo.dwPageSize;
+#else
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+  size_t first = (size_t)(data - mapping) + (size_t)(offset * blockAlign);
+  size_t last = first + (size_t)(count * blockAlign);
+  first -= first % pageSize;
+  begin = mapping + first;
+  length = last - first;
+}
+
+void MappedWavFile::prefetch(int64_t offset, int64_t count) const {
+  offset = std::clamp<int64_t>(offset, 0, m_sampleNum);
+  count = std::clamp<int64_t>(count, 0, m_sampleNum - offset);
+  if (count == 0) {
+    return;
+  }
+
+  const uint8_t *begin;
+  size_t length;
+  getPageRange(m_mapping, m_data, m_blockAlign, offset, count, begin, length);
+#ifdef _WIN32
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = (void *)begin;
+  range.NumberOfBytes = length;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+  madvise((void *)begin, length, MADV_WILLNEED);
+#endif
+}
+
+void MappedWavFile::release(int64_t offset, int64_t count) const {
+  offset = std::clamp<int64_t>(offset, 0, m_sampleNum);
+  count = std::clamp<int64_t>(count, 0, m_sampleNum - offset);
+  if (count == 0) {
+    return;
+  }
+
+  const uint8_t *begin;
+  size_t length;
+  getPageRange(m_mapping, m_data, m_blockAlign, offset, count, begin, length);
+#ifdef _WIN32
+  // Unlocking pages that are not locked trims them from the working set.
+  VirtualUnlock((void *)begin, length);
+#else
+  // The mapping is read only and file backed, dropped pages are read again.
+  madvise((void *)begin, length, MADV_DONTNEED);
+#endif
+}
+
+} // namespace hpaslt
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace hpaslt {
+
+/**
+ * @brief Sample encodings of the PCM data region.
+ *
+ */
+enum class WavSampleFormat { Int, Float };
+
+/**
+ * @brief A WAV file mapped into memory.
+ * Only the RIFF/WAVE header is parsed on construction, the PCM data region is
+ * exposed without copying and converted to float in blocks on demand. Pages
+ * are loaded by the OS when they are touched, so the resident memory tracks
+ * what is actually read.
+ *
+ */
+class MappedWavFile {
+private:
+  /**
+   * @brief The mapped file, the whole file is mapped read only.
+   *
+   */
+  const uint8_t *m_mapping;
+
+  /**
+   * @brief The size of the mapping in bytes.
+   *
+   */
+  size_t m_mappingSize;
+
+#ifdef _WIN32
+  /**
+   * @brief The file and file mapping handles.
+   *
+   */
+  void *m_fileHandle;
+  void *m_mappingHandle;
+#else
+  /**
+   * @brief The file descriptor.
+   *
+   */
+  int m_fd;
+#endif
+
+  /**
+   * @brief The beginning of the PCM data region in the mapping.
+   *
+   */
+  const uint8_t *m_data;
+
+  WavSampleFormat m_sampleFormat;
+  int m_channelNum;
+  int m_sampleRate;
+  int m_bitDepth;
+
+  /**
+   * @brief The number of bytes of a frame, one sample of each channel.
+   *
+   */
+  int m_blockAlign;
+
+  int64_t m_sampleNum;
+
+  /**
+   * @brief Parse the RIFF/WAVE header and locate the data region.
+   * Throws std::invalid_argument if the file is not a supported WAV file.
+   *
+   */
+  void parseHeader();
+
+  /**
+   * @brief Unmap the file and close all the handles.
+   *
+   */
+  void unmap();
+
+public:
+  /**
+   * @brief Map the WAV file at the path.
+   * Throws std::invalid_argument if the file cannot be mapped or is not a
+   * supported PCM or IEEE float WAV file.
+   *
+   * @param filePath
+   */
+  explicit MappedWavFile(const std::string &filePath);
+
+  /**
+   * @brief Disable the default copy constructor for MappedWavFile.
+   *
+   */
+  MappedWavFile(const MappedWavFile &) = delete;
+
+  /**
+   * @brief Unmap the file.
+   *
+   */
+  ~MappedWavFile();
+
+  WavSampleFormat getSampleFormat() const { return m_sampleFormat; }
+
+  int getNumChannels() const { return m_channelNum; }
+
+  int getSampleRate() const { return m_sampleRate; }
+
+  int getBitDepth() const { return m_bitDepth; }
+
+  int64_t getNumSamplesPerChannel() const { return m_sampleNum; }
+
+  /**
+   * @brief Get the raw interleaved PCM data region.
+   *
+   * @return const uint8_t*
+   */
+  const uint8_t *getData() const { return m_data; }
+
+  /**
+   * @brief Convert the samples of one channel to float in [-1, 1].
+   *
+   * @param channel
+   * @param offset the first frame to convert.
+   * @param count the number of frames, clamped to the end of the file.
+   * @param dst
+   * @return int64_t the number of samples written.
+   */
+  int64_t readSamples(int channel, int64_t offset, int64_t count,
+                      float *dst) const;
+
+  /**
+   * @brief Convert frames of all the channels to interleaved float.
+   *
+   * @param offset the first frame to convert.
+   * @param count the number of frames, clamped to the end of the file.
+   * @param dst
+   * @return int64_t the number of frames written.
+   */
+  int64_t readFrames(int64_t offset, int64_t count, float *dst) const;
+
+  /**
+   * @brief Tell the OS the frames will be read soon.
+   *
+   * @param offset
+   * @param count
+   */
+  void prefetch(int64_t offset, int64_t count) const;
+
+  /**
+   * @brief Let the OS drop the resident pages of the frames.
+   * The data stays valid, the pages are read again from the file on access.
+   *
+   * @param offset
+   * @param count
+   */
+  void release(int64_t offset, int64_t count) const;
+};
+
+} // namespace hpaslt
@@ -0,0 +1,83 @@
+#include "mel_filterbank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace hpaslt {
+
+float MelFilterbank::hzToMel(float freq) {
+  return 2595.f * std::log10(1.f + freq / 700.f);
+}
+
+float MelFilterbank::melToHz(float mel) {
+  return 700.f * (std::pow(10.f, mel / 2595.f) - 1.f);
+}
+
+MelFilterbank::MelFilterbank(int sampleRate, int nfft,
+                             const FilterbankConfig &config)
+    : m_binNum(nfft / 2 + 1), m_bandNum(config.bandNum) {
+  float nyquist = sampleRate / 2.f;
+  float minFreq = config.minFreq;
+  float maxFreq = config.maxFreq > 0 ? config.maxFreq : nyquist;
+  if (sampleRate <= 0 || nfft <= 0 || config.bandNum <= 0) {
+    throw std::invalid_argument(
+        "Filterbank needs a sample rate, nfft and bands.");
+  }
+  if (minFreq < 0 || minFreq >= maxFreq || maxFreq > nyquist ||
+      (config.scale == FilterbankScale::Log && minFreq <= 0)) {
+    throw std::invalid_argument("Invalid filterbank frequency range.");
+  }
+
+  // bandNum + 2 edges evenly spaced on the scale, band b rises from edge b
+  // to its center at edge b + 1 and falls to edge b + 2.
+  bool mel = config.scale == FilterbankScale::Mel;
+  float first = mel ? hzToMel(minFreq) : std::log2(minFreq);
+  float last = mel ? hzToMel(maxFreq) : std::log2(maxFreq);
+  std::vector<float> edges(m_bandNum + 2);
+  for (int i = 0; i < m_bandNum + 2; i++) {
+    float point = first + (last - first) * i / (m_bandNum + 1);
+    edges[i] = mel ? melToHz(point) : std::exp2(point);
+  }
+
+  float binFreq = (float)sampleRate / nfft;
+  m_firstBins.resize(m_bandNum);
+  m_weightOffsets.resize(m_bandNum + 1);
+  m_centerFrequencies.resize(m_bandNum);
+  for (int band = 0; band < m_bandNum; band++) {
+    float lower = edges[band];
+    float center = edges[band + 1];
+    float upper = edges[band + 2];
+    m_centerFrequencies[band] = center;
+
+    // Only the bins strictly inside the triangle have a weight.
+    int firstBin = std::max(0, (int)std::floor(lower / binFreq) + 1);
+    int lastBin = std::min(m_binNum - 1, (int)std::ceil(upper / binFreq) - 1);
+    m_firstBins[band] = firstBin;
+    m_weightOffsets[band] = m_weights.size();
+    for (int bin = firstBin; bin <= lastBin; bin++) {
+      float freq = bin * binFreq;
+      float weight = freq <= center ? (freq - lower) / (center - lower)
+                                    : (upper - freq) / (upper - center);
+      m_weights.push_back(std::max(0.f, weight));
+    }
+  }
+  m_weightOffsets[m_bandNum] = m_weights.size();
+}
+
+void MelFilterbank::apply(const float *power, float *bands) const {
+  const float *weights = m_weights.data();
+  for (int band = 0; band < m_bandNum; band++) {
+    const float *bins = power + m_firstBins[band];
+    const float *bandWeights = weights + m_weightOffsets[band];
+    int weightNum = m_weightOffsets[band + 1] - m_weightOffsets[band];
+    float sum = 0;
+#pragma omp simd reduction(+ : sum)
+    for (int i = 0; i < weightNum; i++) {
+      sum += bandWeights[i] * bins[i];
+    }
+    bands[band] = sum;
+  }
+}
+
+} // namespace hpaslt
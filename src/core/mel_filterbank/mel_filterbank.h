@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+
+namespace hpaslt {
+
+/**
+ * @brief How the band edges of a filterbank are spaced.
+ * Mel spaces them evenly on the HTK mel scale, Log evenly on a log frequency
+ * axis, so every band spans the same musical interval.
+ *
+ */
+enum class FilterbankScale { Mel, Log };
+
+/**
+ * @class FilterbankConfig
+ * @brief The bands of a triangular filterbank.
+ *
+ */
+struct FilterbankConfig {
+  FilterbankScale scale = FilterbankScale::Mel;
+  int bandNum = 40;
+  // The lower edge of the first band, must be positive for
+  // FilterbankScale::Log.
+  float minFreq = 0;
+  // The upper edge of the last band, 0 for the Nyquist frequency.
+  float maxFreq = 0;
+};
+
+/**
+ * @brief Overlapping triangular filters over the nfft / 2 + 1 bins of a real
+ * spectrum.
+ * Each band stores only the weights of the bins under its triangle,
+ * contiguously, so applying a band is one dense dot product. The triangles
+ * peak at 1 on the band center.
+ *
+ */
+class MelFilterbank {
+private:
+  int m_binNum;
+  int m_bandNum;
+
+  /**
+   * @brief The first bin under each band.
+   *
+   */
+  std::vector<int> m_firstBins;
+
+  /**
+   * @brief Band b has the weights [m_weightOffsets[b], m_weightOffsets[b + 1])
+   * of m_weights.
+   *
+   */
+  std::vector<int> m_weightOffsets;
+
+  std::vector<float> m_weights;
+
+  std::vector<float> m_centerFrequencies;
+
+public:
+  /**
+   * @brief Build the filterbank for a spectrum.
+   *
+   * @param sampleRate
+   * @param nfft the fft size of the spectrum.
+   * @param config the bands.
+   */
+  MelFilterbank(int sampleRate, int nfft, const FilterbankConfig &config);
+
+  /**
+   * @brief Convert a frequency to the HTK mel scale.
+   *
+   * @param freq
+   * @return float
+   */
+  static float hzToMel(float freq);
+
+  /**
+   * @brief Convert a HTK mel value to a frequency.
+   *
+   * @param mel
+   * @return float
+   */
+  static float melToHz(float mel);
+
+  /**
+   * @brief Get the number of spectrum bins the filterbank reads.
+   *
+   * @return int nfft / 2 + 1.
+   */
+  int getBinNum() const { return m_binNum; }
+
+  int getBandNum() const { return m_bandNum; }
+
+  /**
+   * @brief Get the frequency a band peaks at.
+   *
+   * @param band
+   * @return float
+   */
+  float getCenterFrequency(int band) const { return m_centerFrequencies[band]; }
+
+  /**
+   * @brief Get the number of stored weights of all bands.
+   *
+   * @return int
+   */
+  int getWeightNum() const { return m_weights.size(); }
+
+  /**
+   * @brief Sum the weighted bins of every band.
+   *
+   * @param power getBinNum() values.
+   * @param bands getBandNum() sums.
+   */
+  void apply(const float *power, float *bands) const;
+};
+
+} // namespace hpaslt
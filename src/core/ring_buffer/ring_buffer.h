@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace hpaslt {
+
+/**
+ * @brief Lock free single producer single consumer ring buffer.
+ * One thread may call write and writeAvailable, one other thread may call
+ * read, readAvailable and discard. Neither side locks or allocates, so the
+ * consumer can be a real time audio callback.
+ *
+ * @tparam T a trivially copyable element type.
+ */
+template <class T> class SPSCRingBuffer {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SPSCRingBuffer only copies with memcpy.");
+
+private:
+  /**
+   * @brief The storage, the size is always a power of 2.
+   *
+   */
+  std::vector<T> m_buffer;
+
+  /**
+   * @brief m_buffer.size() - 1, maps an index into the storage.
+   *
+   */
+  size_t m_mask;
+
+  /**
+   * @brief Total number of elements written, only modified by the producer.
+   * On its own cache line so the two sides do not false share.
+   *
+   */
+  alignas(64) std::atomic<size_t> m_writeIndex;
+
+  /**
+   * @brief Total number of elements read, only modified by the consumer.
+   *
+   */
+  alignas(64) std::atomic<size_t> m_readIndex;
+
+public:
+  /**
+   * @brief Construct a new SPSCRingBuffer object.
+   *
+   * @param capacity the minimum number of elements, rounded up to a power
+   * of 2.
+   */
+  explicit SPSCRingBuffer(size_t capacity) : m_writeIndex(0), m_readIndex(0) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_buffer.resize(size);
+    m_mask = size - 1;
+  }
+
+  /**
+   * @brief Disable the default copy constructor for SPSCRingBuffer.
+   *
+   */
+  SPSCRingBuffer(const SPSCRingBuffer &) = delete;
+
+  /**
+   * @brief Get the number of elements the ring buffer can hold.
+   *
+   * @return size_t
+   */
+  size_t capacity() const { return m_buffer.size(); }
+
+  /**
+   * @brief Get the number of elements ready to read.
+   * Only call this method from the consumer thread.
+   *
+   * @return size_t
+   */
+  size_t readAvailable() const {
+    return m_writeIndex.load(std::memory_order_acquire) -
+           m_readIndex.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get the number of elements that can be written.
+   * Only call this method from the producer thread.
+   *
+   * @return size_t
+   */
+  size_t writeAvailable() const {
+    return capacity() - (m_writeIndex.load(std::memory_order_relaxed) -
+                         m_readIndex.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief Write up to count elements.
+   * Only call this method from the producer thread.
+   *
+   * @param src
+   * @param count
+   * @return size_t the number of elements written.
+   */
+  size_t write(const T *src, size_t count) {
+    size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    count = std::min(count, writeAvailable());
+
+    // At most two copies, before and after the wrap around.
+    size_t offset = writeIndex & m_mask;
+    size_t firstCount = std::min(count, capacity() - offset);
+    std::memcpy(m_buffer.data() + offset, src, firstCount * sizeof(T));
+    std::memcpy(m_buffer.data(), src + firstCount,
+                (count - firstCount) * sizeof(T));
+
+    m_writeIndex.store(writeIndex + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Read up to count elements.
+   * Only call this method from the consumer thread.
+   *
+   * @param dst
+   * @param count
+   * @return size_t the number of elements read.
+   */
+  size_t read(T *dst, size_t count) {
+    size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+    count = std::min(count, readAvailable());
+
+    // At most two copies, before and after the wrap around.
+    size_t offset = readIndex & m_mask;
+    size_t firstCount = std::min(count, capacity() - offset);
+    std::memcpy(dst, m_buffer.data() + offset, firstCount * sizeof(T));
+    std::memcpy(dst + firstCount, m_buffer.data(),
+                (count - firstCount) * sizeof(T));
+
+    m_readIndex.store(readIndex + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @brief Drop all the elements ready to read.
+   * Only call this method from the consumer thread.
+   *
+   */
+  void discard() {
+    m_readIndex.store(m_writeIndex.load(std::memory_order_acquire),
+                      std::memory_order_release);
+  }
+};
+
+} // namespace hpaslt
@@ -3,38 +3,167 @@
 #endif
 #include "signal_generator.h"
 
-#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Samples synthesized from one exact phase, and handed to one worker.
+#define SIGNAL_GENERATOR_BLOCK_SAMPLES 4096
+
+// Clone the kernels for the widest vector units, picked when the program is
+// loaded. The default clone is SSE2 on x86-64.
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define SIGNAL_GENERATOR_TARGET_CLONES                                         \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SIGNAL_GENERATOR_TARGET_CLONES
+#endif
 
 namespace hpaslt {
 
+/**
+ * @brief sin(2 pi x) for x in [0, 1).
+ * Folds x into [-1 / 2, 1 / 2] and |x| into [0, 1 / 4] without branches, then
+ * evaluates the Taylor polynomial to the 11th order, which is below float
+ * rounding over a quarter period.
+ *
+ * @param x the phase in cycles.
+ * @return float
+ */
+static inline float sinCycles(float x) {
+  x -= (float)(int)(x + 0.5f);
+  float t = (0.25f - std::fabs(0.25f - std::fabs(x))) * (float)(2 * M_PI);
+  float t2 = t * t;
+  float p = -1.f / 39916800;
+  p = p * t2 + 1.f / 362880;
+  p = p * t2 - 1.f / 5040;
+  p = p * t2 + 1.f / 120;
+  p = p * t2 - 1.f / 6;
+  p = p * t2 + 1.f;
+  return std::copysign(p * t, x);
+}
+
+/**
+ * @brief Write or add magnitude * sin(2 pi (phase + i * increment)).
+ *
+ * @param dst
+ * @param sampleNum at most SIGNAL_GENERATOR_BLOCK_SAMPLES.
+ * @param phase the phase of dst[0] in cycles.
+ * @param increment the phase step in cycles, in [0, 1).
+ * @param magnitude
+ * @param overlay
+ */
+SIGNAL_GENERATOR_TARGET_CLONES
+static void oscillate(float *dst, int sampleNum, double phase,
+                      double increment, float magnitude, bool overlay) {
+  if (overlay) {
+#pragma omp simd
+    for (int i = 0; i < sampleNum; i++) {
+      double cycles = phase + i * increment;
+      float x = (float)(cycles - (int)cycles);
+      dst[i] += magnitude * sinCycles(x);
+    }
+  } else {
+#pragma omp simd
+    for (int i = 0; i < sampleNum; i++) {
+      double cycles = phase + i * increment;
+      float x = (float)(cycles - (int)cycles);
+      dst[i] = magnitude * sinCycles(x);
+    }
+  }
+}
+
+void SignalGenerator::synthesizePartials(
+    float *dst, int64_t firstSample, int sampleNum,
+    const std::vector<SignalPartial> &partials, int sampleRate, bool overlay) {
+  if (partials.empty() && !overlay) {
+    std::fill_n(dst, sampleNum, 0.f);
+  }
+  for (int offset = 0; offset < sampleNum;
+       offset += SIGNAL_GENERATOR_BLOCK_SAMPLES) {
+    int blockSize = std::min(SIGNAL_GENERATOR_BLOCK_SAMPLES, sampleNum - offset);
+    // Every partial is added to the block while it is still in cache.
+    for (size_t i = 0; i < partials.size(); i++) {
+      const SignalPartial &partial = partials[i];
+      double increment = (double)partial.freq / sampleRate;
+      increment -= std::floor(increment);
+      // n * freq is exact in double for any realistic n, so fmod gives the
+      // phase of a block start without drift.
+      double phase = std::fmod((double)(firstSample + offset) * partial.freq,
+                               sampleRate) /
+                         sampleRate +
+                     partial.phase / (2 * M_PI);
+      phase -= std::floor(phase);
+      oscillate(dst + offset, blockSize, phase, increment, partial.magnitude,
+                overlay || i > 0);
+    }
+  }
+}
+
 void SignalGenerator::changeLength(int length) {
   m_workingAudioFile->setNumSamplesPerChannel(length);
 }
 
-void SignalGenerator::generateSignal(float freq, float magnitude) {
+void SignalGenerator::synthesizeChannels(
+    const std::vector<SignalPartial> &partials, bool overlay) {
   int sampleRate = m_workingAudioFile->getSampleRate();
   int sampleLength = m_workingAudioFile->getNumSamplesPerChannel();
-  for (int channel = 0; channel < m_workingAudioFile->getNumChannels();
-       channel++) {
-#pragma omp parallel for
-    for (int i = 0; i < sampleLength; i++) {
-      m_workingAudioFile->samples[channel][i] =
-          sin(2 * M_PI * i * freq / sampleRate) * magnitude;
+  int channelNum = m_workingAudioFile->getNumChannels();
+  if (channelNum == 0) {
+    return;
+  }
+  std::vector<std::vector<float>> &samples = m_workingAudioFile->samples;
+  int blockNum = (sampleLength + SIGNAL_GENERATOR_BLOCK_SAMPLES - 1) /
+                 SIGNAL_GENERATOR_BLOCK_SAMPLES;
+  // Overlaying several channels needs the new signal apart from the old one.
+  bool scratch = overlay && channelNum > 1;
+
+#pragma omp parallel
+  {
+    std::vector<float> block(scratch ? SIGNAL_GENERATOR_BLOCK_SAMPLES : 0);
+
+#pragma omp for schedule(static)
+    for (int blockIndex = 0; blockIndex < blockNum; blockIndex++) {
+      int first = blockIndex * SIGNAL_GENERATOR_BLOCK_SAMPLES;
+      int blockSize =
+          std::min(SIGNAL_GENERATOR_BLOCK_SAMPLES, sampleLength - first);
+
+      // Synthesize the block once, then copy or add it to every channel
+      // while it is in cache.
+      float *src = scratch ? block.data() : samples[0].data() + first;
+      synthesizePartials(src, first, blockSize, partials, sampleRate,
+                         overlay && !scratch);
+      for (int channel = scratch ? 0 : 1; channel < channelNum; channel++) {
+        float *dst = samples[channel].data() + first;
+        if (overlay) {
+#pragma omp simd
+          for (int i = 0; i < blockSize; i++) {
+            dst[i] += src[i];
+          }
+        } else {
+          std::copy_n(src, blockSize, dst);
+        }
+      }
     }
   }
 }
 
+void SignalGenerator::generateSignal(float freq, float magnitude) {
+  synthesizeChannels({{freq, magnitude}}, false);
+}
+
 void SignalGenerator::overlaySignal(float freq, float magnitude) {
-  int sampleRate = m_workingAudioFile->getSampleRate();
-  int sampleLength = m_workingAudioFile->getNumSamplesPerChannel();
-  for (int channel = 0; channel < m_workingAudioFile->getNumChannels();
-       channel++) {
-#pragma omp parallel for
-    for (int i = 0; i < sampleLength; i++) {
-      m_workingAudioFile->samples[channel][i] +=
-          sin(2 * M_PI * i * freq / sampleRate) * magnitude;
-    }
-  }
+  synthesizeChannels({{freq, magnitude}}, true);
+}
+
+void SignalGenerator::generatePartials(
+    const std::vector<SignalPartial> &partials) {
+  synthesizeChannels(partials, false);
+}
+
+void SignalGenerator::overlayPartials(
+    const std::vector<SignalPartial> &partials) {
+  synthesizeChannels(partials, true);
 }
 
 } // namespace hpaslt
@@ -1,9 +1,23 @@
 #include <AudioFile.h>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace hpaslt {
 
+/**
+ * @class SignalPartial
+ * @brief One sine of a synthesized signal.
+ *
+ */
+struct SignalPartial {
+  float freq;
+  float magnitude;
+  // The phase at sample 0 in radians.
+  float phase = 0;
+};
+
 class SignalGenerator {
 private:
   /**
@@ -12,6 +26,16 @@ class SignalGenerator {
    */
   std::shared_ptr<AudioFile<float>> m_workingAudioFile;
 
+  /**
+   * @brief Write or add the same partials to every channel of the audio file.
+   * Each block is synthesized once and copied or added to every channel.
+   *
+   * @param partials
+   * @param overlay add to the samples instead of replacing them.
+   */
+  void synthesizeChannels(const std::vector<SignalPartial> &partials,
+                          bool overlay);
+
 public:
   /**
    * @brief Bind the current working audio file.
@@ -44,6 +68,41 @@ class SignalGenerator {
    * @param magnitude the magnitude of the signal.
    */
   void overlaySignal(float freq, float magnitude);
+
+  /**
+   * @brief Generate the sum of the partials on the current audio file.
+   * All the partials are synthesized in one pass over the samples.
+   *
+   * @param partials
+   */
+  void generatePartials(const std::vector<SignalPartial> &partials);
+
+  /**
+   * @brief Overlay the sum of the partials on the exist signal.
+   *
+   * @param partials
+   */
+  void overlayPartials(const std::vector<SignalPartial> &partials);
+
+  /**
+   * @brief Write or add the sum of magnitude * sin(2 pi freq n / sampleRate +
+   * phase) of the partials for the samples n in
+   * [firstSample, firstSample + sampleNum).
+   * The phase is accumulated in double and reseeded exactly every block, and
+   * the sine is a float polynomial, so the error stays near float rounding
+   * at any sample index.
+   *
+   * @param dst sampleNum samples.
+   * @param firstSample the index of dst[0] in the signal.
+   * @param sampleNum
+   * @param partials
+   * @param sampleRate
+   * @param overlay add to dst instead of replacing it.
+   */
+  static void synthesizePartials(float *dst, int64_t firstSample,
+                                 int sampleNum,
+                                 const std::vector<SignalPartial> &partials,
+                                 int sampleRate, bool overlay);
 };
 
 } // namespace hpaslt
@@ -0,0 +1,156 @@
+#include "spectrogram_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace hpaslt {
+
+SpectrogramPyramid::SpectrogramPyramid(AudioSpectrogram &spectrogram,
+                                       int channel, int minFrameNum,
+                                       SpectrogramPooling pooling)
+    : m_binNum(spectrogram.getBinNum()), m_pooling(pooling) {
+  int channelNum = std::max(spectrogram.getRawSpectrogram().size(),
+                            spectrogram.getCompactSpectrogram().size());
+  if (channel < 0 || channel >= channelNum) {
+    throw std::invalid_argument("Spectrogram channel out of range.");
+  }
+
+  // Level 0 is the magnitude of every frame.
+  SpectrogramLevel baseLevel;
+  baseLevel.frameSize = 1;
+  baseLevel.frameNum = spectrogram.getSpectrogramLength();
+  baseLevel.magnitudes.resize((size_t)baseLevel.frameNum * m_binNum);
+  float *magnitudes = baseLevel.magnitudes.data();
+  int64_t binNum = (int64_t)baseLevel.frameNum * m_binNum;
+  if (spectrogram.getFormat() == SpectrogramFormat::Magnitude32) {
+    const float *bins =
+        spectrogram.getCompactSpectrogram()[channel]->getMagnitudes();
+    std::copy_n(bins, binNum, magnitudes);
+  } else if (spectrogram.getFormat() == SpectrogramFormat::Complex32) {
+    const fftwf_complex *bins =
+        spectrogram.getRawSpectrogram()[channel]->getRawSpectrogram();
+#pragma omp parallel for simd schedule(static)
+    for (int64_t i = 0; i < binNum; i++) {
+      magnitudes[i] =
+          std::sqrt(bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1]);
+    }
+  } else {
+    throw std::invalid_argument(
+        "Spectrogram pyramid needs complex or float magnitude bins.");
+  }
+  m_levels.push_back(std::move(baseLevel));
+
+  int prevNum = m_levels[0].frameNum;
+  int frameSize = 2;
+  while (prevNum > minFrameNum) {
+    SpectrogramLevel level;
+    // The last frame may only have one child.
+    level.frameNum = (prevNum + 1) / 2;
+    level.frameSize = frameSize;
+    level.magnitudes.resize((size_t)level.frameNum * m_binNum);
+    m_levels.push_back(std::move(level));
+    reduceLevel(m_levels.size() - 1);
+
+    prevNum = (prevNum + 1) / 2;
+    frameSize *= 2;
+  }
+}
+
+void SpectrogramPyramid::reduceLevel(int level) {
+  SpectrogramLevel &target = m_levels[level];
+  const SpectrogramLevel &prevLevel = m_levels[level - 1];
+  int binNum = m_binNum;
+  int pairNum = prevLevel.frameNum / 2;
+  const float *prev = prevLevel.magnitudes.data();
+  float *dst = target.magnitudes.data();
+
+  // Pool the frames with two children, a frame is binNum contiguous floats.
+#pragma omp parallel for schedule(static) if (pairNum > 256)
+  for (int i = 0; i < pairNum; i++) {
+    const float *first = prev + (size_t)2 * i * binNum;
+    const float *second = first + binNum;
+    float *frame = dst + (size_t)i * binNum;
+    if (m_pooling == SpectrogramPooling::Max) {
+#pragma omp simd
+      for (int bin = 0; bin < binNum; bin++) {
+        frame[bin] = std::max(first[bin], second[bin]);
+      }
+    } else {
+#pragma omp simd
+      for (int bin = 0; bin < binNum; bin++) {
+        frame[bin] = 0.5f * (first[bin] + second[bin]);
+      }
+    }
+  }
+
+  // The single child of the odd tail.
+  if (pairNum < target.frameNum) {
+    std::copy_n(prev + (size_t)2 * pairNum * binNum, binNum,
+                dst + (size_t)pairNum * binNum);
+  }
+}
+
+int SpectrogramPyramid::findLevel(int span, int resolution) const {
+  int level = 0;
+  while (level + 1 < (int)m_levels.size() &&
+         span / m_levels[level + 1].frameSize >= resolution) {
+    level++;
+  }
+  return level;
+}
+
+void SpectrogramPyramid::getSlice(int firstFrame, int lastFrame, int columnNum,
+                                  float *dst) const {
+  if (m_levels.empty() || firstFrame < 0 ||
+      lastFrame > m_levels[0].frameNum || firstFrame >= lastFrame ||
+      columnNum <= 0) {
+    throw std::invalid_argument("Invalid spectrogram slice.");
+  }
+
+  int span = lastFrame - firstFrame;
+  const SpectrogramLevel &level = m_levels[findLevel(span, columnNum)];
+  int binNum = m_binNum;
+
+  for (int column = 0; column < columnNum; column++) {
+    // The frames under the column, at least one when zoomed in past the
+    // frames.
+    int first = firstFrame + (int)((int64_t)span * column / columnNum);
+    int last = firstFrame + (int)((int64_t)span * (column + 1) / columnNum);
+    last = std::max(last, first + 1);
+    int firstLevelFrame = first / level.frameSize;
+    int lastLevelFrame =
+        std::min((last + level.frameSize - 1) / level.frameSize,
+                 level.frameNum);
+
+    float *columnBins = dst + (size_t)column * binNum;
+    const float *frame =
+        level.magnitudes.data() + (size_t)firstLevelFrame * binNum;
+    std::copy_n(frame, binNum, columnBins);
+    for (int levelFrame = firstLevelFrame + 1; levelFrame < lastLevelFrame;
+         levelFrame++) {
+      frame += binNum;
+      if (m_pooling == SpectrogramPooling::Max) {
+#pragma omp simd
+        for (int bin = 0; bin < binNum; bin++) {
+          columnBins[bin] = std::max(columnBins[bin], frame[bin]);
+        }
+      } else {
+#pragma omp simd
+        for (int bin = 0; bin < binNum; bin++) {
+          columnBins[bin] += frame[bin];
+        }
+      }
+    }
+    if (m_pooling == SpectrogramPooling::Mean) {
+      float scale = 1.f / (lastLevelFrame - firstLevelFrame);
+#pragma omp simd
+      for (int bin = 0; bin < binNum; bin++) {
+        columnBins[bin] *= scale;
+      }
+    }
+  }
+}
+
+} // namespace hpaslt
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+
+#include "core/audio_spectrogram/audio_spectrogram.h"
+
+namespace hpaslt {
+
+/**
+ * @brief How the frames of a spectrogram are merged into a coarser level.
+ * Max keeps short transients visible, Mean keeps the average energy.
+ *
+ */
+enum class SpectrogramPooling { Max, Mean };
+
+/**
+ * @brief One level of the spectrogram pyramid.
+ * Frame i covers the spectrogram frames [i * frameSize, (i + 1) * frameSize).
+ *
+ */
+struct SpectrogramLevel {
+  // frameNum * binNum magnitudes, frame by frame.
+  std::vector<float> magnitudes;
+  int frameSize;
+  int frameNum;
+};
+
+/**
+ * @brief A time axis magnitude pyramid of one spectrogram channel.
+ * Level 0 holds the magnitude of every frame, every next level pools pairs of
+ * frames of the level below, so a slice of any zoom is read from the level
+ * with about as many frames as the slice has columns.
+ *
+ */
+class SpectrogramPyramid {
+private:
+  int m_binNum;
+  SpectrogramPooling m_pooling;
+  std::vector<SpectrogramLevel> m_levels;
+
+  /**
+   * @brief Pool the previous level into the level.
+   *
+   * @param level at least 1.
+   */
+  void reduceLevel(int level);
+
+public:
+  /**
+   * @brief Construct an empty SpectrogramPyramid object.
+   *
+   */
+  SpectrogramPyramid() : m_binNum(0), m_pooling(SpectrogramPooling::Max) {}
+
+  /**
+   * @brief Build the pyramid of a generated spectrogram.
+   * Levels are added until a level has at most minFrameNum frames.
+   * The spectrogram must be SpectrogramFormat::Complex32 or Magnitude32.
+   *
+   * @param spectrogram
+   * @param channel
+   * @param minFrameNum
+   * @param pooling
+   */
+  SpectrogramPyramid(AudioSpectrogram &spectrogram, int channel,
+                     int minFrameNum,
+                     SpectrogramPooling pooling = SpectrogramPooling::Max);
+
+  int getBinNum() const { return m_binNum; }
+
+  SpectrogramPooling getPooling() const { return m_pooling; }
+
+  int getNumLevels() const { return m_levels.size(); }
+
+  const SpectrogramLevel &getLevel(int level) const { return m_levels[level]; }
+
+  /**
+   * @brief Find the coarsest level still showing at least resolution frames
+   * of the span.
+   *
+   * @param span the number of spectrogram frames visible.
+   * @param resolution
+   * @return int
+   */
+  int findLevel(int span, int resolution) const;
+
+  /**
+   * @brief Pool the frames [firstFrame, lastFrame) into columns.
+   * Reads the level found for the span, so the cost is about columnNum *
+   * binNum at any zoom.
+   *
+   * @param firstFrame
+   * @param lastFrame
+   * @param columnNum
+   * @param dst columnNum * binNum magnitudes, column by column.
+   */
+  void getSlice(int firstFrame, int lastFrame, int columnNum,
+                float *dst) const;
+};
+
+} // namespace hpaslt
@@ -0,0 +1,269 @@
+#include "spectrogram_tile_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "logger/logger.h"
+
+namespace hpaslt {
+
+SpectrogramTileCache::SpectrogramTileCache(
+    std::shared_ptr<AudioSource> audioSource, const STFTConfig &config,
+    size_t budgetBytes, std::weak_ptr<JobScheduler> jobScheduler)
+    : m_audioSource(audioSource), m_config(config),
+      m_jobScheduler(jobScheduler),
+      m_token(std::make_shared<CancellationToken>()),
+      m_budgetBytes(budgetBytes), m_usedBytes(0), m_frameIndex(0) {
+  if (config.nfft <= 0 || config.hopSize <= 0) {
+    throw std::invalid_argument("STFT nfft and hop size must be positive.");
+  }
+  // Tiles are small, they are transformed in parallel as separate jobs.
+  m_config.mode = SpectrogramMode::RealToComplex;
+  m_config.execution = SpectrogramExecution::Batched;
+  m_config.threadNum = 1;
+  m_binNum = m_config.nfft / 2 + 1;
+
+  // Add levels until one tile covers the whole source.
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
+  m_levelNum = 1;
+  while (getNumFrames(m_levelNum - 1) > SPECTROGRAM_TILE_FRAMES &&
+         getHopSize(m_levelNum - 1) <= sampleNum / 2) {
+    m_levelNum++;
+  }
+}
+
+SpectrogramTileCache::~SpectrogramTileCache() { m_token->cancel(); }
+
+int SpectrogramTileCache::getNumFrames(int level) const {
+  STFTConfig levelConfig = m_config;
+  levelConfig.hopSize = getHopSize(level);
+  return AudioSpectrogram::getFrameNum(
+      levelConfig, m_audioSource->getNumSamplesPerChannel());
+}
+
+int SpectrogramTileCache::findLevel(int span, int resolution) const {
+  int level = 0;
+  while (level + 1 < m_levelNum &&
+         span / getHopSize(level + 1) >= resolution) {
+    level++;
+  }
+  return level;
+}
+
+void SpectrogramTileCache::beginFrame() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_frameIndex++;
+}
+
+void SpectrogramTileCache::evict() {
+  while (m_usedBytes > m_budgetBytes && !m_tileList.empty()) {
+    m_usedBytes -= m_tileList.back().second->getBytes();
+    m_tiles.erase(m_tileList.back().first);
+    m_tileList.pop_back();
+  }
+}
+
+std::shared_ptr<const SpectrogramTile>
+SpectrogramTileCache::findTile(const SpectrogramTileKey &key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto tile = m_tiles.find(key);
+  if (tile == m_tiles.end()) {
+    return nullptr;
+  }
+  // Move the tile to the front of the list.
+  m_tileList.splice(m_tileList.begin(), m_tileList, tile->second);
+  return tile->second->second;
+}
+
+std::shared_ptr<const SpectrogramTile>
+SpectrogramTileCache::requestTile(const SpectrogramTileKey &key) {
+  std::shared_ptr<const SpectrogramTile> tile = findTile(key);
+  if (tile) {
+    return tile;
+  }
+
+  int frameNum = getNumFrames(key.level);
+  if (key.frameBlock < 0 ||
+      key.frameBlock * SPECTROGRAM_TILE_FRAMES >= frameNum ||
+      key.binBlock < 0 || key.binBlock * SPECTROGRAM_TILE_BINS >= m_binNum) {
+    return nullptr;
+  }
+
+  // Wait for the samples under the whole block.
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
+  int loadedSamples = m_audioSource->getLoadedSamples();
+  int lastFrame =
+      std::min((key.frameBlock + 1) * SPECTROGRAM_TILE_FRAMES, frameNum);
+  int64_t lastEnd = (int64_t)lastFrame * getHopSize(key.level) -
+                    getPoolHopSize(key.level) + m_config.nfft;
+  if (loadedSamples < sampleNum && lastEnd > loadedSamples) {
+    return nullptr;
+  }
+
+  // One job transforms the block of all the channels.
+  SpectrogramTileKey blockKey = key;
+  blockKey.channel = 0;
+  blockKey.binBlock = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto pending = m_pendingBlocks.find(blockKey);
+    if (pending != m_pendingBlocks.end()) {
+      // Keep the queued block alive.
+      pending->second = m_frameIndex;
+      return nullptr;
+    }
+    m_pendingBlocks[blockKey] = m_frameIndex;
+  }
+
+  std::shared_ptr<JobScheduler> jobScheduler = m_jobScheduler.lock();
+  if (!jobScheduler) {
+    // Nothing will generate the block, let it be requested again.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingBlocks.erase(blockKey);
+    return nullptr;
+  }
+  std::weak_ptr<SpectrogramTileCache> weakThis = weak_from_this();
+  jobScheduler->submit(
+      [weakThis, blockKey](const CancellationToken &token) {
+        std::shared_ptr<SpectrogramTileCache> cache = weakThis.lock();
+        if (cache) {
+          cache->generateBlock(blockKey, token);
+        }
+      },
+      JobPriority::Normal, m_token);
+  return nullptr;
+}
+
+std::vector<std::shared_ptr<SpectrogramTile>>
+SpectrogramTileCache::transformBlock(const SpectrogramTileKey &blockKey) {
+  // Transform only the pooled frames under the block.
+  int poolNum = getPoolNum(blockKey.level);
+  STFTConfig poolConfig = m_config;
+  poolConfig.hopSize = getPoolHopSize(blockKey.level);
+  AudioSpectrogram spectrogram;
+  spectrogram.generateSTFT(m_audioSource, poolConfig,
+                           blockKey.frameBlock * SPECTROGRAM_TILE_FRAMES *
+                               poolNum,
+                           SPECTROGRAM_TILE_FRAMES * poolNum);
+  int poolFrameNum = spectrogram.getSpectrogramLength();
+  int firstFrame = blockKey.frameBlock * SPECTROGRAM_TILE_FRAMES;
+  int frameNum = std::min(SPECTROGRAM_TILE_FRAMES,
+                          getNumFrames(blockKey.level) - firstFrame);
+  int channelNum = m_audioSource->getNumChannels();
+  int binBlockNum =
+      (m_binNum + SPECTROGRAM_TILE_BINS - 1) / SPECTROGRAM_TILE_BINS;
+
+  // Scale a full scale sine to 0 dB.
+  float decibelOffset = getFullScaleDecibelOffset(spectrogram.getWindow());
+  float minPower = std::pow(10.f, SPECTROGRAM_TILE_MIN_DB / 10.f);
+
+  // Split the block of each channel into bin tiles.
+  std::vector<std::shared_ptr<SpectrogramTile>> tiles;
+  std::vector<float> power(m_binNum);
+  for (int channel = 0; channel < channelNum; channel++) {
+    const fftwf_complex *bins =
+        spectrogram.getRawSpectrogram()[channel]->getRawSpectrogram();
+    for (int binBlock = 0; binBlock < binBlockNum; binBlock++) {
+      std::shared_ptr<SpectrogramTile> tile =
+          std::make_shared<SpectrogramTile>();
+      tile->firstFrame = firstFrame;
+      tile->frameNum = frameNum;
+      tile->firstBin = binBlock * SPECTROGRAM_TILE_BINS;
+      tile->binNum = std::min(SPECTROGRAM_TILE_BINS, m_binNum - tile->firstBin);
+      tile->decibels.resize((size_t)frameNum * tile->binNum);
+
+      int binNum = tile->binNum;
+      for (int frame = 0; frame < frameNum; frame++) {
+        // Max pool the frames under the frame, a padded last frame may start
+        // past the last pooled frame.
+        int first = std::min(frame * poolNum, poolFrameNum - 1);
+        int last = std::clamp(first + poolNum, first + 1, poolFrameNum);
+        std::fill(power.begin(), power.begin() + binNum, minPower);
+        for (int poolFrame = first; poolFrame < last; poolFrame++) {
+          const fftwf_complex *frameBins =
+              bins + (size_t)poolFrame * m_binNum + tile->firstBin;
+          for (int bin = 0; bin < binNum; bin++) {
+            power[bin] = std::max(power[bin],
+                                  frameBins[bin][0] * frameBins[bin][0] +
+                                      frameBins[bin][1] * frameBins[bin][1]);
+          }
+        }
+        float *dst = tile->decibels.data() + (size_t)frame * binNum;
+        // Flip the bins so the highest frequency is the first row.
+        for (int bin = 0; bin < binNum; bin++) {
+          dst[binNum - 1 - bin] = 10.f * std::log10(power[bin]) + decibelOffset;
+        }
+      }
+      tiles.push_back(std::move(tile));
+    }
+  }
+
+  return tiles;
+}
+
+void SpectrogramTileCache::generateBlock(const SpectrogramTileKey &blockKey,
+                                         const CancellationToken &token) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Skip the cancelled blocks and the blocks scrolled out of view while
+    // queued.
+    if (token.isCancelled() || m_frameIndex - m_pendingBlocks[blockKey] >
+                                   SPECTROGRAM_TILE_STALE_FRAMES) {
+      m_pendingBlocks.erase(blockKey);
+      return;
+    }
+  }
+
+  std::vector<std::shared_ptr<SpectrogramTile>> tiles;
+  try {
+    tiles = transformBlock(blockKey);
+  } catch (const std::exception &e) {
+    logger->coreLogger->error(
+        "SpectrogramTileCache cannot transform block {} of level {}, error: "
+        "{}.",
+        blockKey.frameBlock, blockKey.level, e.what());
+    // Let the block be requested again.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingBlocks.erase(blockKey);
+    return;
+  }
+  int binBlockNum =
+      (m_binNum + SPECTROGRAM_TILE_BINS - 1) / SPECTROGRAM_TILE_BINS;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pendingBlocks.erase(blockKey);
+  if (token.isCancelled()) {
+    return;
+  }
+  for (size_t i = 0; i < tiles.size(); i++) {
+    SpectrogramTileKey key = blockKey;
+    key.channel = i / binBlockNum;
+    key.binBlock = i % binBlockNum;
+    if (m_tiles.contains(key)) {
+      continue;
+    }
+    m_tileList.emplace_front(key, tiles[i]);
+    m_tiles[key] = m_tileList.begin();
+    m_usedBytes += tiles[i]->getBytes();
+  }
+  evict();
+}
+
+void SpectrogramTileCache::setBudget(size_t budgetBytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budgetBytes = budgetBytes;
+  evict();
+}
+
+size_t SpectrogramTileCache::getBudget() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budgetBytes;
+}
+
+size_t SpectrogramTileCache::getUsedBytes() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_usedBytes;
+}
+
+} // namespace hpaslt
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "core/audio_source/audio_source.h"
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/job_scheduler/job_scheduler.h"
+
+/**
+ * @brief The number of frames of a tile. Frames of one tile are transformed
+ * together by one job.
+ *
+ */
+#define SPECTROGRAM_TILE_FRAMES 256
+
+/**
+ * @brief The number of bins of a tile.
+ *
+ */
+#define SPECTROGRAM_TILE_BINS 256
+
+/**
+ * @brief Queued blocks not requested for this many frames are skipped when a
+ * worker reaches them.
+ *
+ */
+#define SPECTROGRAM_TILE_STALE_FRAMES 2
+
+/**
+ * @brief The most frames a frame of a coarse level max pools.
+ *
+ */
+#define SPECTROGRAM_TILE_POOL_FRAMES 4
+
+/**
+ * @brief The magnitude of a silent bin in dB.
+ *
+ */
+#define SPECTROGRAM_TILE_MIN_DB -200.f
+
+namespace hpaslt {
+
+/**
+ * @brief The position of a tile.
+ * Frames of level l are 2^l hops apart. Each one max pools the power of up to
+ * SPECTROGRAM_TILE_POOL_FRAMES frames evenly spaced over its 2^l hops, so the
+ * first levels keep every transient while zoomed out views still transform a
+ * bounded number of frames instead of every frame. Past
+ * log2(SPECTROGRAM_TILE_POOL_FRAMES) the hops between the pooled frames are
+ * subsampled.
+ *
+ */
+struct SpectrogramTileKey {
+  int channel;
+  int level;
+  int frameBlock;
+  int binBlock;
+
+  bool operator==(const SpectrogramTileKey &) const = default;
+};
+
+struct SpectrogramTileKeyHash {
+  size_t operator()(const SpectrogramTileKey &key) const {
+    uint64_t hash = (uint64_t)key.channel;
+    hash = hash * 31 + (uint64_t)key.level;
+    hash = hash * 0x9E3779B97F4A7C15ull + (uint64_t)key.frameBlock;
+    hash = hash * 0x9E3779B97F4A7C15ull + (uint64_t)key.binBlock;
+    return hash ^ (hash >> 29);
+  }
+};
+
+/**
+ * @brief A block of frames x bins of magnitudes in dB.
+ * The tile is laid out as an ImPlot column major heatmap: frame by frame, the
+ * highest bin first.
+ *
+ */
+struct SpectrogramTile {
+  // The first frame at the level of the tile.
+  int firstFrame;
+  int frameNum;
+  int firstBin;
+  int binNum;
+  // Bin b of frame f is at decibels[f * binNum + binNum - 1 - b].
+  std::vector<float> decibels;
+
+  size_t getBytes() const {
+    return sizeof(SpectrogramTile) + decibels.size() * sizeof(float);
+  }
+};
+
+/**
+ * @brief A least recently used cache of spectrogram tiles of one audio source.
+ * Missing tiles are transformed on the JobScheduler, only the frames under
+ * the requested tiles are ever read. The tiles are evicted once they exceed
+ * the memory budget. This class is thread safe.
+ *
+ */
+class SpectrogramTileCache
+    : public std::enable_shared_from_this<SpectrogramTileCache> {
+private:
+  using TileList =
+      std::list<std::pair<SpectrogramTileKey,
+                          std::shared_ptr<const SpectrogramTile>>>;
+
+  std::shared_ptr<AudioSource> m_audioSource;
+  STFTConfig m_config;
+  int m_binNum;
+  int m_levelNum;
+
+  std::weak_ptr<JobScheduler> m_jobScheduler;
+
+  /**
+   * @brief Cancelled when the cache is destroyed.
+   *
+   */
+  std::shared_ptr<CancellationToken> m_token;
+
+  /**
+   * @brief Guard all the members below.
+   *
+   */
+  std::mutex m_mutex;
+
+  size_t m_budgetBytes;
+  size_t m_usedBytes;
+
+  /**
+   * @brief The tiles, the most recently used first.
+   *
+   */
+  TileList m_tileList;
+  std::unordered_map<SpectrogramTileKey, TileList::iterator,
+                     SpectrogramTileKeyHash>
+      m_tiles;
+
+  /**
+   * @brief The frame blocks queued, with the last frame they were requested.
+   * The channel and bin block of the keys are 0.
+   *
+   */
+  std::unordered_map<SpectrogramTileKey, uint64_t, SpectrogramTileKeyHash>
+      m_pendingBlocks;
+
+  /**
+   * @brief Counted up by beginFrame.
+   *
+   */
+  uint64_t m_frameIndex;
+
+  /**
+   * @brief Evict the least recently used tiles until the budget is met.
+   * m_mutex must be held.
+   *
+   */
+  void evict();
+
+  /**
+   * @brief Transform a frame block into the bin tiles of all the channels.
+   * The pooled frames of the level are transformed and max pooled.
+   *
+   * @param blockKey
+   * @return std::vector<std::shared_ptr<SpectrogramTile>> the tiles channel
+   * by channel, bin block by bin block.
+   */
+  std::vector<std::shared_ptr<SpectrogramTile>>
+  transformBlock(const SpectrogramTileKey &blockKey);
+
+  /**
+   * @brief Transform a frame block and insert the bin tiles of all the
+   * channels.
+   * A block that fails to transform is logged and can be requested again.
+   * Runs on the JobScheduler.
+   *
+   * @param blockKey
+   * @param token
+   */
+  void generateBlock(const SpectrogramTileKey &blockKey,
+                     const CancellationToken &token);
+
+public:
+  /**
+   * @brief Construct a new SpectrogramTileCache object.
+   *
+   * @param audioSource
+   * @param config the STFT parameters of level 0. The mode and thread number
+   * are ignored, tiles are real to complex transforms on one thread.
+   * @param budgetBytes the memory budget of the tiles.
+   * @param jobScheduler transforms the missing tiles.
+   */
+  SpectrogramTileCache(std::shared_ptr<AudioSource> audioSource,
+                       const STFTConfig &config, size_t budgetBytes,
+                       std::weak_ptr<JobScheduler> jobScheduler);
+
+  /**
+   * @brief Disable the default copy constructor for SpectrogramTileCache.
+   *
+   */
+  SpectrogramTileCache(const SpectrogramTileCache &) = delete;
+
+  /**
+   * @brief Cancel the queued tiles.
+   *
+   */
+  ~SpectrogramTileCache();
+
+  std::shared_ptr<AudioSource> getAudioSource() { return m_audioSource; }
+
+  const STFTConfig &getConfig() const { return m_config; }
+
+  int getBinNum() const { return m_binNum; }
+
+  int getNumLevels() const { return m_levelNum; }
+
+  /**
+   * @brief Get the number of samples between two frames of the level.
+   *
+   * @param level
+   * @return int
+   */
+  int getHopSize(int level) const { return m_config.hopSize << level; }
+
+  /**
+   * @brief Get the number of frames a frame of the level max pools.
+   *
+   * @param level
+   * @return int
+   */
+  int getPoolNum(int level) const {
+    return std::min(1 << level, SPECTROGRAM_TILE_POOL_FRAMES);
+  }
+
+  /**
+   * @brief Get the number of samples between two pooled frames of the level.
+   *
+   * @param level
+   * @return int
+   */
+  int getPoolHopSize(int level) const {
+    return getHopSize(level) / getPoolNum(level);
+  }
+
+  /**
+   * @brief Get the number of frames of the level.
+   *
+   * @param level
+   * @return int
+   */
+  int getNumFrames(int level) const;
+
+  /**
+   * @brief Find the coarsest level still showing at least resolution frames
+   * of the span.
+   *
+   * @param span the number of samples visible.
+   * @param resolution
+   * @return int
+   */
+  int findLevel(int span, int resolution) const;
+
+  /**
+   * @brief Start a new frame of requests.
+   * Queued tiles not requested in the last SPECTROGRAM_TILE_STALE_FRAMES
+   * frames are skipped, so panning only transforms what stays visible.
+   *
+   */
+  void beginFrame();
+
+  /**
+   * @brief Get a tile, queue the transform if it is missing.
+   * Tiles reaching past the loaded samples of a progressive load are not
+   * queued until the samples arrive.
+   *
+   * @param key
+   * @return std::shared_ptr<const SpectrogramTile> nullptr if the tile is not
+   * ready yet.
+   */
+  std::shared_ptr<const SpectrogramTile>
+  requestTile(const SpectrogramTileKey &key);
+
+  /**
+   * @brief Get a tile without queueing it, for example a coarser tile to
+   * draw until the requested one is ready.
+   *
+   * @param key
+   * @return std::shared_ptr<const SpectrogramTile> nullptr if the tile is not
+   * cached.
+   */
+  std::shared_ptr<const SpectrogramTile>
+  findTile(const SpectrogramTileKey &key);
+
+  /**
+   * @brief Set the memory budget, evicting tiles over it.
+   *
+   * @param budgetBytes
+   */
+  void setBudget(size_t budgetBytes);
+
+  size_t getBudget();
+
+  size_t getUsedBytes();
+};
+
+} // namespace hpaslt
@@ -0,0 +1,235 @@
+#include "spectrum_analyzer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include "core/fft_plan_cache/fft_plan_cache.h"
+#include "core/fft_wisdom/fft_wisdom.h"
+
+/**
+ * @brief How long the enabled analysis thread sleeps between draining the
+ * ring.
+ *
+ */
+#define SPECTRUM_ANALYZER_IDLE_US 2000
+/**
+ * @brief Maximum number of frames the analysis thread reads at a time.
+ *
+ */
+#define SPECTRUM_ANALYZER_CHUNK_FRAMES 1024
+
+namespace hpaslt {
+
+SpectrumAnalyzer::SpectrumAnalyzer(int channelNum, int sampleRate)
+    : m_channelNum(channelNum), m_sampleRate(sampleRate),
+      m_tapRing((size_t)SPECTRUM_ANALYZER_RING_FRAMES *
+                std::max(1, channelNum)),
+      m_droppedFrames(0), m_enabled(false), m_nfft(4096),
+      m_window(WindowFunction::Hann), m_updateRate(30), m_publishedFrame(-1),
+      m_readingFrame(-1), m_stopAnalysis(false) {
+  if (channelNum <= 0 || sampleRate <= 0) {
+    throw std::invalid_argument(
+        "Spectrum analyzer needs channels and a sample rate.");
+  }
+
+  m_analysisThread = std::thread(&SpectrumAnalyzer::analysisLoop, this);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+  {
+    std::lock_guard<std::mutex> lock(m_enableMutex);
+    m_stopAnalysis.store(true, std::memory_order_release);
+  }
+  m_enableCondition.notify_one();
+  m_analysisThread.join();
+}
+
+void SpectrumAnalyzer::setEnabled(bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(m_enableMutex);
+    m_enabled.store(enabled, std::memory_order_relaxed);
+  }
+  m_enableCondition.notify_one();
+}
+
+void SpectrumAnalyzer::setNfft(int nfft) {
+  if (nfft < 2 || nfft > SPECTRUM_ANALYZER_MAX_NFFT) {
+    throw std::invalid_argument("Spectrum analyzer nfft out of range.");
+  }
+  m_nfft.store(nfft, std::memory_order_relaxed);
+}
+
+void SpectrumAnalyzer::setUpdateRate(float updateRate) {
+  if (!(updateRate > 0)) {
+    throw std::invalid_argument(
+        "Spectrum analyzer update rate must be positive.");
+  }
+  m_updateRate.store(updateRate, std::memory_order_relaxed);
+}
+
+void SpectrumAnalyzer::push(const float *frames, int frameNum) {
+  if (!m_enabled.load(std::memory_order_relaxed) || frameNum <= 0) {
+    return;
+  }
+
+  // Only whole frames, the rest is dropped instead of waiting.
+  size_t frameCount = std::min((size_t)frameNum,
+                               m_tapRing.writeAvailable() / m_channelNum);
+  m_tapRing.write(frames, frameCount * m_channelNum);
+  if (frameCount < (size_t)frameNum) {
+    m_droppedFrames.fetch_add(frameNum - frameCount,
+                              std::memory_order_relaxed);
+  }
+}
+
+bool SpectrumAnalyzer::publish(const std::vector<float> &decibels, int nfft) {
+  // Only this thread stores the published frame.
+  int published = m_publishedFrame.load(std::memory_order_relaxed);
+  int back = published == 0 ? 1 : 0;
+
+  // The reader announces the frame it copies before it checks the published
+  // frame again, so either it sees the newer frame or this sees it reading.
+  if (m_readingFrame.load(std::memory_order_seq_cst) == back) {
+    return false;
+  }
+
+  SpectrumFrame &frame = m_frames[back];
+  frame.decibels.assign(decibels.begin(), decibels.end());
+  frame.nfft = nfft;
+  frame.sampleRate = m_sampleRate;
+  frame.sequence = published < 0 ? 1 : m_frames[published].sequence + 1;
+  m_publishedFrame.store(back, std::memory_order_seq_cst);
+  return true;
+}
+
+bool SpectrumAnalyzer::readFrame(SpectrumFrame &dst) {
+  int frame = m_publishedFrame.load(std::memory_order_seq_cst);
+  while (true) {
+    if (frame < 0) {
+      return false;
+    }
+    // Hold the frame, then make sure it is still the published one.
+    m_readingFrame.store(frame, std::memory_order_seq_cst);
+    int published = m_publishedFrame.load(std::memory_order_seq_cst);
+    if (published == frame) {
+      break;
+    }
+    frame = published;
+  }
+
+  dst = m_frames[frame];
+  m_readingFrame.store(-1, std::memory_order_release);
+  return true;
+}
+
+void SpectrumAnalyzer::analysisLoop() {
+  std::shared_ptr<FFTPlanCache> planCache = FFTPlanCache::getSingleton().lock();
+
+  // The latest downmixed samples, SPECTRUM_ANALYZER_MAX_NFFT is a power of 2.
+  const size_t historyMask = SPECTRUM_ANALYZER_MAX_NFFT - 1;
+  std::vector<float> history(SPECTRUM_ANALYZER_MAX_NFFT, 0.f);
+  size_t historyEnd = 0;
+  std::vector<float> chunk((size_t)SPECTRUM_ANALYZER_CHUNK_FRAMES *
+                           m_channelNum);
+  float channelScale = 1.f / m_channelNum;
+
+  // The fft buffers hold the largest frame, so the plan alignment never
+  // changes.
+  float *frame = fftwf_alloc_real(SPECTRUM_ANALYZER_MAX_NFFT);
+  fftwf_complex *bins =
+      fftwf_alloc_complex(SPECTRUM_ANALYZER_MAX_NFFT / 2 + 1);
+  fftwf_plan plan = nullptr;
+  int nfft = 0;
+  WindowFunction windowFunction = WindowFunction::Rectangular;
+  std::vector<float> window;
+  std::vector<float> decibels;
+  float decibelOffset = 0;
+
+  bool received = false;
+  auto nextUpdate = std::chrono::steady_clock::now();
+
+  while (!m_stopAnalysis.load(std::memory_order_acquire)) {
+    // Block while disabled, nothing is pushed then.
+    if (!m_enabled.load(std::memory_order_relaxed)) {
+      std::unique_lock<std::mutex> lock(m_enableMutex);
+      m_enableCondition.wait(lock, [this]() {
+        return m_stopAnalysis.load(std::memory_order_acquire) ||
+               m_enabled.load(std::memory_order_relaxed);
+      });
+      nextUpdate = std::chrono::steady_clock::now();
+      continue;
+    }
+
+    // Drain the ring into the history, the ring only holds whole frames.
+    size_t readNum;
+    while ((readNum = m_tapRing.read(chunk.data(), chunk.size())) > 0) {
+      int frameNum = readNum / m_channelNum;
+      for (int i = 0; i < frameNum; i++) {
+        float sum = 0;
+        for (int channel = 0; channel < m_channelNum; channel++) {
+          sum += chunk[(size_t)i * m_channelNum + channel];
+        }
+        history[(historyEnd + i) & historyMask] = sum * channelScale;
+      }
+      historyEnd += frameNum;
+      received = true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!received || now < nextUpdate) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(SPECTRUM_ANALYZER_IDLE_US));
+      continue;
+    }
+
+    // Pick up the new settings.
+    int targetNfft = m_nfft.load(std::memory_order_relaxed);
+    WindowFunction targetWindow = m_window.load(std::memory_order_relaxed);
+    if (targetNfft != nfft || targetWindow != windowFunction) {
+      nfft = targetNfft;
+      windowFunction = targetWindow;
+      window = generateWindow(windowFunction, nfft);
+      // Scale a full scale sine to 0 dB.
+      decibelOffset = getFullScaleDecibelOffset(window);
+      decibels.resize(nfft / 2 + 1);
+      plan = planCache->getRealToComplexPlan(nfft, frame, bins,
+                                             FFTWisdom::getPlannerFlags());
+    }
+
+    // Window the latest nfft samples.
+    size_t start = historyEnd - nfft;
+    for (int i = 0; i < nfft; i++) {
+      frame[i] = history[(start + i) & historyMask] * window[i];
+    }
+    fftwf_execute_dft_r2c(plan, frame, bins);
+
+    for (int bin = 0; bin < nfft / 2 + 1; bin++) {
+      float power = bins[bin][0] * bins[bin][0] + bins[bin][1] * bins[bin][1];
+      decibels[bin] = power > 0
+                          ? std::max(SPECTRUM_ANALYZER_MIN_DB,
+                                     10.f * std::log10(power) + decibelOffset)
+                          : SPECTRUM_ANALYZER_MIN_DB;
+    }
+
+    // A frame dropped while the reader holds the back buffer is replaced by
+    // the next one.
+    if (publish(decibels, nfft)) {
+      received = false;
+      std::chrono::duration<float> period(
+          1.f / m_updateRate.load(std::memory_order_relaxed));
+      nextUpdate +=
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              period);
+      // Do not catch up on the updates missed while idle.
+      nextUpdate = std::max(nextUpdate, now);
+    }
+  }
+
+  fftwf_free(frame);
+  fftwf_free(bins);
+}
+
+} // namespace hpaslt
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <fftw3.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/ring_buffer/ring_buffer.h"
+#include "core/window_function/window_function.h"
+
+/**
+ * @brief The largest fft size of the SpectrumAnalyzer.
+ *
+ */
+#define SPECTRUM_ANALYZER_MAX_NFFT 16384
+/**
+ * @brief The number of frames the tap ring holds, frames pushed into a full
+ * ring are dropped.
+ *
+ */
+#define SPECTRUM_ANALYZER_RING_FRAMES 32768
+/**
+ * @brief The floor of the published dB magnitudes.
+ *
+ */
+#define SPECTRUM_ANALYZER_MIN_DB -200.f
+
+namespace hpaslt {
+
+/**
+ * @brief One magnitude frame published by the SpectrumAnalyzer.
+ *
+ */
+struct SpectrumFrame {
+  // nfft / 2 + 1 magnitudes in dB, 0 dB is a full scale sine.
+  std::vector<float> decibels;
+  int nfft = 0;
+  int sampleRate = 0;
+  // Incremented for every published frame, starting at 1.
+  uint64_t sequence = 0;
+};
+
+/**
+ * @brief A live spectrum of the frames an audio callback plays.
+ * The audio thread pushes interleaved frames into a lock free ring. An
+ * analysis thread downmixes them into a history, runs a windowed real to
+ * complex fft of the latest nfft samples at the update rate and publishes the
+ * magnitudes through a double buffer, which one reader thread copies without
+ * locks.
+ *
+ */
+class SpectrumAnalyzer {
+private:
+  int m_channelNum;
+  int m_sampleRate;
+
+  /**
+   * @brief Interleaved frames from the audio thread to the analysis thread.
+   *
+   */
+  SPSCRingBuffer<float> m_tapRing;
+
+  /**
+   * @brief The number of frames the audio thread dropped on a full ring.
+   *
+   */
+  std::atomic<uint64_t> m_droppedFrames;
+
+  /* ------------------------ Settings ------------------------ */
+
+  std::atomic<bool> m_enabled;
+  std::atomic<int> m_nfft;
+  std::atomic<WindowFunction> m_window;
+  // Published frames per second.
+  std::atomic<float> m_updateRate;
+
+  /* ---------------------- Double buffer --------------------- */
+
+  /**
+   * @brief The two frames, the analysis thread only writes the frame that is
+   * neither published nor being read.
+   *
+   */
+  SpectrumFrame m_frames[2];
+
+  /**
+   * @brief The index of the latest published frame, -1 before the first.
+   *
+   */
+  std::atomic<int> m_publishedFrame;
+
+  /**
+   * @brief The index of the frame the reader is copying, -1 if none.
+   *
+   */
+  std::atomic<int> m_readingFrame;
+
+  std::thread m_analysisThread;
+  std::atomic<bool> m_stopAnalysis;
+
+  /**
+   * @brief Wake the analysis thread blocked while disabled.
+   *
+   */
+  std::mutex m_enableMutex;
+  std::condition_variable m_enableCondition;
+
+  /**
+   * @brief Drain the ring and publish frames until stopped.
+   *
+   */
+  void analysisLoop();
+
+  /**
+   * @brief Publish a frame of magnitudes.
+   * Only call this method from the analysis thread.
+   *
+   * @param decibels
+   * @param nfft
+   * @return false if the reader holds the back frame, the magnitudes are
+   * dropped.
+   */
+  bool publish(const std::vector<float> &decibels, int nfft);
+
+public:
+  /**
+   * @brief Construct a new SpectrumAnalyzer object and start the analysis
+   * thread. The analyzer starts disabled, the thread sleeps until it is
+   * enabled.
+   *
+   * @param channelNum the number of interleaved channels pushed.
+   * @param sampleRate
+   */
+  SpectrumAnalyzer(int channelNum, int sampleRate);
+
+  /**
+   * @brief Disable the default copy constructor for SpectrumAnalyzer.
+   *
+   */
+  SpectrumAnalyzer(const SpectrumAnalyzer &) = delete;
+
+  /**
+   * @brief Stop and join the analysis thread.
+   *
+   */
+  ~SpectrumAnalyzer();
+
+  int getChannelNum() const { return m_channelNum; }
+
+  int getSampleRate() const { return m_sampleRate; }
+
+  /**
+   * @brief Queue interleaved frames for analysis.
+   * Real time safe: returns at once while disabled, otherwise one bounded
+   * copy into the ring. Frames that do not fit are dropped. Only call this
+   * method from one thread.
+   *
+   * @param frames
+   * @param frameNum
+   */
+  void push(const float *frames, int frameNum);
+
+  /**
+   * @brief Copy the latest published frame.
+   * Never blocks the analysis thread. Only call this method from one thread.
+   *
+   * @param dst
+   * @return false if no frame has been published yet.
+   */
+  bool readFrame(SpectrumFrame &dst);
+
+  uint64_t getDroppedFrames() const {
+    return m_droppedFrames.load(std::memory_order_relaxed);
+  }
+
+  bool getEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Start or stop the analysis. Frames pushed while disabled are
+   * ignored and the analysis thread blocks.
+   *
+   * @param enabled
+   */
+  void setEnabled(bool enabled);
+
+  int getNfft() const { return m_nfft.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Set the fft size of the next frames.
+   *
+   * @param nfft in [2, SPECTRUM_ANALYZER_MAX_NFFT].
+   */
+  void setNfft(int nfft);
+
+  WindowFunction getWindow() const {
+    return m_window.load(std::memory_order_relaxed);
+  }
+
+  void setWindow(WindowFunction window) {
+    m_window.store(window, std::memory_order_relaxed);
+  }
+
+  float getUpdateRate() const {
+    return m_updateRate.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Set the number of frames published per second.
+   *
+   * @param updateRate positive.
+   */
+  void setUpdateRate(float updateRate);
+};
+
+} // namespace hpaslt
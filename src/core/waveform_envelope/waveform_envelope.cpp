@@ -0,0 +1,169 @@
+#include "waveform_envelope.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace hpaslt {
+
+WaveformEnvelope::WaveformEnvelope(int sampleNum, int minBinNum, bool hasRms)
+    : m_sampleNum(sampleNum), m_loadedSamples(0), m_hasRms(hasRms) {
+  int prevNum = sampleNum;
+  int binSize = 2;
+  while (prevNum > minBinNum) {
+    EnvelopeLevel level;
+    // The last bin may only have one child.
+    level.binNum = (prevNum + 1) / 2;
+    level.binSize = binSize;
+    level.loadedBins = 0;
+    level.min.resize(level.binNum);
+    level.max.resize(level.binNum);
+    if (hasRms) {
+      level.meanSquare.resize(level.binNum);
+    }
+    m_levels.push_back(std::move(level));
+
+    prevNum = (prevNum + 1) / 2;
+    binSize *= 2;
+  }
+}
+
+void WaveformEnvelope::reduceLevel(const float *samples, int firstSample,
+                                   int level, int firstBin, int lastBin) {
+  EnvelopeLevel &target = m_levels[level];
+  // The previous level, or the samples for level 0. Index i of the previous
+  // level is at prevMin[i - prevOffset].
+  const float *prevMin = samples;
+  const float *prevMax = samples;
+  const float *prevMeanSquare = nullptr;
+  int prevOffset = firstSample;
+  int prevNum = m_sampleNum;
+  if (level > 0) {
+    const EnvelopeLevel &prevLevel = m_levels[level - 1];
+    prevMin = prevLevel.min.data();
+    prevMax = prevLevel.max.data();
+    prevMeanSquare = m_hasRms ? prevLevel.meanSquare.data() : nullptr;
+    prevOffset = 0;
+    prevNum = prevLevel.binNum;
+  }
+
+  // The pairs with two children.
+  int pairEnd = std::min(lastBin, prevNum / 2);
+
+  float *levelMin = target.min.data();
+  float *levelMax = target.max.data();
+#pragma omp simd
+  for (int i = firstBin; i < pairEnd; i++) {
+    int j = 2 * i - prevOffset;
+    levelMin[i] = std::min(prevMin[j], prevMin[j + 1]);
+    levelMax[i] = std::max(prevMax[j], prevMax[j + 1]);
+  }
+  if (m_hasRms) {
+    float *levelMeanSquare = target.meanSquare.data();
+    if (prevMeanSquare) {
+#pragma omp simd
+      for (int i = firstBin; i < pairEnd; i++) {
+        int j = 2 * i - prevOffset;
+        levelMeanSquare[i] = 0.5f * (prevMeanSquare[j] + prevMeanSquare[j + 1]);
+      }
+    } else {
+#pragma omp simd
+      for (int i = firstBin; i < pairEnd; i++) {
+        int j = 2 * i - prevOffset;
+        levelMeanSquare[i] =
+            0.5f * (samples[j] * samples[j] + samples[j + 1] * samples[j + 1]);
+      }
+    }
+  }
+
+  // The single child of the odd tail.
+  for (int i = std::max(firstBin, pairEnd); i < lastBin; i++) {
+    int j = 2 * i - prevOffset;
+    levelMin[i] = prevMin[j];
+    levelMax[i] = prevMax[j];
+    if (m_hasRms) {
+      target.meanSquare[i] =
+          prevMeanSquare ? prevMeanSquare[j] : samples[j] * samples[j];
+    }
+  }
+}
+
+void WaveformEnvelope::extend(const float *samples, int firstSample,
+                              int loadedSamples) {
+  loadedSamples = std::min(loadedSamples, m_sampleNum);
+  if (loadedSamples <= m_loadedSamples) {
+    return;
+  }
+  m_loadedSamples = loadedSamples;
+
+  // The bins each level can compute now. A bin is complete once both
+  // children are, the odd tail once the previous level is complete.
+  int levelNum = m_levels.size();
+  std::vector<int> firstBins(levelNum);
+  std::vector<int> lastBins(levelNum);
+  int prevNum = m_sampleNum;
+  int prevLoaded = loadedSamples;
+  for (int level = 0; level < levelNum; level++) {
+    firstBins[level] = m_levels[level].loadedBins;
+    lastBins[level] = std::max(firstBins[level], prevLoaded == prevNum
+                                                     ? m_levels[level].binNum
+                                                     : prevLoaded / 2);
+    prevNum = m_levels[level].binNum;
+    prevLoaded = lastBins[level];
+  }
+
+  // Levels with bins inside a tile only depend on the same tile, so every
+  // tile computes all of them while its samples are still in the cache.
+  int tiledLevelNum = 0;
+  int firstTile = loadedSamples / WAVEFORM_ENVELOPE_TILE_SAMPLES;
+  while (tiledLevelNum < levelNum &&
+         m_levels[tiledLevelNum].binSize <= WAVEFORM_ENVELOPE_TILE_SAMPLES) {
+    firstTile = std::min(firstTile,
+                         (int)((int64_t)firstBins[tiledLevelNum] *
+                               m_levels[tiledLevelNum].binSize /
+                               WAVEFORM_ENVELOPE_TILE_SAMPLES));
+    tiledLevelNum++;
+  }
+  int lastTile = (loadedSamples + WAVEFORM_ENVELOPE_TILE_SAMPLES - 1) /
+                 WAVEFORM_ENVELOPE_TILE_SAMPLES;
+
+#pragma omp parallel for schedule(dynamic) if (lastTile - firstTile > 1)
+  for (int tile = firstTile; tile < lastTile; tile++) {
+    for (int level = 0; level < tiledLevelNum; level++) {
+      int tileBinNum =
+          WAVEFORM_ENVELOPE_TILE_SAMPLES / m_levels[level].binSize;
+      int firstBin = std::max(firstBins[level], tile * tileBinNum);
+      int lastBin = std::min(lastBins[level], (tile + 1) * tileBinNum);
+      if (firstBin < lastBin) {
+        reduceLevel(samples, firstSample, level, firstBin, lastBin);
+      }
+    }
+  }
+
+  // The coarse levels are small, merge the tiles serially.
+  for (int level = tiledLevelNum; level < levelNum; level++) {
+    reduceLevel(samples, firstSample, level, firstBins[level], lastBins[level]);
+  }
+
+  for (int level = 0; level < levelNum; level++) {
+    m_levels[level].loadedBins = lastBins[level];
+  }
+}
+
+int WaveformEnvelope::getNextSample() const {
+  if (m_levels.empty()) {
+    return m_loadedSamples;
+  }
+  // An unpaired sample is reduced with the next extend.
+  return std::min(2 * m_levels[0].loadedBins, m_loadedSamples);
+}
+
+int WaveformEnvelope::findLevel(int span, int resolution) const {
+  int level = -1;
+  while (level + 1 < (int)m_levels.size() &&
+         span / m_levels[level + 1].binSize >= resolution) {
+    level++;
+  }
+  return level;
+}
+
+} // namespace hpaslt
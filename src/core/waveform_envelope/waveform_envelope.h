@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief The number of samples reduced by one thread at once. A power of 2,
+ * the tile and all its levels fit into the L2 cache.
+ *
+ */
+#define WAVEFORM_ENVELOPE_TILE_SAMPLES 65536
+
+namespace hpaslt {
+
+/**
+ * @brief One level of the envelope pyramid.
+ * Bin i covers the samples [i * binSize, (i + 1) * binSize), the time of a
+ * bin is implicit in its index.
+ *
+ */
+struct EnvelopeLevel {
+  std::vector<float> min;
+  std::vector<float> max;
+  // The mean square of the bin, empty if the envelope has no RMS.
+  std::vector<float> meanSquare;
+  int binSize;
+  int binNum;
+  // The number of bins computed so far.
+  int loadedBins;
+};
+
+/**
+ * @brief A min/max envelope pyramid of one channel.
+ * Level 0 reduces pairs of samples, every next level reduces pairs of bins of
+ * the level below, so each level is computed in a single pass over the
+ * previous one. The samples are split into tiles reduced in parallel. The
+ * samples themselves are not stored.
+ *
+ */
+class WaveformEnvelope {
+private:
+  int m_sampleNum;
+  int m_loadedSamples;
+  bool m_hasRms;
+  std::vector<EnvelopeLevel> m_levels;
+
+  /**
+   * @brief Compute the bins [firstBin, lastBin) of the level from the level
+   * below.
+   *
+   * @param samples
+   * @param firstSample the index of samples[0].
+   * @param level
+   * @param firstBin
+   * @param lastBin
+   */
+  void reduceLevel(const float *samples, int firstSample, int level,
+                   int firstBin, int lastBin);
+
+public:
+  /**
+   * @brief Construct an empty WaveformEnvelope object.
+   *
+   */
+  WaveformEnvelope() : m_sampleNum(0), m_loadedSamples(0), m_hasRms(false) {}
+
+  /**
+   * @brief Allocate the levels for the samples.
+   * Levels are added until a level has at most minBinNum bins.
+   *
+   * @param sampleNum the number of samples of the channel.
+   * @param minBinNum
+   * @param hasRms also compute the mean square of each bin.
+   */
+  WaveformEnvelope(int sampleNum, int minBinNum, bool hasRms = false);
+
+  /**
+   * @brief Compute the bins covered by the newly loaded samples.
+   * Can be called repeatedly while the samples are being loaded.
+   *
+   * @param samples the samples from firstSample to loadedSamples.
+   * @param firstSample the index of samples[0], at most getNextSample().
+   * @param loadedSamples the number of valid samples, never decreases.
+   */
+  void extend(const float *samples, int firstSample, int loadedSamples);
+
+  /**
+   * @brief Compute the bins covered by the newly loaded samples.
+   *
+   * @param samples all the samples of the channel, the first loadedSamples
+   * must be valid.
+   * @param loadedSamples the number of valid samples, never decreases.
+   */
+  void extend(const float *samples, int loadedSamples) {
+    extend(samples, 0, loadedSamples);
+  }
+
+  /**
+   * @brief Get the first sample the next extend reads.
+   * Callers extending from a window of the samples must start it here.
+   *
+   * @return int
+   */
+  int getNextSample() const;
+
+  int getNumSamples() const { return m_sampleNum; }
+
+  int getLoadedSamples() const { return m_loadedSamples; }
+
+  bool hasRms() const { return m_hasRms; }
+
+  int getNumLevels() const { return m_levels.size(); }
+
+  const EnvelopeLevel &getLevel(int level) const { return m_levels[level]; }
+
+  /**
+   * @brief Find the coarsest level still showing at least resolution bins of
+   * the span.
+   *
+   * @param span the number of samples visible.
+   * @param resolution
+   * @return int the level, -1 if the samples should be drawn directly.
+   */
+  int findLevel(int span, int resolution) const;
+};
+
+} // namespace hpaslt
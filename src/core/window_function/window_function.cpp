@@ -0,0 +1,82 @@
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include "window_function.h"
+
+#include <math.h>
+
+namespace hpaslt {
+
+/**
+ * @brief Zeroth order modified Bessel function of the first kind.
+ * std::cyl_bessel_i is not available on every standard library we build with,
+ * so use the power series directly.
+ *
+ * @param x
+ * @return double
+ */
+static double besselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  double halfX = x / 2;
+  for (int k = 1; k < 64; k++) {
+    term *= (halfX / k) * (halfX / k);
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+std::vector<float> generateWindow(WindowFunction function, int size,
+                                  float kaiserBeta) {
+  std::vector<float> window(size, 1);
+  if (size <= 1) {
+    return window;
+  }
+
+  switch (function) {
+  case WindowFunction::Rectangular:
+    break;
+  case WindowFunction::Hann:
+    for (int i = 0; i < size; i++) {
+      window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / size);
+    }
+    break;
+  case WindowFunction::Hamming:
+    for (int i = 0; i < size; i++) {
+      window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / size);
+    }
+    break;
+  case WindowFunction::BlackmanHarris:
+    for (int i = 0; i < size; i++) {
+      double phase = 2 * M_PI * i / size;
+      window[i] = 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2 * phase) -
+                  0.01168 * cos(3 * phase);
+    }
+    break;
+  case WindowFunction::Kaiser: {
+    double denominator = besselI0(kaiserBeta);
+    for (int i = 0; i < size; i++) {
+      double ratio = 2.0 * i / size - 1;
+      window[i] =
+          besselI0(kaiserBeta * sqrt(1 - ratio * ratio)) / denominator;
+    }
+    break;
+  }
+  }
+
+  return window;
+}
+
+float getFullScaleDecibelOffset(const std::vector<float> &window) {
+  float windowSum = 0;
+  for (float coefficient : window) {
+    windowSum += coefficient;
+  }
+  // A full scale sine peaks at windowSum / 2 in its bin.
+  return 20.f * log10(2.f / windowSum);
+}
+
+} // namespace hpaslt
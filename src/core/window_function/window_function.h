@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+namespace hpaslt {
+
+/**
+ * @brief The window function applied to each STFT frame.
+ *
+ */
+enum class WindowFunction { Rectangular, Hann, Hamming, BlackmanHarris, Kaiser };
+
+/**
+ * @brief Generate a periodic window.
+ * Periodic windows sum to a constant when overlapped at the usual hop sizes,
+ * which is what STFT analysis and resynthesis need.
+ *
+ * @param function the window function.
+ * @param size the window size, normally nfft.
+ * @param kaiserBeta the shape parameter, only used by WindowFunction::Kaiser.
+ * @return std::vector<float> the window coefficients.
+ */
+std::vector<float> generateWindow(WindowFunction function, int size,
+                                  float kaiserBeta = 8.6f);
+
+/**
+ * @brief Get the dB offset that scales the power of a full scale sine,
+ * windowed and transformed unnormalized, to 0 dB.
+ *
+ * @param window the window coefficients.
+ * @return float 20 log10(2 / sum of the window).
+ */
+float getFullScaleDecibelOffset(const std::vector<float> &window);
+
+} // namespace hpaslt
@@ -3,11 +3,14 @@
 #include <nfd.h>
 
 #include "console/console.h"
+#include "core/audio_workspace/audio_workspace.h"
 #include "imgui_example/imgui_example.h"
 #include "logger/logger.h"
 #include "main_menu/main_menu.h"
 #include "play_control/play_control.h"
 #include "project_settings/project_settings.h"
+#include "spectrogram_window/spectrogram_window.h"
+#include "spectrum_window/spectrum_window.h"
 #include "status_bar/status_bar.h"
 #include "waveform_window/waveform_window.h"
 #include "window_manager/window_mgr.h"
@@ -27,6 +30,16 @@ void frontendTerminate() {
 void registerAllImGuiObjs() {
   hpaslt::logger->uiLogger->debug("Frontend entry point.");
 
+  // Deliver the audio thread and job events on the UI thread.
+  beginImGuiFrame.append([]() {
+    AudioWorkspace::getSingleton().lock()->getAudioPlayer().lock()->pollEvents();
+    AudioWorkspace::getSingleton()
+        .lock()
+        ->getJobScheduler()
+        .lock()
+        ->drainCompletions();
+  });
+
   // Main Menu.
   hpaslt::WindowManager::getSingleton().lock()->setMainMenuBar(
       std::make_shared<MainMenu>());
@@ -43,6 +56,12 @@ void registerAllImGuiObjs() {
   hpaslt::WindowManager::getSingleton().lock()->pushRenderObject(
       std::make_shared<WaveformWindow>());
 
+  hpaslt::WindowManager::getSingleton().lock()->pushRenderObject(
+      std::make_shared<SpectrogramWindow>());
+
+  hpaslt::WindowManager::getSingleton().lock()->pushRenderObject(
+      std::make_shared<SpectrumWindow>());
+
   hpaslt::WindowManager::getSingleton().lock()->pushRenderObject(
       std::make_shared<Console>());
 
@@ -12,6 +12,8 @@
 #include "frontend/frontend.h"
 #include "frontend/imgui_example/imgui_example.h"
 #include "frontend/project_settings/project_settings.h"
+#include "frontend/spectrogram_window/spectrogram_window.h"
+#include "frontend/spectrum_window/spectrum_window.h"
 #include "frontend/waveform_window/waveform_window.h"
 #include "logger/logger.h"
 
@@ -44,6 +46,10 @@ void MainMenu::onFinishRegisterImGuiObjs() {
 
   m_showWaveform = m_config->showWaveform;
   WaveformWindow::s_onEnable(m_showWaveform);
+  m_showSpectrogram = m_config->showSpectrogram;
+  SpectrogramWindow::s_onEnable(m_showSpectrogram);
+  m_showSpectrum = m_config->showSpectrum;
+  SpectrumWindow::s_onEnable(m_showSpectrum);
   m_showConsole = m_config->showConsole;
   Console::s_onEnable(m_showConsole);
 
@@ -107,6 +113,20 @@ void MainMenu::render() {
         m_config->showWaveform = m_showWaveform;
         m_config->save();
       }
+      if (ImGui::MenuItem(ICON_MD_EQUALIZER " Spectrogram Window", nullptr,
+                          &m_showSpectrogram)) {
+        SpectrogramWindow::s_onEnable(m_showSpectrogram);
+        // Save the config.
+        m_config->showSpectrogram = m_showSpectrogram;
+        m_config->save();
+      }
+      if (ImGui::MenuItem(ICON_MD_SHOW_CHART " Spectrum Window", nullptr,
+                          &m_showSpectrum)) {
+        SpectrumWindow::s_onEnable(m_showSpectrum);
+        // Save the config.
+        m_config->showSpectrum = m_showSpectrum;
+        m_config->save();
+      }
 
       ImGui::Separator();
 
@@ -23,6 +23,8 @@ class MainMenu : public ImGuiObject {
   /* -------------------------- Views ------------------------- */
 
   bool m_showWaveform = false;
+  bool m_showSpectrogram = false;
+  bool m_showSpectrum = false;
   bool m_showConsole = false;
 
   /* ------------------------- HPASLT ------------------------- */
@@ -117,7 +117,7 @@ void ProjectSettings::render() {
 
       // Audio stream frame per buffer.
       if (ImGui::DragInt("Audio Stream Frame per Buffer",
-                         &(m_config->audioStreamFPB), 1, 1024, 65536)) {
+                         &(m_config->audioStreamFPB), 1, 64, 65536)) {
       }
       if (ImGui::IsItemDeactivated()) {
         m_config->save();
@@ -129,6 +129,36 @@ void ProjectSettings::render() {
           "control. But this may also lead to unacceptable lag on old "
           "machines.");
 
+      // Audio ring buffer frames.
+      if (ImGui::DragInt("Audio Ring Buffer Frames",
+                         &(m_config->audioRingBufferFrames), 64, 1024,
+                         1048576)) {
+      }
+      if (ImGui::IsItemDeactivated()) {
+        m_config->save();
+      }
+      ImGui::SameLine();
+      Tooltip::helpMarker(
+          "The number of frames decoded ahead of the audio device. A larger "
+          "ring tolerates longer stalls of the decode thread at the cost of "
+          "memory. Takes effect when the next audio is loaded.");
+
+      /* ----------------------- Spectrogram ---------------------- */
+      ImGui::Text("Spectrogram Settings");
+
+      // Spectrogram tile cache budget.
+      if (ImGui::DragInt("Spectrogram Cache MB",
+                         &(m_config->spectrogramCacheMB), 1, 16, 16384)) {
+      }
+      if (ImGui::IsItemDeactivated()) {
+        m_config->save();
+      }
+      ImGui::SameLine();
+      Tooltip::helpMarker(
+          "The memory the spectrogram window keeps for computed tiles. Tiles "
+          "that were not viewed for the longest time are dropped first and "
+          "computed again when they are visible.");
+
       ImGui::EndTabItem();
     }
 
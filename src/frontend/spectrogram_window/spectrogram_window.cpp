@@ -0,0 +1,246 @@
+#include "spectrogram_window.h"
+
+#include <imgui.h>
+#include <implot.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "core/audio_workspace/audio_workspace.h"
+
+// The nfft choices of the settings menu.
+static const int s_nfftOptions[] = {256, 512, 1024, 2048, 4096, 8192};
+static const char *s_nfftNames[] = {"256", "512", "1024", "2048", "4096",
+                                    "8192"};
+// The hop size is nfft divided by the overlap divisor.
+static const int s_overlapDivisors[] = {1, 2, 4};
+static const char *s_overlapNames[] = {"None", "50%", "75%"};
+static const char *s_windowNames[] = {"Rectangular", "Hann", "Hamming",
+                                      "Blackman-Harris", "Kaiser"};
+
+namespace hpaslt {
+
+eventpp::CallbackList<void(bool)> SpectrogramWindow::s_onEnable;
+
+SpectrogramWindow::SpectrogramWindow()
+    : ImGuiObject("Spectrogram"), m_nfftIndex(2), m_overlapIndex(2),
+      m_window(WindowFunction::Hann), m_channel(0), m_minDecibels(-100),
+      m_maxDecibels(0) {
+  // Setup window enable callback.
+  setupEnableCallback(s_onEnable);
+
+  // Setup audio loaded callback.
+  m_audioLoadedHandle = AudioWorkspace::s_onAudioLoaded.append(
+      [&](std::weak_ptr<AudioObject> audioObj) {
+        std::shared_ptr<AudioObject> targetObj = audioObj.lock();
+        if (!targetObj) {
+          return;
+        }
+        logger->coreLogger->trace("SpectrogramWindow load new AudioObject.");
+
+        // Swap the source in on the UI thread, the tiles are only transformed
+        // once they are visible.
+        std::shared_ptr<AudioSource> audioSource = targetObj->getAudioSource();
+        std::shared_ptr<AudioWorkspace> workspace =
+            AudioWorkspace::getSingleton().lock();
+        workspace->getJobScheduler().lock()->postCompletion(
+            workspace->getLoadToken(), [this, audioSource]() {
+              m_audioSource = audioSource;
+              m_channel = 0;
+              resetTileCache();
+            });
+      });
+
+  m_projectSettingsConfig = ProjectSettingsConfig::getSingleton();
+}
+
+SpectrogramWindow::~SpectrogramWindow() {
+  // Reset window enable callback.
+  resetEnableCallback(s_onEnable);
+  // Remove audio loaded callback.
+  AudioWorkspace::s_onAudioLoaded.remove(m_audioLoadedHandle);
+}
+
+void SpectrogramWindow::resetTileCache() {
+  if (!m_audioSource) {
+    m_tileCache = nullptr;
+    return;
+  }
+
+  STFTConfig config;
+  config.nfft = s_nfftOptions[m_nfftIndex];
+  config.hopSize = config.nfft / s_overlapDivisors[m_overlapIndex];
+  config.window = m_window;
+  config.padding = PaddingMode::Zero;
+  // The queued tiles of the old cache are cancelled with it.
+  m_tileCache = std::make_shared<SpectrogramTileCache>(
+      m_audioSource, config,
+      (size_t)m_projectSettingsConfig->spectrogramCacheMB << 20,
+      AudioWorkspace::getSingleton().lock()->getJobScheduler());
+}
+
+void SpectrogramWindow::renderSettings() {
+  if (!ImGui::BeginMenuBar()) {
+    return;
+  }
+  if (ImGui::BeginMenu("Settings")) {
+    bool changed = false;
+    changed |= ImGui::Combo("FFT Size", &m_nfftIndex, s_nfftNames,
+                            IM_ARRAYSIZE(s_nfftNames));
+    changed |= ImGui::Combo("Overlap", &m_overlapIndex, s_overlapNames,
+                            IM_ARRAYSIZE(s_overlapNames));
+    int window = (int)m_window;
+    if (ImGui::Combo("Window", &window, s_windowNames,
+                     IM_ARRAYSIZE(s_windowNames))) {
+      m_window = (WindowFunction)window;
+      changed = true;
+    }
+    if (changed) {
+      resetTileCache();
+    }
+
+    if (m_audioSource && m_audioSource->getNumChannels() > 1) {
+      ImGui::SliderInt("Channel", &m_channel, 0,
+                       m_audioSource->getNumChannels() - 1);
+    }
+    ImGui::DragFloatRange2("dB Range", &m_minDecibels, &m_maxDecibels, 1,
+                           SPECTROGRAM_TILE_MIN_DB, 40, "%.0f dB");
+    ImGui::EndMenu();
+  }
+  ImGui::EndMenuBar();
+}
+
+void SpectrogramWindow::renderTile(const SpectrogramTile &tile, int level) {
+  int sampleRate = m_audioSource->getSampleRate();
+  int nfft = m_tileCache->getConfig().nfft;
+  int hopSize = m_tileCache->getHopSize(level);
+
+  // Frames are centered on their window, bins on their frequency.
+  double firstTime =
+      ((double)tile.firstFrame * hopSize + (nfft - hopSize) / 2.0) / sampleRate;
+  double lastTime = firstTime + (double)tile.frameNum * hopSize / sampleRate;
+  double binFreq = (double)sampleRate / nfft;
+  double firstFreq = (tile.firstBin - 0.5) * binFreq;
+  double lastFreq = firstFreq + tile.binNum * binFreq;
+
+  ImPlot::PlotHeatmap("##Tile", tile.decibels.data(), tile.binNum,
+                      tile.frameNum, m_minDecibels, m_maxDecibels, nullptr,
+                      ImPlotPoint(firstTime, firstFreq),
+                      ImPlotPoint(lastTime, lastFreq),
+                      ImPlotHeatmapFlags_ColMajor);
+}
+
+void SpectrogramWindow::render() {
+  // Init window properties.
+  const ImGuiWindowFlags windowFlags = ImGuiWindowFlags_MenuBar;
+  ImGui::SetNextWindowSize(ImVec2(500, 440), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Spectrogram", nullptr, windowFlags);
+
+  renderSettings();
+
+  std::shared_ptr<SpectrogramTileCache> tileCache = m_tileCache;
+  if (tileCache) {
+    size_t budget = (size_t)m_projectSettingsConfig->spectrogramCacheMB << 20;
+    if (tileCache->getBudget() != budget) {
+      tileCache->setBudget(budget);
+    }
+    // Tiles queued for the previous views go stale.
+    tileCache->beginFrame();
+
+    int sampleRate = m_audioSource->getSampleRate();
+    int sampleSize = m_audioSource->getNumSamplesPerChannel();
+    int nfft = tileCache->getConfig().nfft;
+    double nyquist = sampleRate / 2.0;
+    float scaleWidth = 80;
+
+    ImPlot::PushColormap(ImPlotColormap_Viridis);
+    if (ImPlot::BeginPlot("##Spectrogram",
+                          ImVec2(-scaleWidth - ImGui::GetStyle().ItemSpacing.x,
+                                 -1),
+                          ImPlotFlags_NoLegend)) {
+      ImPlot::SetupAxes("Time", "Frequency");
+      ImPlot::SetupAxisLimits(ImAxis_X1, 0, (double)sampleSize / sampleRate,
+                              ImPlotCond_Once);
+      ImPlot::SetupAxisLimits(ImAxis_Y1, 0, nyquist, ImPlotCond_Once);
+      ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, 0,
+                                         (double)sampleSize / sampleRate);
+      ImPlot::SetupAxisLimitsConstraints(ImAxis_Y1, 0, nyquist);
+
+      // The visible samples and bins.
+      ImPlotRect limits = ImPlot::GetPlotLimits();
+      int start =
+          std::clamp(limits.X.Min * sampleRate, 0.0, (double)sampleSize);
+      int end =
+          std::clamp(limits.X.Max * sampleRate, 0.0, (double)sampleSize);
+      double binFreq = (double)sampleRate / nfft;
+      int firstBin = std::max(0.0, limits.Y.Min / binFreq);
+      int lastBin = std::min(limits.Y.Max / binFreq + 1,
+                             (double)tileCache->getBinNum());
+
+      // About one frame per pixel.
+      int level = tileCache->findLevel(
+          end - start, std::max(1, (int)ImPlot::GetPlotSize().x));
+      int hopSize = tileCache->getHopSize(level);
+      int frameNum = tileCache->getNumFrames(level);
+      int firstBlock = start / hopSize / SPECTROGRAM_TILE_FRAMES;
+      int lastBlock = std::min(end / hopSize / SPECTROGRAM_TILE_FRAMES,
+                               (frameNum - 1) / SPECTROGRAM_TILE_FRAMES);
+      int firstBinBlock = firstBin / SPECTROGRAM_TILE_BINS;
+      int lastBinBlock = (lastBin - 1) / SPECTROGRAM_TILE_BINS;
+
+      // Missing tiles are covered by a coarser cached tile, drawn first.
+      std::vector<std::pair<SpectrogramTileKey,
+                            std::shared_ptr<const SpectrogramTile>>>
+          coarseTiles;
+      std::vector<std::pair<int, std::shared_ptr<const SpectrogramTile>>>
+          tiles;
+      for (int block = firstBlock; block <= lastBlock; block++) {
+        for (int binBlock = firstBinBlock; binBlock <= lastBinBlock;
+             binBlock++) {
+          std::shared_ptr<const SpectrogramTile> tile =
+              tileCache->requestTile({m_channel, level, block, binBlock});
+          if (tile) {
+            tiles.emplace_back(level, tile);
+            continue;
+          }
+          for (int coarseLevel = level + 1;
+               coarseLevel < tileCache->getNumLevels(); coarseLevel++) {
+            int coarseFrame =
+                (block * SPECTROGRAM_TILE_FRAMES) >> (coarseLevel - level);
+            SpectrogramTileKey coarseKey{m_channel, coarseLevel,
+                                         coarseFrame / SPECTROGRAM_TILE_FRAMES,
+                                         binBlock};
+            bool drawn = std::any_of(
+                coarseTiles.begin(), coarseTiles.end(),
+                [&](const auto &pair) { return pair.first == coarseKey; });
+            if (drawn) {
+              break;
+            }
+            std::shared_ptr<const SpectrogramTile> coarseTile =
+                tileCache->findTile(coarseKey);
+            if (coarseTile) {
+              coarseTiles.emplace_back(coarseKey, coarseTile);
+              break;
+            }
+          }
+        }
+      }
+      for (auto &[key, tile] : coarseTiles) {
+        renderTile(*tile, key.level);
+      }
+      for (auto &[tileLevel, tile] : tiles) {
+        renderTile(*tile, tileLevel);
+      }
+
+      ImPlot::EndPlot();
+    }
+    ImGui::SameLine();
+    ImPlot::ColormapScale("##dB", m_minDecibels, m_maxDecibels,
+                          ImVec2(scaleWidth, -1), "%.0f dB");
+    ImPlot::PopColormap();
+  }
+
+  ImGui::End();
+}
+
+} // namespace hpaslt
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+
+#include "core/audio_object/audio_object.h"
+#include "core/spectrogram_tile_cache/spectrogram_tile_cache.h"
+#include "serialization/project_settings/project_settings_config.h"
+#include "window_manager/imgui_object.h"
+
+namespace hpaslt {
+
+class SpectrogramWindow : public ImGuiObject {
+private:
+  using LoadAudioCallback =
+      eventpp::CallbackList<void(std::weak_ptr<AudioObject>)>;
+
+  /**
+   * @brief The source of the latest audio. Only accessed on the UI thread.
+   *
+   */
+  std::shared_ptr<AudioSource> m_audioSource;
+
+  /**
+   * @brief The tiles of the current source and STFT parameters, rebuilt when
+   * either changes. Only accessed on the UI thread.
+   *
+   */
+  std::shared_ptr<SpectrogramTileCache> m_tileCache;
+
+  /**
+   * @brief The handle of audio loaded callback.
+   *
+   */
+  LoadAudioCallback::Handle m_audioLoadedHandle;
+
+  std::shared_ptr<ProjectSettingsConfig> m_projectSettingsConfig;
+
+  /* ------------------------ Settings ------------------------ */
+
+  // Index into the nfft options.
+  int m_nfftIndex;
+  // Index into the overlap options.
+  int m_overlapIndex;
+  WindowFunction m_window;
+  int m_channel;
+  // The dB range mapped to the colormap.
+  float m_minDecibels;
+  float m_maxDecibels;
+
+  /**
+   * @brief Create a new tile cache for the source and current settings.
+   *
+   */
+  void resetTileCache();
+
+  /**
+   * @brief Draw the settings menu.
+   *
+   */
+  void renderSettings();
+
+  /**
+   * @brief Draw one tile as a heatmap.
+   *
+   * @param tile
+   * @param level the level of the tile.
+   */
+  void renderTile(const SpectrogramTile &tile, int level);
+
+public:
+  /**
+   * @brief callback event when open the window from other place.
+   *
+   */
+  static eventpp::CallbackList<void(bool)> s_onEnable;
+
+  /**
+   * @brief Construct a new SpectrogramWindow object.
+   *
+   */
+  SpectrogramWindow();
+
+  /**
+   * @brief Destroy the SpectrogramWindow object.
+   *
+   */
+  ~SpectrogramWindow();
+
+  virtual void render() override;
+};
+
+} // namespace hpaslt
@@ -0,0 +1,135 @@
+#include "spectrum_window.h"
+
+#include <imgui.h>
+#include <implot.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "core/audio_workspace/audio_workspace.h"
+
+// The nfft choices of the settings menu.
+static const int s_nfftOptions[] = {1024, 2048, 4096, 8192, 16384};
+static const char *s_nfftNames[] = {"1024", "2048", "4096", "8192", "16384"};
+static const char *s_windowNames[] = {"Rectangular", "Hann", "Hamming",
+                                      "Blackman-Harris", "Kaiser"};
+
+namespace hpaslt {
+
+eventpp::CallbackList<void(bool)> SpectrumWindow::s_onEnable;
+
+SpectrumWindow::SpectrumWindow()
+    : ImGuiObject("Spectrum"), m_nfftIndex(2), m_window(WindowFunction::Hann),
+      m_updateRate(30), m_minDecibels(-120), m_maxDecibels(0),
+      m_logFrequency(true) {
+  // Setup window enable callback.
+  setupEnableCallback(s_onEnable);
+
+  // The audio callback only feeds the analyzer while the window is open.
+  m_analyzerEnableHandle = s_onEnable.append([](bool enabled) {
+    AudioWorkspace::getSingleton()
+        .lock()
+        ->getAudioPlayer()
+        .lock()
+        ->setSpectrumAnalyzerEnabled(enabled);
+  });
+}
+
+SpectrumWindow::~SpectrumWindow() {
+  // Reset window enable callback.
+  resetEnableCallback(s_onEnable);
+  s_onEnable.remove(m_analyzerEnableHandle);
+}
+
+void SpectrumWindow::renderSettings() {
+  if (!ImGui::BeginMenuBar()) {
+    return;
+  }
+  if (ImGui::BeginMenu("Settings")) {
+    ImGui::Combo("FFT Size", &m_nfftIndex, s_nfftNames,
+                 IM_ARRAYSIZE(s_nfftNames));
+    int window = (int)m_window;
+    if (ImGui::Combo("Window", &window, s_windowNames,
+                     IM_ARRAYSIZE(s_windowNames))) {
+      m_window = (WindowFunction)window;
+    }
+    ImGui::SliderFloat("Update Rate", &m_updateRate, 1, 120, "%.0f Hz");
+    ImGui::DragFloatRange2("dB Range", &m_minDecibels, &m_maxDecibels, 1,
+                           SPECTRUM_ANALYZER_MIN_DB, 40, "%.0f dB");
+    ImGui::Checkbox("Log Frequency", &m_logFrequency);
+    ImGui::EndMenu();
+  }
+  ImGui::EndMenuBar();
+}
+
+void SpectrumWindow::render() {
+  // Init window properties.
+  const ImGuiWindowFlags windowFlags = ImGuiWindowFlags_MenuBar;
+  ImGui::SetNextWindowSize(ImVec2(500, 300), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Spectrum", nullptr, windowFlags);
+
+  renderSettings();
+
+  std::shared_ptr<SpectrumAnalyzer> analyzer = AudioWorkspace::getSingleton()
+                                                   .lock()
+                                                   ->getAudioPlayer()
+                                                   .lock()
+                                                   ->getSpectrumAnalyzer()
+                                                   .lock();
+  if (analyzer) {
+    // The settings are atomics read by the analysis thread.
+    int nfft = s_nfftOptions[m_nfftIndex];
+    if (analyzer->getNfft() != nfft) {
+      analyzer->setNfft(nfft);
+    }
+    if (analyzer->getWindow() != m_window) {
+      analyzer->setWindow(m_window);
+    }
+    m_updateRate = std::max(m_updateRate, 1.f);
+    if (analyzer->getUpdateRate() != m_updateRate) {
+      analyzer->setUpdateRate(m_updateRate);
+    }
+
+    // Copy the latest frame without blocking the analysis thread.
+    if (analyzer->readFrame(m_frame)) {
+      int binNum = m_frame.decibels.size();
+      float binFreq = (float)m_frame.sampleRate / m_frame.nfft;
+      if ((int)m_frequencies.size() != binNum ||
+          m_frequencies.back() != (binNum - 1) * binFreq) {
+        m_frequencies.resize(binNum);
+        for (int bin = 0; bin < binNum; bin++) {
+          m_frequencies[bin] = bin * binFreq;
+        }
+      }
+    }
+  }
+
+  if (ImPlot::BeginPlot("##Spectrum", ImVec2(-1, -1), ImPlotFlags_NoLegend)) {
+    ImPlot::SetupAxes("Frequency", "dB");
+    if (m_logFrequency) {
+      ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Log10);
+    }
+    ImPlot::SetupAxisLimits(ImAxis_Y1, m_minDecibels, m_maxDecibels,
+                            ImPlotCond_Always);
+
+    int binNum = m_frame.decibels.size();
+    if (binNum > 1 && (int)m_frequencies.size() == binNum) {
+      ImPlot::SetupAxisLimits(ImAxis_X1, m_logFrequency ? 20 : 0,
+                              m_frequencies.back(), ImPlotCond_Once);
+      // The dc bin has no place on a log axis.
+      int first = m_logFrequency ? 1 : 0;
+      ImPlot::PlotShaded("##Magnitude", m_frequencies.data() + first,
+                         m_frame.decibels.data() + first, binNum - first,
+                         -INFINITY);
+      ImPlot::PlotLine("##Magnitude", m_frequencies.data() + first,
+                       m_frame.decibels.data() + first, binNum - first);
+    }
+
+    ImPlot::EndPlot();
+  }
+
+  ImGui::End();
+}
+
+} // namespace hpaslt
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "core/spectrum_analyzer/spectrum_analyzer.h"
+#include "window_manager/imgui_object.h"
+
+namespace hpaslt {
+
+class SpectrumWindow : public ImGuiObject {
+private:
+  /**
+   * @brief The handle of the callback enabling the analyzer with the window.
+   *
+   */
+  eventpp::CallbackList<void(bool)>::Handle m_analyzerEnableHandle;
+
+  /**
+   * @brief The latest frame copied from the analyzer.
+   *
+   */
+  SpectrumFrame m_frame;
+
+  /**
+   * @brief The frequency of every bin of m_frame.
+   *
+   */
+  std::vector<float> m_frequencies;
+
+  /* ------------------------ Settings ------------------------ */
+
+  // Index into the nfft options.
+  int m_nfftIndex;
+  WindowFunction m_window;
+  // Published frames per second.
+  float m_updateRate;
+  // The dB range of the plot.
+  float m_minDecibels;
+  float m_maxDecibels;
+  bool m_logFrequency;
+
+  /**
+   * @brief Draw the settings menu.
+   *
+   */
+  void renderSettings();
+
+public:
+  /**
+   * @brief callback event when open the window from other place.
+   *
+   */
+  static eventpp::CallbackList<void(bool)> s_onEnable;
+
+  /**
+   * @brief Construct a new SpectrumWindow object.
+   *
+   */
+  SpectrumWindow();
+
+  /**
+   * @brief Destroy the SpectrumWindow object.
+   *
+   */
+  ~SpectrumWindow();
+
+  virtual void render() override;
+};
+
+} // namespace hpaslt
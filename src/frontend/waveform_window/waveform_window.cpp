@@ -3,6 +3,9 @@
 #include <imgui.h>
 #include <implot.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "core/audio_workspace/audio_workspace.h"
 #include "serialization/project_settings/project_settings_config.h"
 
@@ -12,28 +15,109 @@ namespace hpaslt {
 
 eventpp::CallbackList<void(bool)> WaveformWindow::s_onEnable;
 
-void WaveformWindow::downSampleLayer(AudioDataLayer &layer) {
-  std::shared_ptr<std::vector<float>> wx = layer.wx;
-  std::shared_ptr<std::vector<float>> wy = layer.wy;
+/**
+ * @brief An envelope level as an ImPlot getter, the time of a bin is its
+ * center.
+ *
+ */
+struct EnvelopeGetterData {
+  const float *values;
+  int firstBin;
+  double binTime;
+  // Get -sqrt(values) or sqrt(values) to draw the RMS band.
+  int rmsSign;
+};
+
+static ImPlotPoint envelopeGetter(int idx, void *data) {
+  EnvelopeGetterData &getterData = *(EnvelopeGetterData *)data;
+  double time = (getterData.firstBin + idx + 0.5) * getterData.binTime;
+  float value = getterData.values[getterData.firstBin + idx];
+  if (getterData.rmsSign) {
+    value = getterData.rmsSign * std::sqrt(value);
+  }
+  return ImPlotPoint(time, value);
+}
+
+void WaveformWindow::extendWaveform(WaveformData &waveformData,
+                                    int loadedSize) {
+  int prevLoadedSize = waveformData.loadedSize.load(std::memory_order_relaxed);
+  loadedSize = std::min(loadedSize, waveformData.sampleSize);
+  if (loadedSize <= prevLoadedSize) {
+    return;
+  }
+
+  std::vector<float> window;
+  for (int channel = 0; channel < waveformData.channelNum; channel++) {
+    AudioChannel &audioChannel = waveformData.channels[channel];
+    WaveformEnvelope &envelope = audioChannel.envelope;
 
-  layer.sampleSize /= 2;
-  layer.sampleRate /= 2;
-  layer.wx = std::make_shared<std::vector<float>>(layer.sampleSize);
-  layer.wy = std::make_shared<std::vector<float>>(layer.sampleSize);
+    // Reduce the resident samples in place.
+    if (audioChannel.samples) {
+      envelope.extend(audioChannel.samples, loadedSize);
+      continue;
+    }
 
-  for (int i = 0; i < wx->size(); i++) {
-    // Keep odd index.
-    if (i % 2) {
-      (*layer.wx)[i / 2] = (*wx)[i];
-      (*layer.wy)[i / 2] = (*wy)[i];
+    // Otherwise stream them through a window, one block at a time.
+    window.resize(AUDIO_SOURCE_BLOCK_FRAMES);
+    while (envelope.getLoadedSamples() < loadedSize) {
+      int firstSample = envelope.getNextSample();
+      int count =
+          std::min(AUDIO_SOURCE_BLOCK_FRAMES, loadedSize - firstSample);
+      count = waveformData.audioSource->read(channel, firstSample, count,
+                                             window.data());
+      envelope.extend(window.data(), firstSample, firstSample + count);
     }
   }
+
+  // Publish the new samples to render.
+  waveformData.loadedSize.store(loadedSize, std::memory_order_release);
+}
+
+std::shared_ptr<WaveformData>
+WaveformWindow::buildWaveform(std::shared_ptr<AudioObject> audioObj,
+                              const CancellationToken &token) {
+  std::shared_ptr<WaveformData> waveformData =
+      std::make_shared<WaveformData>();
+  waveformData->audioSource = audioObj->getAudioSource();
+  waveformData->channelNum = waveformData->audioSource->getNumChannels();
+  waveformData->sampleRate = waveformData->audioSource->getSampleRate();
+  waveformData->sampleSize =
+      waveformData->audioSource->getNumSamplesPerChannel();
+  waveformData->loadedSize.store(0, std::memory_order_relaxed);
+
+  for (int channel = 0; channel < waveformData->channelNum; channel++) {
+    AudioChannel audioChannel;
+    audioChannel.samples = waveformData->audioSource->getChannelData(channel);
+    audioChannel.envelope = WaveformEnvelope(waveformData->sampleSize,
+                                             AUDIO_WAVEFORM_RESOLUTION, true);
+    waveformData->channels.push_back(std::move(audioChannel));
+  }
+
+  // Reduce the samples loaded so far without blocking the progress callback.
+  if (token.isCancelled()) {
+    return nullptr;
+  }
+  extendWaveform(*waveformData,
+                 waveformData->audioSource->getLoadedSamples());
+
+  // Catch up with the blocks loaded meanwhile, the rest arrives with the
+  // progress callback.
+  std::lock_guard<std::mutex> lock(m_audioMutex);
+  if (token.isCancelled()) {
+    return nullptr;
+  }
+  m_extendingData = waveformData;
+  extendWaveform(*waveformData,
+                 waveformData->audioSource->getLoadedSamples());
+  logger->coreLogger->trace("WaveformWindow generated {} channel data.",
+                            waveformData->channelNum);
+
+  return waveformData;
 }
 
 WaveformWindow::WaveformWindow()
-    : ImGuiObject("Waveform"), m_channelNum(0), m_sampleRate(0),
-      m_sampleSize(0), m_currTime(0), m_sliderTime(0), m_syncSliderTime(true),
-      m_totalTime(0) {
+    : ImGuiObject("Waveform"), m_currTime(0), m_sliderTime(0),
+      m_syncSliderTime(true), m_totalTime(0) {
   // Setup window enable callback.
   setupEnableCallback(s_onEnable);
 
@@ -42,47 +126,54 @@ WaveformWindow::WaveformWindow()
       [&](std::weak_ptr<AudioObject> audioObj) {
         logger->coreLogger->trace("WaveformWindow load new AudioObject.");
 
-        // Load m_audioObj.
+        // Stop extending the previous waveform.
         m_audioMutex.lock();
+        m_extendingData = nullptr;
+        m_audioMutex.unlock();
 
-        m_audioObj = audioObj.lock();
-
-        // Copy all the audio data
-        m_channelNum = m_audioObj->getAudioFile().getNumChannels();
-        m_sampleRate = m_audioObj->getAudioFile().getSampleRate();
-        m_sampleSize = m_audioObj->getAudioFile().getNumSamplesPerChannel();
-        auto &samples = m_audioObj->getAudioFile().samples;
-        logger->coreLogger->trace("WaveformWindow copied audio data.");
-
-        m_audioChannels.clear();
-        AudioChannel audioChannel;
-        for (int channel = 0; channel < m_channelNum; channel++) {
-          // Push full resolution layer.
-          AudioDataLayer audioLayer;
-          audioLayer.wx = std::make_shared<std::vector<float>>(m_sampleSize);
-          audioLayer.wy = std::make_shared<std::vector<float>>(m_sampleSize);
-          audioLayer.sampleSize = m_sampleSize;
-          audioLayer.sampleRate = m_sampleRate;
-          for (int i = 0; i < audioLayer.sampleSize; i++) {
-            (*audioLayer.wx)[i] = (float)i / (float)m_sampleRate;
-            (*audioLayer.wy)[i] = samples[channel][i];
-          }
-          audioChannel.layers.push_back(audioLayer);
+        // Build the waveform in the background, the job is cancelled if
+        // another file is loaded. Its own token lets the window cancel it
+        // without cancelling the load.
+        std::shared_ptr<AudioWorkspace> workspace =
+            AudioWorkspace::getSingleton().lock();
+        std::weak_ptr<JobScheduler> jobScheduler = workspace->getJobScheduler();
+        std::shared_ptr<CancellationToken> buildToken =
+            std::make_shared<CancellationToken>(workspace->getLoadToken());
+        m_buildWaveformJob = jobScheduler.lock()->submit(
+            [this, audioObj, jobScheduler,
+             buildToken](const CancellationToken &token) {
+              std::shared_ptr<AudioObject> targetObj = audioObj.lock();
+              if (!targetObj) {
+                return;
+              }
+              std::shared_ptr<WaveformData> waveformData =
+                  buildWaveform(targetObj, token);
+              if (!waveformData) {
+                return;
+              }
+
+              // Swap the new waveform in on the UI thread.
+              jobScheduler.lock()->postCompletion(
+                  buildToken, [this, waveformData]() {
+                    m_waveformData = waveformData;
+                    m_wasDragging.clear();
+                  });
+            },
+            JobPriority::Normal, buildToken);
+      });
 
-          // Down sample layers.
-          while (audioLayer.sampleSize > AUDIO_WAVEFORM_RESOLUTION) {
-            downSampleLayer(audioLayer);
-            audioChannel.layers.push_back(audioLayer);
-          }
+  // Setup audio progress callback.
+  m_audioProgressHandle = AudioWorkspace::s_onAudioProgress.append(
+      [&](std::weak_ptr<AudioObject> audioObj, float progress) {
+        std::lock_guard<std::mutex> lock(m_audioMutex);
 
-          m_audioChannels.push_back(audioChannel);
+        // The waveform is not built yet.
+        if (!m_extendingData) {
+          return;
         }
-        logger->coreLogger->trace("WaveformWindow generated {} channel data.",
-                                  m_channelNum);
-
-        m_audioMutex.unlock();
 
-        m_wasDragging.clear();
+        extendWaveform(*m_extendingData,
+                       m_extendingData->audioSource->getLoadedSamples());
       });
 
   // Play time callback.
@@ -105,6 +196,13 @@ WaveformWindow::~WaveformWindow() {
   resetEnableCallback(s_onEnable);
   // Remove audio loaded callback.
   AudioWorkspace::s_onAudioLoaded.remove(m_audioLoadedHandle);
+  // Remove audio progress callback.
+  AudioWorkspace::s_onAudioProgress.remove(m_audioProgressHandle);
+  // Stop building the waveform and drop its completion, the load goes on.
+  if (m_buildWaveformJob) {
+    m_buildWaveformJob->cancel();
+    m_buildWaveformJob->wait();
+  }
   // Reset play time callback.
   AudioWorkspace::getSingleton()
       .lock()
@@ -120,44 +218,81 @@ void WaveformWindow::render() {
   ImGui::SetNextWindowSize(ImVec2(500, 440), ImGuiCond_FirstUseEver);
   ImGui::Begin("Waveform", nullptr, windowFlags);
 
-  if (m_audioMutex.try_lock()) {
-    if (m_channelNum > 0 &&
-        ImPlot::BeginSubplots("Audio Channels", m_channelNum, 1, ImVec2(-1, -1),
+  // The builds never modify the loaded part, so render does not lock.
+  std::shared_ptr<WaveformData> waveformData = m_waveformData;
+  if (waveformData) {
+    int channelNum = waveformData->channelNum;
+    int sampleRate = waveformData->sampleRate;
+    int sampleSize = waveformData->sampleSize;
+    int loadedSize = waveformData->loadedSize.load(std::memory_order_acquire);
+    if (ImPlot::BeginSubplots("Audio Channels", channelNum, 1, ImVec2(-1, -1),
                               ImPlotSubplotFlags_LinkAllX)) {
-      for (int channel = 0; channel < m_channelNum; channel++) {
-        AudioChannel &audioChannel = m_audioChannels[channel];
+      for (int channel = 0; channel < channelNum; channel++) {
+        AudioChannel &audioChannel = waveformData->channels[channel];
         std::stringstream channelName;
         channelName << "Channel " << channel;
         if (ImPlot::BeginPlot(channelName.str().c_str())) {
           ImPlot::SetupAxes("Time", "Amplitude");
           ImPlot::SetupAxisLimits(ImAxis_Y1, -1, 1, ImPlotCond_Always);
           ImPlot::SetupAxisLimitsConstraints(
-              ImAxis_X1, 0, (float)m_sampleSize / (float)m_sampleRate);
+              ImAxis_X1, 0, (float)sampleSize / (float)sampleRate);
           // Resample plot.
-          int start = ImPlot::GetPlotLimits().X.Min * m_sampleRate;
-          int end = ImPlot::GetPlotLimits().X.Max * m_sampleRate;
+          int start = ImPlot::GetPlotLimits().X.Min * sampleRate;
+          int end = ImPlot::GetPlotLimits().X.Max * sampleRate;
           // Clamp start and end.
           start = start < 0 ? 0 : start;
-          start = start > m_sampleSize ? m_sampleSize : start;
+          start = start > sampleSize ? sampleSize : start;
           end = end < 0 ? 0 : end;
-          end = end > m_sampleSize ? m_sampleSize : end;
-          // Resample data.
+          end = end > sampleSize ? sampleSize : end;
+          // Find best level.
           int span = end - start;
-          // Find best layer.
-          int i = audioChannel.layers.size() - 1;
-          while (i > 0 &&
-                 (span * audioChannel.layers[i].sampleRate / m_sampleRate <
-                  AUDIO_WAVEFORM_RESOLUTION)) {
-            i--;
+          int level = audioChannel.envelope.findLevel(
+              span, AUDIO_WAVEFORM_RESOLUTION);
+          if (level < 0) {
+            // Only render the loaded samples.
+            int sampleNum = std::max(0, std::min(end, loadedSize) - start);
+            const float *samples = nullptr;
+            if (audioChannel.samples) {
+              samples = audioChannel.samples + start;
+            } else {
+              // Only the visible samples are read from the source.
+              m_renderSamples.resize(sampleNum);
+              sampleNum = waveformData->audioSource->read(
+                  channel, start, sampleNum, m_renderSamples.data());
+              samples = m_renderSamples.data();
+            }
+            ImPlot::PlotLine("", samples, sampleNum, 1.0 / sampleRate,
+                             (double)start / sampleRate);
+          } else {
+            // Draw the min/max band and the RMS band inside it.
+            const EnvelopeLevel &envelopeLevel =
+                audioChannel.envelope.getLevel(level);
+            int firstBin = start / envelopeLevel.binSize;
+            int loadedBins = loadedSize == sampleSize
+                                 ? envelopeLevel.binNum
+                                 : loadedSize / envelopeLevel.binSize;
+            int lastBin = std::min(
+                (end + envelopeLevel.binSize - 1) / envelopeLevel.binSize,
+                loadedBins);
+            int binNum = std::max(0, lastBin - firstBin);
+            double binTime = (double)envelopeLevel.binSize / sampleRate;
+
+            EnvelopeGetterData minData{envelopeLevel.min.data(), firstBin,
+                                       binTime, 0};
+            EnvelopeGetterData maxData{envelopeLevel.max.data(), firstBin,
+                                       binTime, 0};
+            ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 1.0f);
+            ImPlot::PlotShadedG("", envelopeGetter, &minData, envelopeGetter,
+                                &maxData, binNum);
+
+            EnvelopeGetterData rmsLowData{envelopeLevel.meanSquare.data(),
+                                          firstBin, binTime, -1};
+            EnvelopeGetterData rmsHighData{envelopeLevel.meanSquare.data(),
+                                           firstBin, binTime, 1};
+            ImPlot::SetNextFillStyle(ImVec4(1, 1, 1, 0.35f));
+            ImPlot::PlotShadedG("##RMS", envelopeGetter, &rmsLowData,
+                                envelopeGetter, &rmsHighData, binNum);
           }
-          AudioDataLayer layer = audioChannel.layers[i];
-          int layerStart =
-              start * audioChannel.layers[i].sampleRate / m_sampleRate;
-          int layerSpan =
-              span * audioChannel.layers[i].sampleRate / m_sampleRate;
-
-          ImPlot::PlotLine("", layer.wx->data() + layerStart,
-                           layer.wy->data() + layerStart, layerSpan);
 
           // Sync play time.
           if (m_syncSliderTime) {
@@ -232,7 +367,6 @@ void WaveformWindow::render() {
 
       ImPlot::EndSubplots();
     }
-    m_audioMutex.unlock();
   }
 
   ImGui::End();
@@ -1,52 +1,74 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
 #include "core/audio_object/audio_object.h"
+#include "core/job_scheduler/job_scheduler.h"
+#include "core/waveform_envelope/waveform_envelope.h"
 #include "serialization/project_settings/project_settings_config.h"
 #include "window_manager/imgui_object.h"
 
 namespace hpaslt {
 
 /**
- * @class AudioDataLayer
- * @brief A down sampled audio layer for implot to render.
+ * @class AudioChannel
+ * @brief The samples of a channel and their envelope pyramid, rendered in
+ * different resolution.
  *
  */
-struct AudioDataLayer {
-  std::shared_ptr<std::vector<float>> wx;
-  std::shared_ptr<std::vector<float>> wy;
-  float sampleRate;
-  int sampleSize;
+struct AudioChannel {
+  // A view of the samples owned by the audio source, nullptr if the source
+  // has no resident samples.
+  const float *samples;
+  WaveformEnvelope envelope;
 };
 
 /**
- * @class AudioChannel
- * @brief A collection of AudioDataLayer to support rendering in different
- * resolution.
+ * @class WaveformData
+ * @brief All the waveform data of one audio, built off the UI thread.
+ * Only the envelopes are materialized, the shared audio source keeps the
+ * viewed samples alive. The samples and bins below loadedSize are never
+ * modified again, so render can read them while a progressive load extends
+ * the rest.
  *
  */
-struct AudioChannel {
-  std::vector<AudioDataLayer> layers;
+struct WaveformData {
+  std::shared_ptr<AudioSource> audioSource;
+  std::vector<AudioChannel> channels;
+  int channelNum;
+  int sampleRate;
+  int sampleSize;
+  // Published after the samples and bins below it are written.
+  std::atomic<int> loadedSize;
 };
 
 class WaveformWindow : public ImGuiObject {
 private:
   using LoadAudioCallback =
       eventpp::CallbackList<void(std::weak_ptr<AudioObject>)>;
+  using AudioProgressCallback =
+      eventpp::CallbackList<void(std::weak_ptr<AudioObject>, float)>;
 
   /**
-   * @brief Mutex lock for m_audioObj.
+   * @brief The waveform rendered, swapped in on the UI thread when a build
+   * finished. Only accessed on the UI thread.
+   *
+   */
+  std::shared_ptr<WaveformData> m_waveformData;
+
+  /**
+   * @brief Mutex lock for m_extendingData.
    *
    */
   std::mutex m_audioMutex;
 
   /**
-   * @brief The current playing audio object.
+   * @brief The waveform extended by the progressive loading.
    *
    */
-  std::shared_ptr<AudioObject> m_audioObj;
+  std::shared_ptr<WaveformData> m_extendingData;
 
   /**
    * @brief The handle of audio loaded callback.
@@ -54,12 +76,17 @@ class WaveformWindow : public ImGuiObject {
    */
   LoadAudioCallback::Handle m_audioLoadedHandle;
 
-  /* ----------------------- Audio Data ----------------------- */
+  /**
+   * @brief The handle of audio progress callback.
+   *
+   */
+  AudioProgressCallback::Handle m_audioProgressHandle;
 
-  std::vector<AudioChannel> m_audioChannels;
-  int m_channelNum;
-  int m_sampleRate;
-  int m_sampleSize;
+  /**
+   * @brief The job building the waveform of the latest audio.
+   *
+   */
+  std::shared_ptr<JobHandle> m_buildWaveformJob;
 
   /* ---------------------- Playing Time ---------------------- */
   // Current playing time, normally sync with workspace playing time.
@@ -78,12 +105,32 @@ class WaveformWindow : public ImGuiObject {
   std::shared_ptr<ProjectSettingsConfig> m_projectSettingsConfig;
 
   /**
-   * @brief Down sample the layer and get a new layer with half the sample rate
-   * and half sample size.
+   * @brief The visible samples of a source without resident samples.
+   *
+   */
+  std::vector<float> m_renderSamples;
+
+  /**
+   * @brief Build the waveform of the audio object and publish it for the
+   * progressive loading.
+   * Runs on the JobScheduler, returns nullptr if the token is cancelled.
+   *
+   * @param audioObj
+   * @param token
+   * @return std::shared_ptr<WaveformData>
+   */
+  std::shared_ptr<WaveformData>
+  buildWaveform(std::shared_ptr<AudioObject> audioObj,
+                const CancellationToken &token);
+
+  /**
+   * @brief Extend the envelopes with the newly loaded samples.
+   * Only one thread may extend the waveform at a time.
    *
-   * @param layer the input layer.
+   * @param waveformData
+   * @param loadedSize the number of samples per channel loaded so far.
    */
-  void downSampleLayer(AudioDataLayer &layer);
+  static void extendWaveform(WaveformData &waveformData, int loadedSize);
 
 public:
   /**
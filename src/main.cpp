@@ -9,6 +9,7 @@
 /* -------------------------- Core -------------------------- */
 #include "core/audio_player/audio_player.h"
 #include "core/audio_workspace/audio_workspace.h"
+#include "core/fft_wisdom/fft_wisdom.h"
 /* ------------------------ Rendering ----------------------- */
 #include "frontend/frontend.h"
 #include "window_manager/window_mgr.h"
@@ -39,11 +40,15 @@ int main(int argc, char const *argv[]) {
   // Audio player.
   hpaslt::logger->coreLogger->debug("Initializaing AudioPlayer.");
   hpaslt::AudioPlayer::initAudioPlayer();
+  // FFTW wisdom.
+  hpaslt::logger->coreLogger->debug("Loading FFTW wisdom.");
+  hpaslt::FFTWisdom::initFFTWisdom();
   // Audio Workspace.
   hpaslt::logger->coreLogger->debug("Creating the main workspace.");
   hpaslt::AudioWorkspace::getSingleton();
   hpaslt::logger->coreLogger->debug("Registering console commands.");
   hpaslt::AudioWorkspace::registerConosleCommands();
+  hpaslt::FFTWisdom::registerConosleCommands();
 
   /* ------------------------ Rendering ----------------------- */
   // Window manager.
@@ -85,6 +90,10 @@ int main(int argc, char const *argv[]) {
   hpaslt::AudioPlayer::terminateAudioPlayer();
   hpaslt::logger->coreLogger->debug("AudioPlayer terminated.");
 
+  // Save FFTW wisdom.
+  hpaslt::FFTWisdom::terminateFFTWisdom();
+  hpaslt::logger->coreLogger->debug("FFTW wisdom saved.");
+
   /* --------------------- Infrastructure --------------------- */
   // Commands manager.
   hpaslt::Commands::freeSingleton();
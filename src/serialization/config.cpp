@@ -23,10 +23,15 @@ void Config::checkAndCreateDir(const std::filesystem::path &fullPath) {
   }
 }
 
+std::filesystem::path Config::getConfigDirectory() {
+  namespace fs = std::filesystem;
+  return fs::path(hpaslt::workspaceContext::hpasltWorkingDirectory) /
+         fs::path(m_baseDir);
+}
+
 Config::Config(const std::string &fileName) {
   namespace fs = std::filesystem;
-  auto fullPath = fs::path(hpaslt::workspaceContext::hpasltWorkingDirectory) /
-                  fs::path(m_baseDir) / fs::path(fileName);
+  auto fullPath = getConfigDirectory() / fs::path(fileName);
   checkAndCreateDir(fullPath);
 
   m_savePath = fullPath.string();
@@ -77,6 +77,13 @@ class Config {
   }
 
 public:
+  /**
+   * @brief Get the directory all the config files are saved to.
+   *
+   * @return std::filesystem::path
+   */
+  static std::filesystem::path getConfigDirectory();
+
   /**
    * @brief Construct a new Config object
    *
@@ -13,6 +13,8 @@ class MainMenuConfig : public Config {
   /* -------------------------- Views ------------------------- */
 
   bool showWaveform = false;
+  bool showSpectrogram = false;
+  bool showSpectrum = false;
   bool showConsole = false;
 
   /* -------------------------- Debug ------------------------- */
@@ -22,7 +24,8 @@ class MainMenuConfig : public Config {
   MainMenuConfig(std::string fileName) : Config(fileName) {}
 
   template <class Archive> void serialize(Archive &archive) {
-    archive(CEREAL_NVP(showWaveform), CEREAL_NVP(showConsole));
+    archive(CEREAL_NVP(showWaveform), CEREAL_NVP(showSpectrogram),
+            CEREAL_NVP(showSpectrum), CEREAL_NVP(showConsole));
     archive(CEREAL_NVP(showExample));
   }
 
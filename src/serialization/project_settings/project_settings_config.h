@@ -37,16 +37,20 @@ class ProjectSettingsConfig : public Config {
   /* ------------------------- Advance ------------------------ */
 
   int audioStreamFPB;
+  int audioRingBufferFrames;
+  int spectrogramCacheMB;
 
   ProjectSettingsConfig(std::string fileName)
       : Config(fileName), logLevel(spdlog::level::info),
         panButton(ImGuiMouseButton_Middle), timeButton(ImGuiMouseButton_Left),
-        audioStreamFPB(1024) {}
+        audioStreamFPB(1024), audioRingBufferFrames(8192),
+        spectrogramCacheMB(256) {}
 
   template <class Archive> void serialize(Archive &archive) {
     archive(CEREAL_NVP(logLevel));
     archive(CEREAL_NVP(panButton), CEREAL_NVP(timeButton));
-    archive(CEREAL_NVP(audioStreamFPB));
+    archive(CEREAL_NVP(audioStreamFPB), CEREAL_NVP(audioRingBufferFrames));
+    archive(CEREAL_NVP(spectrogramCacheMB));
   }
 
   virtual void save() override { saveHelper(*this); }
@@ -4,4 +4,6 @@ namespace hpaslt {
 
 eventpp::CallbackList<void()> finishRegisterImGuiObjs;
 
+eventpp::CallbackList<void()> beginImGuiFrame;
+
 } // namespace hpaslt
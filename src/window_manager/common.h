@@ -10,4 +10,11 @@ namespace hpaslt {
  */
 extern eventpp::CallbackList<void()> finishRegisterImGuiObjs;
 
+/**
+ * @brief Callback function invoked on the UI thread at the beginning of every
+ * frame, before any ImGuiObject is rendered.
+ *
+ */
+extern eventpp::CallbackList<void()> beginImGuiFrame;
+
 } // namespace hpaslt
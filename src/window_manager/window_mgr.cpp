@@ -182,6 +182,9 @@ int WindowManager::execute() {
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
+    // Frame events.
+    beginImGuiFrame();
+
     if (m_mainMenuBar)
       m_mainMenuBar->render();
 
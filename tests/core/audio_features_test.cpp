@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "core/audio_features/audio_features.h"
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/signal_generator/signal_generator.h"
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief Generate the spectrogram of a tone.
+ *
+ * @param spectrogram
+ * @param freq
+ * @param format
+ */
+static void generateTone(AudioSpectrogram &spectrogram, float freq,
+                         SpectrogramFormat format) {
+  std::shared_ptr<AudioFile<float>> audioFile =
+      std::make_shared<AudioFile<float>>();
+  audioFile->setNumChannels(2);
+  hpaslt::SignalGenerator signalGenerator;
+  signalGenerator.bindAudioFile(audioFile);
+  signalGenerator.changeLength(audioFile->getSampleRate());
+  signalGenerator.generateSignal(freq, 0.5f);
+
+  hpaslt::STFTConfig config;
+  config.nfft = 2048;
+  config.hopSize = 512;
+  config.window = WindowFunction::Hann;
+  config.mode = SpectrogramMode::RealToComplex;
+  config.format = format;
+  spectrogram.generateSTFT(audioFile, config);
+}
+
+TEST(AudioFeaturesTest, ToneBand) {
+  for (float freq : {250.f, 1000.f, 4000.f}) {
+    hpaslt::AudioSpectrogram spectrogram;
+    generateTone(spectrogram, freq, SpectrogramFormat::Complex32);
+    hpaslt::AudioFeatures features(spectrogram, FeatureConfig());
+    ASSERT_EQ(features.getChannelNum(), 2);
+    ASSERT_EQ(features.getFrameNum(), spectrogram.getSpectrogramLength());
+
+    // The loudest band of every frame is the band centered nearest the tone.
+    const MelFilterbank &filterbank = features.getFilterbank();
+    int expected = 0;
+    for (int band = 1; band < filterbank.getBandNum(); band++) {
+      if (std::abs(filterbank.getCenterFrequency(band) - freq) <
+          std::abs(filterbank.getCenterFrequency(expected) - freq)) {
+        expected = band;
+      }
+    }
+    for (int channel = 0; channel < 2; channel++) {
+      const std::vector<float> &logMel = features.getLogMelSpectrogram(channel);
+      for (int frame = 0; frame < features.getFrameNum(); frame++) {
+        const float *bands = logMel.data() + frame * features.getBandNum();
+        int loudest = std::max_element(bands, bands + features.getBandNum()) -
+                      bands;
+        ASSERT_NEAR(loudest, expected, 1) << freq << " Hz, frame " << frame;
+      }
+    }
+  }
+}
+
+TEST(AudioFeaturesTest, MatchBruteForce) {
+  hpaslt::AudioSpectrogram spectrogram;
+  generateTone(spectrogram, 1000, SpectrogramFormat::Complex32);
+  FeatureConfig config;
+  config.mfccNum = 20;
+  hpaslt::AudioFeatures features(spectrogram, config);
+
+  int binNum = spectrogram.getNfft() / 2 + 1;
+  int bandNum = features.getBandNum();
+  const MelFilterbank &filterbank = features.getFilterbank();
+  std::vector<float> power(binNum);
+  std::vector<float> bands(bandNum);
+  for (int frame = 0; frame < features.getFrameNum(); frame++) {
+    // Power, log filterbank and orthonormal DCT-II in double.
+    const fftwf_complex *bins =
+        spectrogram.getRawSpectrogram()[1]->getRawSpectrogram() +
+        (size_t)frame * spectrogram.getBinNum();
+    for (int bin = 0; bin < binNum; bin++) {
+      power[bin] = bins[bin][0] * bins[bin][0] + bins[bin][1] * bins[bin][1];
+    }
+    filterbank.apply(power.data(), bands.data());
+    std::vector<double> logMel(bandNum);
+    for (int band = 0; band < bandNum; band++) {
+      logMel[band] = std::log(std::max(bands[band], config.minEnergy));
+      ASSERT_NEAR(features.getLogMelSpectrogram(1)[frame * bandNum + band],
+                  logMel[band], 1e-4);
+    }
+    for (int k = 0; k < config.mfccNum; k++) {
+      double sum = 0;
+      for (int n = 0; n < bandNum; n++) {
+        sum += logMel[n] * std::cos(M_PI * k * (2 * n + 1) / (2 * bandNum));
+      }
+      sum *= std::sqrt((k == 0 ? 1.0 : 2.0) / bandNum);
+      ASSERT_NEAR(features.getMFCC(1)[frame * config.mfccNum + k], sum, 1e-3)
+          << "frame " << frame << ", coefficient " << k;
+    }
+  }
+}
+
+TEST(AudioFeaturesTest, CompactFormat) {
+  hpaslt::AudioSpectrogram complexSpectrogram;
+  generateTone(complexSpectrogram, 1000, SpectrogramFormat::Complex32);
+  hpaslt::AudioFeatures expected(complexSpectrogram, FeatureConfig());
+
+  for (SpectrogramFormat format :
+       {SpectrogramFormat::Magnitude32, SpectrogramFormat::Magnitude16}) {
+    hpaslt::AudioSpectrogram spectrogram;
+    generateTone(spectrogram, 1000, format);
+    FeatureConfig config;
+    config.threadNum = 3;
+    hpaslt::AudioFeatures features(spectrogram, config);
+    // Half floats keep about 3 decimal digits of the magnitude.
+    float tolerance = format == SpectrogramFormat::Magnitude32 ? 1e-3f : 1e-2f;
+    for (int channel = 0; channel < 2; channel++) {
+      const std::vector<float> &mfcc = features.getMFCC(channel);
+      const std::vector<float> &expectedMfcc = expected.getMFCC(channel);
+      ASSERT_EQ(mfcc.size(), expectedMfcc.size());
+      for (size_t i = 0; i < mfcc.size(); i++) {
+        ASSERT_NEAR(mfcc[i], expectedMfcc[i],
+                    tolerance * std::max(1.f, std::abs(expectedMfcc[i])));
+      }
+    }
+  }
+
+  hpaslt::AudioSpectrogram decibelSpectrogram;
+  generateTone(decibelSpectrogram, 1000, SpectrogramFormat::Decibel8);
+  EXPECT_THROW(hpaslt::AudioFeatures(decibelSpectrogram, FeatureConfig()),
+               std::invalid_argument);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
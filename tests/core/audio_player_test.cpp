@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "common/workspace_context.h"
+#include "core/audio_player/audio_player.h"
+#include "core/audio_source/progressive_audio_source.h"
+#include "wav_test_utils.h"
+
+/**
+ * @brief The number of frames of one callback.
+ *
+ */
+#define PLAYER_TEST_FPB 256
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief Drive AudioPlayer::paCallback directly, no stream is opened without
+ * an initialized device while the producer still runs.
+ *
+ */
+class AudioPlayerTest : public ::testing::Test {
+ protected:
+  std::filesystem::path m_audioPath;
+  std::shared_ptr<hpaslt::AudioObject> m_audioObject;
+  std::shared_ptr<hpaslt::AudioPlayer> m_audioPlayer;
+  std::vector<float> m_output;
+
+  void SetUp() override {
+    namespace fs = std::filesystem;
+
+    // AudioPlayer logs and reads the project settings, keep both out of the
+    // way in a temporary directory.
+    if (!hpaslt::logger) {
+      fs::path workingDirectory = fs::temp_directory_path() / "hpaslt_test";
+      hpaslt::workspaceContext::hpasltWorkingDirectory =
+          workingDirectory.string();
+      hpaslt::initLogger(workingDirectory.string());
+      hpaslt::logger->setLogLevel(spdlog::level::off);
+    }
+    m_audioPath = fs::temp_directory_path() / "hpaslt_audio_player.wav";
+
+    auto config = hpaslt::ProjectSettingsConfig::getSingleton();
+    config->audioStreamFPB = PLAYER_TEST_FPB;
+    config->audioRingBufferFrames = 1 << 16;
+
+    m_output.resize(PLAYER_TEST_FPB * 2);
+  }
+
+  void TearDown() override {
+    m_audioPlayer = nullptr;
+    m_audioObject = nullptr;
+    std::filesystem::remove(m_audioPath);
+  }
+
+  /**
+   * @brief Save a stereo float ramp, frame i of both channels is
+   * i / sampleNum.
+   *
+   * @param sampleNum
+   */
+  void saveRamp(int sampleNum) {
+    std::vector<float> samples((size_t)sampleNum * 2);
+    for (int i = 0; i < sampleNum; i++) {
+      samples[2 * i] = (float)i / sampleNum;
+      samples[2 * i + 1] = (float)i / sampleNum;
+    }
+    std::vector<uint8_t> data(samples.size() * sizeof(float));
+    std::memcpy(data.data(), samples.data(), data.size());
+    writeWav(m_audioPath, 3, 2, 44100, 32, data);
+  }
+
+  /**
+   * @brief Get the frame of the ramp an output sample was read from.
+   *
+   * @param sample
+   * @param sampleNum
+   * @return int
+   */
+  static int rampFrame(float sample, int sampleNum) {
+    return (int)std::lround(sample * sampleNum);
+  }
+
+  void waitBuffered(int frameNum) {
+    while (m_audioPlayer->getBufferedFrames() < frameNum) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  int callback() {
+    return hpaslt::AudioPlayer::paCallback(nullptr, m_output.data(),
+                                           PLAYER_TEST_FPB, nullptr, 0,
+                                           m_audioPlayer.get());
+  }
+};
+
+TEST_F(AudioPlayerTest, Seek) {
+  int sampleNum = 8192;
+  saveRamp(sampleNum);
+  m_audioObject = std::make_shared<hpaslt::AudioObject>();
+  m_audioObject->loadAudioFile(m_audioPath.string());
+  m_audioPlayer = std::make_shared<hpaslt::AudioPlayer>();
+  m_audioPlayer->loadAudioObject(m_audioObject);
+  waitBuffered(PLAYER_TEST_FPB);
+
+  EXPECT_EQ(callback(), paContinue);
+  EXPECT_EQ(rampFrame(m_output[0], sampleNum), 0);
+  EXPECT_EQ(m_audioObject->getCursor(), PLAYER_TEST_FPB);
+
+  // The seek moves the cursor at once.
+  int sampleRate = m_audioObject->getAudioSource()->getSampleRate();
+  m_audioPlayer->setTime(4096.f / sampleRate);
+  int seekCursor = m_audioObject->getCursor();
+  EXPECT_NEAR(seekCursor, 4096, 1);
+
+  // The callback plays the frames left in the ring until the producer
+  // restarted, never moving the cursor of the seek meanwhile.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (true) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+    EXPECT_EQ(callback(), paContinue);
+    if (rampFrame(m_output[0], sampleNum) == seekCursor) {
+      break;
+    }
+    EXPECT_EQ(m_audioObject->getCursor(), seekCursor);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(rampFrame(m_output[2 * PLAYER_TEST_FPB - 1], sampleNum),
+            seekCursor + PLAYER_TEST_FPB - 1);
+  EXPECT_EQ(m_audioObject->getCursor(), seekCursor + PLAYER_TEST_FPB);
+}
+
+TEST_F(AudioPlayerTest, Underrun) {
+  int sampleNum = 8192;
+  saveRamp(sampleNum);
+  // Nothing is decoded yet, the producer waits for the first block.
+  m_audioObject = std::make_shared<hpaslt::AudioObject>();
+  m_audioObject->loadAudioFile(m_audioPath.string(), true);
+  auto audioSource = std::dynamic_pointer_cast<hpaslt::ProgressiveAudioSource>(
+      m_audioObject->getAudioSource());
+  ASSERT_NE(audioSource, nullptr);
+  m_audioPlayer = std::make_shared<hpaslt::AudioPlayer>();
+  m_audioPlayer->loadAudioObject(m_audioObject);
+
+  // An empty ring plays silence and keeps the cursor.
+  std::fill(m_output.begin(), m_output.end(), 1.f);
+  EXPECT_EQ(callback(), paContinue);
+  EXPECT_TRUE(std::all_of(m_output.begin(), m_output.end(),
+                          [](float sample) { return sample == 0; }));
+  EXPECT_EQ(m_audioObject->getCursor(), 0);
+
+  // Playback goes on once the frames arrive.
+  audioSource->loadAll();
+  waitBuffered(PLAYER_TEST_FPB);
+  EXPECT_EQ(callback(), paContinue);
+  EXPECT_EQ(rampFrame(m_output[0], sampleNum), 0);
+  EXPECT_EQ(m_audioObject->getCursor(), PLAYER_TEST_FPB);
+}
+
+TEST_F(AudioPlayerTest, EndOfSource) {
+  // The last buffer is partial.
+  int sampleNum = PLAYER_TEST_FPB * 3 + 100;
+  saveRamp(sampleNum);
+  m_audioObject = std::make_shared<hpaslt::AudioObject>();
+  m_audioObject->loadAudioFile(m_audioPath.string());
+  m_audioPlayer = std::make_shared<hpaslt::AudioPlayer>();
+  m_audioPlayer->loadAudioObject(m_audioObject);
+  waitBuffered(sampleNum);
+  // Let the producer see it wrote the last frame.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(callback(), paContinue);
+    EXPECT_EQ(m_audioObject->getCursor(), (i + 1) * PLAYER_TEST_FPB);
+  }
+
+  // The rest of the last buffer is silence and the cursor is reset.
+  EXPECT_EQ(callback(), paComplete);
+  EXPECT_EQ(rampFrame(m_output[2 * 99], sampleNum), sampleNum - 1);
+  EXPECT_TRUE(std::all_of(m_output.begin() + 2 * 100, m_output.end(),
+                          [](float sample) { return sample == 0; }));
+  EXPECT_EQ(m_audioObject->getCursor(), 0);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
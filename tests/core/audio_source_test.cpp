@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "core/audio_source/memory_audio_source.h"
+#include "core/audio_source/progressive_audio_source.h"
+#include "core/audio_source/streaming_audio_source.h"
+#include "wav_test_utils.h"
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief The sample of the test signal at the frame and channel.
+ *
+ * @param frame
+ * @param channel
+ * @return int16_t
+ */
+static int16_t testSample(int frame, int channel) {
+  return (int16_t)((frame * 7 + channel * 1000) % 65536 - 32768);
+}
+
+class AudioSourceTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief A stereo 16 bit WAV file spanning a few blocks.
+   *
+   */
+  std::filesystem::path m_filePath;
+
+  int m_sampleNum;
+
+  void SetUp() override {
+    m_filePath =
+        std::filesystem::temp_directory_path() / "hpaslt_audio_source.wav";
+    m_sampleNum = AUDIO_SOURCE_BLOCK_FRAMES * 3 + 123;
+
+    std::vector<uint8_t> data;
+    for (int i = 0; i < m_sampleNum; i++) {
+      appendLittleEndian(data, (uint16_t)testSample(i, 0), 2);
+      appendLittleEndian(data, (uint16_t)testSample(i, 1), 2);
+    }
+    writeWav(m_filePath, 1, 2, 44100, 16, data);
+  }
+
+  void TearDown() override { std::filesystem::remove(m_filePath); }
+};
+
+TEST_F(AudioSourceTest, MemoryRead) {
+  auto audioFile = std::make_shared<AudioFile<float>>();
+  audioFile->setNumChannels(2);
+  audioFile->setNumSamplesPerChannel(100);
+  for (int i = 0; i < 100; i++) {
+    audioFile->samples[0][i] = i;
+    audioFile->samples[1][i] = -i;
+  }
+
+  hpaslt::MemoryAudioSource audioSource(audioFile);
+  EXPECT_EQ(audioSource.getChannelData(1), audioFile->samples[1].data());
+
+  std::vector<float> samples(10);
+  // Clamped to the end of the audio.
+  EXPECT_EQ(audioSource.read(1, 95, 10, samples.data()), 5);
+  EXPECT_EQ(samples[0], -95);
+  EXPECT_EQ(samples[4], -99);
+
+  std::vector<float> frames(4);
+  EXPECT_EQ(audioSource.readInterleaved(10, 2, frames.data()), 2);
+  std::vector<float> expected{10, -10, 11, -11};
+  EXPECT_EQ(frames, expected);
+
+  // The interleaved copy gives the same frames.
+  audioSource.prepareInterleaved();
+  std::fill(frames.begin(), frames.end(), 0.f);
+  EXPECT_EQ(audioSource.readInterleaved(10, 2, frames.data()), 2);
+  EXPECT_EQ(frames, expected);
+  EXPECT_EQ(audioSource.readInterleaved(98, 4, frames.data()), 2);
+  EXPECT_EQ(frames[2], 99);
+  EXPECT_EQ(frames[3], -99);
+}
+
+TEST_F(AudioSourceTest, StreamingRead) {
+  hpaslt::StreamingAudioSource audioSource(m_filePath.string());
+  EXPECT_EQ(audioSource.getNumChannels(), 2);
+  EXPECT_EQ(audioSource.getSampleRate(), 44100);
+  EXPECT_EQ(audioSource.getNumSamplesPerChannel(), m_sampleNum);
+  EXPECT_EQ(audioSource.getChannelData(0), nullptr);
+
+  // Cross the block boundaries.
+  int offset = AUDIO_SOURCE_BLOCK_FRAMES - 10;
+  int count = AUDIO_SOURCE_BLOCK_FRAMES + 20;
+  std::vector<float> samples(count);
+  EXPECT_EQ(audioSource.read(1, offset, count, samples.data()), count);
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQ(samples[i], testSample(offset + i, 1) / 32768.f);
+  }
+
+  // The last partial block.
+  std::vector<float> frames(2 * 200);
+  offset = m_sampleNum - 100;
+  EXPECT_EQ(audioSource.readInterleaved(offset, 200, frames.data()), 100);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(frames[2 * i], testSample(offset + i, 0) / 32768.f);
+    ASSERT_EQ(frames[2 * i + 1], testSample(offset + i, 1) / 32768.f);
+  }
+}
+
+TEST_F(AudioSourceTest, StreamingSequentialRead) {
+  hpaslt::StreamingAudioSource audioSource(m_filePath.string());
+
+  // Small sequential reads like the player, served by the read ahead.
+  std::vector<float> frames(2 * 1000);
+  bool equal = true;
+  for (int offset = 0; offset < m_sampleNum; offset += 1000) {
+    int count = audioSource.readInterleaved(offset, 1000, frames.data());
+    for (int i = 0; i < count; i++) {
+      equal &= frames[2 * i] == testSample(offset + i, 0) / 32768.f;
+      equal &= frames[2 * i + 1] == testSample(offset + i, 1) / 32768.f;
+    }
+  }
+  EXPECT_TRUE(equal);
+}
+
+TEST_F(AudioSourceTest, ProgressiveRead) {
+  auto streamingSource =
+      std::make_shared<hpaslt::StreamingAudioSource>(m_filePath.string());
+  hpaslt::ProgressiveAudioSource audioSource(streamingSource);
+  EXPECT_EQ(audioSource.getNumChannels(), 2);
+  EXPECT_EQ(audioSource.getNumSamplesPerChannel(), m_sampleNum);
+  EXPECT_EQ(audioSource.getLoadedSamples(), 0);
+
+  // The loaded prefix grows one block at a time.
+  EXPECT_TRUE(audioSource.loadNextBlock());
+  EXPECT_EQ(audioSource.getLoadedSamples(), AUDIO_SOURCE_BLOCK_FRAMES);
+
+  // Reads are clamped to the loaded prefix.
+  std::vector<float> samples(200);
+  int offset = AUDIO_SOURCE_BLOCK_FRAMES - 100;
+  EXPECT_EQ(audioSource.read(0, offset, 200, samples.data()), 100);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(samples[i], testSample(offset + i, 0) / 32768.f);
+  }
+
+  audioSource.loadAll();
+  EXPECT_FALSE(audioSource.loadNextBlock());
+  EXPECT_EQ(audioSource.getLoadedSamples(), m_sampleNum);
+
+  // The loaded samples can be viewed without a copy.
+  const float *channelData = audioSource.getChannelData(1);
+  ASSERT_NE(channelData, nullptr);
+  EXPECT_EQ(channelData[m_sampleNum - 1],
+            testSample(m_sampleNum - 1, 1) / 32768.f);
+
+  // Cross the block boundary after the load.
+  std::vector<float> frames(2 * 200);
+  EXPECT_EQ(audioSource.readInterleaved(offset, 200, frames.data()), 200);
+  for (int i = 0; i < 200; i++) {
+    ASSERT_EQ(frames[2 * i], testSample(offset + i, 0) / 32768.f);
+    ASSERT_EQ(frames[2 * i + 1], testSample(offset + i, 1) / 32768.f);
+  }
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -9,12 +9,26 @@
 #include <limits>
 
 #include "core/signal_generator/signal_generator.h"
+#include "core/audio_source/memory_audio_source.h"
 #include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/fft_plan_cache/fft_plan_cache.h"
 
 namespace hpaslt {
 
 namespace test {
 
+/**
+ * @brief A MemoryAudioSource that hides its samples, so the spectrogram reads
+ * them in chunks like it does from a streaming source.
+ *
+ */
+class ChunkedAudioSource : public hpaslt::MemoryAudioSource {
+ public:
+  using hpaslt::MemoryAudioSource::MemoryAudioSource;
+
+  const float* getChannelData(int channel) override { return nullptr; }
+};
+
 class AudioSpectrogramTest : public ::testing::Test {
  protected:
   /**
@@ -192,6 +206,482 @@ TEST_F(AudioSpectrogramTest, GenerateSpectrogramPeakFreq) {
   }
 }
 
+TEST_F(AudioSpectrogramTest, GenerateRealSpectrogram) {
+  // Change the length of the audio.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+
+  const std::vector<float> freqs{512, 1024, 2048};
+
+  // Generate signal.
+  m_signalGenerator->generateSignal(freqs[0], (float)1 / (float)freqs.size());
+
+  // Overlay 2 layers of new signal.
+  for (int i = 1; i < freqs.size(); i++) {
+    m_signalGenerator->overlaySignal(freqs[i], (float)1 / (float)freqs.size());
+  }
+
+  // Generate the complex spectrogram as reference.
+  hpaslt::AudioSpectrogram complexSpectrogram;
+  complexSpectrogram.generateSpectrogram(m_audioFile, NFFT);
+  EXPECT_EQ(complexSpectrogram.getBinNum(), NFFT);
+
+  // Generate the real spectrogram.
+  m_audioSpectrogram->generateSpectrogram(
+      m_audioFile, NFFT, hpaslt::SpectrogramMode::RealToComplex);
+  EXPECT_EQ(m_audioSpectrogram->getBinNum(), NFFT / 2 + 1);
+  EXPECT_EQ(m_audioSpectrogram->getSpectrogramLength(),
+            complexSpectrogram.getSpectrogramLength());
+
+  auto& rawSpectrogram = m_audioSpectrogram->getRawSpectrogram();
+  auto& complexRawSpectrogram = complexSpectrogram.getRawSpectrogram();
+  ASSERT_EQ(rawSpectrogram.size(), complexRawSpectrogram.size());
+  for (int ch = 0; ch < rawSpectrogram.size(); ch++) {
+    EXPECT_EQ(rawSpectrogram[ch]->getSpectrogramSize(),
+              (NFFT / 2 + 1) * m_audioSpectrogram->getSpectrogramLength());
+    // The real spectrogram should match the lower half of the complex one.
+    for (int frame = 0; frame < m_audioSpectrogram->getSpectrogramLength();
+         frame++) {
+      fftwf_complex* real =
+          rawSpectrogram[ch]->getRawSpectrogram() + frame * (NFFT / 2 + 1);
+      fftwf_complex* complex =
+          complexRawSpectrogram[ch]->getRawSpectrogram() + frame * NFFT;
+      for (int i = 0; i < NFFT / 2 + 1; i++) {
+        ASSERT_NEAR(real[i][0], complex[i][0], 1e-3);
+        ASSERT_NEAR(real[i][1], complex[i][1], 1e-3);
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTFrameNum) {
+  // Change the length of the audio.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(1024, 1);
+  int sampleNum = m_audioFile->getNumSamplesPerChannel();
+
+  hpaslt::STFTConfig config;
+  config.nfft = NFFT;
+  config.hopSize = NFFT / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+
+  // Drop the partial frame.
+  config.padding = hpaslt::PaddingMode::Drop;
+  m_audioSpectrogram->generateSTFT(m_audioFile, config);
+  EXPECT_EQ(m_audioSpectrogram->getHopSize(), NFFT / 4);
+  EXPECT_EQ(m_audioSpectrogram->getSpectrogramLength(),
+            (sampleNum - NFFT) / (NFFT / 4) + 1);
+  EXPECT_FLOAT_EQ(m_audioSpectrogram->getSpectrogramSampleRate(),
+                  (float)m_audioFile->getSampleRate() / (NFFT / 4));
+
+  // Pad the partial frame.
+  config.padding = hpaslt::PaddingMode::Zero;
+  m_audioSpectrogram->generateSTFT(m_audioFile, config);
+  int paddedLength = m_audioSpectrogram->getSpectrogramLength();
+  EXPECT_GE((paddedLength - 1) * (NFFT / 4) + NFFT, sampleNum);
+  EXPECT_LT((paddedLength - 2) * (NFFT / 4) + NFFT, sampleNum);
+
+  config.padding = hpaslt::PaddingMode::Reflect;
+  m_audioSpectrogram->generateSTFT(m_audioFile, config);
+  EXPECT_EQ(m_audioSpectrogram->getSpectrogramLength(), paddedLength);
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTPeakFreq) {
+  // Change the length of the audio.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+
+  const std::vector<float> freqs{512, 1024, 2048};
+
+  // Generate signal.
+  m_signalGenerator->generateSignal(freqs[0], (float)1 / (float)freqs.size());
+
+  // Overlay 2 layers of new signal.
+  for (int i = 1; i < freqs.size(); i++) {
+    m_signalGenerator->overlaySignal(freqs[i], (float)1 / (float)freqs.size());
+  }
+
+  const std::vector<hpaslt::WindowFunction> windows{
+      hpaslt::WindowFunction::Hann, hpaslt::WindowFunction::Hamming,
+      hpaslt::WindowFunction::BlackmanHarris, hpaslt::WindowFunction::Kaiser};
+
+  for (auto window : windows) {
+    hpaslt::STFTConfig config;
+    config.nfft = NFFT;
+    config.hopSize = NFFT / 4;
+    config.window = window;
+    m_audioSpectrogram->generateSTFT(m_audioFile, config);
+
+    auto& rawSpectrogram = m_audioSpectrogram->getRawSpectrogram();
+    int binNum = m_audioSpectrogram->getBinNum();
+    for (int ch = 0; ch < rawSpectrogram.size(); ch++) {
+      // Get the middle frame.
+      fftwf_complex* frame =
+          rawSpectrogram[ch]->getRawSpectrogram() +
+          (m_audioSpectrogram->getSpectrogramLength() / 2) * binNum;
+      // Find the local maximums.
+      std::vector<std::pair<float, int>> freqMag;
+      for (int i = 1; i < binNum - 1; i++) {
+        float prev = sqrt(pow(frame[i - 1][0], 2) + pow(frame[i - 1][1], 2));
+        float mag = sqrt(pow(frame[i][0], 2) + pow(frame[i][1], 2));
+        float next = sqrt(pow(frame[i + 1][0], 2) + pow(frame[i + 1][1], 2));
+        if (mag >= prev && mag >= next) {
+          freqMag.push_back(std::make_pair(mag, i));
+        }
+      }
+      ASSERT_GE(freqMag.size(), 3);
+      std::sort(
+          freqMag.begin(), freqMag.end(),
+          [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
+            return (a.first > b.first);
+          });
+
+      for (int i = 0; i < 3; i++) {
+        float freq = ((double)freqMag[i].second /
+                      (double)m_audioSpectrogram->getNfft()) *
+                     (double)m_audioSpectrogram->getAudioSampleRate();
+        EXPECT_TRUE(containsFreq(freqs, freq, MAX_ERR));
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTParallel) {
+  // Change the length of the audio.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(512, 0.5);
+  m_signalGenerator->overlaySignal(2048, 0.5);
+
+  const std::vector<hpaslt::SpectrogramMode> modes{
+      hpaslt::SpectrogramMode::Complex, hpaslt::SpectrogramMode::RealToComplex};
+
+  for (auto mode : modes) {
+    hpaslt::STFTConfig config;
+    config.nfft = NFFT;
+    config.hopSize = NFFT / 4;
+    config.window = hpaslt::WindowFunction::Hann;
+    config.padding = hpaslt::PaddingMode::Zero;
+    config.mode = mode;
+
+    // Single thread reference.
+    config.threadNum = 1;
+    hpaslt::AudioSpectrogram serialSpectrogram;
+    serialSpectrogram.generateSTFT(m_audioFile, config);
+
+    // All threads.
+    config.threadNum = 0;
+    m_audioSpectrogram->generateSTFT(m_audioFile, config);
+
+    auto& rawSpectrogram = m_audioSpectrogram->getRawSpectrogram();
+    auto& serialRawSpectrogram = serialSpectrogram.getRawSpectrogram();
+    ASSERT_EQ(rawSpectrogram.size(), serialRawSpectrogram.size());
+    for (int ch = 0; ch < rawSpectrogram.size(); ch++) {
+      int size = rawSpectrogram[ch]->getSpectrogramSize();
+      ASSERT_EQ(size, serialRawSpectrogram[ch]->getSpectrogramSize());
+      fftwf_complex* parallel = rawSpectrogram[ch]->getRawSpectrogram();
+      fftwf_complex* serial = serialRawSpectrogram[ch]->getRawSpectrogram();
+      for (int i = 0; i < size; i++) {
+        ASSERT_FLOAT_EQ(parallel[i][0], serial[i][0]);
+        ASSERT_FLOAT_EQ(parallel[i][1], serial[i][1]);
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTBatched) {
+  // Change the length of the audio.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(512, 0.5);
+  m_signalGenerator->overlaySignal(2048, 0.5);
+
+  const std::vector<hpaslt::WindowFunction> windows{
+      hpaslt::WindowFunction::Rectangular, hpaslt::WindowFunction::Hann};
+
+  for (auto window : windows) {
+    hpaslt::STFTConfig config;
+    config.nfft = NFFT;
+    config.hopSize = NFFT / 4;
+    config.window = window;
+    config.padding = hpaslt::PaddingMode::Reflect;
+
+    // Per frame reference.
+    config.execution = hpaslt::SpectrogramExecution::PerFrame;
+    hpaslt::AudioSpectrogram perFrameSpectrogram;
+    perFrameSpectrogram.generateSTFT(m_audioFile, config);
+
+    // Batched frames.
+    config.execution = hpaslt::SpectrogramExecution::Batched;
+    m_audioSpectrogram->generateSTFT(m_audioFile, config);
+
+    auto& rawSpectrogram = m_audioSpectrogram->getRawSpectrogram();
+    auto& perFrameRawSpectrogram = perFrameSpectrogram.getRawSpectrogram();
+    ASSERT_EQ(rawSpectrogram.size(), perFrameRawSpectrogram.size());
+    for (int ch = 0; ch < rawSpectrogram.size(); ch++) {
+      int size = rawSpectrogram[ch]->getSpectrogramSize();
+      ASSERT_EQ(size, perFrameRawSpectrogram[ch]->getSpectrogramSize());
+      fftwf_complex* batched = rawSpectrogram[ch]->getRawSpectrogram();
+      fftwf_complex* perFrame = perFrameRawSpectrogram[ch]->getRawSpectrogram();
+      for (int i = 0; i < size; i++) {
+        ASSERT_NEAR(batched[i][0], perFrame[i][0], 1e-3);
+        ASSERT_NEAR(batched[i][1], perFrame[i][1], 1e-3);
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, PreparePlans) {
+  std::shared_ptr<hpaslt::FFTPlanCache> planCache =
+      hpaslt::FFTPlanCache::getSingleton().lock();
+  const std::vector<hpaslt::WindowFunction> windows{
+      hpaslt::WindowFunction::Rectangular, hpaslt::WindowFunction::Hann};
+
+  for (auto window : windows) {
+    hpaslt::STFTConfig config;
+    config.nfft = NFFT;
+    // An odd hop starts the chunks at every alignment.
+    config.hopSize = NFFT / 2 + 1;
+    config.window = window;
+    config.execution = hpaslt::SpectrogramExecution::Batched;
+    hpaslt::AudioSpectrogram::preparePlans(config);
+    int planNum = planCache->size();
+
+    // Whole chunks of frames only execute prepared plans.
+    int chunkFrameNum = hpaslt::AudioSpectrogram::getChunkFrameNum(config);
+    m_signalGenerator->changeLength(chunkFrameNum * 5 * config.hopSize +
+                                    config.nfft);
+    m_signalGenerator->generateSignal(512, 0.5);
+    m_audioSpectrogram->generateSTFT(
+        std::make_shared<hpaslt::MemoryAudioSource>(m_audioFile), config, 1,
+        chunkFrameNum * 4);
+    EXPECT_EQ(planCache->size(), planNum);
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTChunkedSource) {
+  // A partial frame at the end to exercise the padding.
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                      TEST_AUDIO_LENGTH +
+                                  NFFT / 3);
+  m_signalGenerator->generateSignal(512, 0.5);
+  m_signalGenerator->overlaySignal(2048, 0.5);
+  auto chunkedSource = std::make_shared<ChunkedAudioSource>(m_audioFile);
+
+  const std::vector<hpaslt::SpectrogramMode> modes{
+      hpaslt::SpectrogramMode::Complex, hpaslt::SpectrogramMode::RealToComplex};
+  const std::vector<hpaslt::SpectrogramExecution> executions{
+      hpaslt::SpectrogramExecution::PerFrame,
+      hpaslt::SpectrogramExecution::Batched};
+
+  for (auto mode : modes) {
+    for (auto execution : executions) {
+      hpaslt::STFTConfig config;
+      config.nfft = NFFT;
+      config.hopSize = NFFT / 4;
+      config.window = hpaslt::WindowFunction::Hann;
+      config.padding = hpaslt::PaddingMode::Reflect;
+      config.mode = mode;
+      config.execution = execution;
+
+      // Resident samples reference.
+      hpaslt::AudioSpectrogram residentSpectrogram;
+      residentSpectrogram.generateSTFT(m_audioFile, config);
+
+      m_audioSpectrogram->generateSTFT(chunkedSource, config);
+
+      auto& rawSpectrogram = m_audioSpectrogram->getRawSpectrogram();
+      auto& residentRawSpectrogram = residentSpectrogram.getRawSpectrogram();
+      ASSERT_EQ(rawSpectrogram.size(), residentRawSpectrogram.size());
+      for (int ch = 0; ch < rawSpectrogram.size(); ch++) {
+        int size = rawSpectrogram[ch]->getSpectrogramSize();
+        ASSERT_EQ(size, residentRawSpectrogram[ch]->getSpectrogramSize());
+        fftwf_complex* chunked = rawSpectrogram[ch]->getRawSpectrogram();
+        fftwf_complex* resident = residentRawSpectrogram[ch]->getRawSpectrogram();
+        for (int i = 0; i < size; i++) {
+          ASSERT_NEAR(chunked[i][0], resident[i][0], 1e-3);
+          ASSERT_NEAR(chunked[i][1], resident[i][1], 1e-3);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateSTFTFormats) {
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(512, 0.5);
+  m_signalGenerator->overlaySignal(2048, 0.01);
+
+  hpaslt::STFTConfig config;
+  config.nfft = NFFT;
+  config.hopSize = NFFT / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.minDecibels = -80;
+  config.maxDecibels = 0;
+
+  // Complex reference.
+  hpaslt::AudioSpectrogram complexSpectrogram;
+  complexSpectrogram.generateSTFT(m_audioFile, config);
+  auto& rawSpectrogram = complexSpectrogram.getRawSpectrogram();
+  float windowSum = 0;
+  for (float coefficient : complexSpectrogram.getWindow()) {
+    windowSum += coefficient;
+  }
+  float decibelStep = (config.maxDecibels - config.minDecibels) / 255;
+
+  const std::vector<hpaslt::SpectrogramFormat> formats{
+      hpaslt::SpectrogramFormat::Magnitude32,
+      hpaslt::SpectrogramFormat::Magnitude16,
+      hpaslt::SpectrogramFormat::Decibel8};
+  const std::vector<hpaslt::SpectrogramExecution> executions{
+      hpaslt::SpectrogramExecution::PerFrame,
+      hpaslt::SpectrogramExecution::Batched};
+
+  for (auto format : formats) {
+    for (auto execution : executions) {
+      config.format = format;
+      config.execution = execution;
+      m_audioSpectrogram->generateSTFT(m_audioFile, config);
+      EXPECT_TRUE(m_audioSpectrogram->getRawSpectrogram().empty());
+      EXPECT_EQ(m_audioSpectrogram->getSpectrogramBytes() *
+                    sizeof(fftwf_complex),
+                complexSpectrogram.getSpectrogramBytes() *
+                    hpaslt::getSpectrogramFormatBytes(format));
+
+      auto& compactSpectrogram = m_audioSpectrogram->getCompactSpectrogram();
+      ASSERT_EQ(compactSpectrogram.size(), rawSpectrogram.size());
+      for (int ch = 0; ch < compactSpectrogram.size(); ch++) {
+        int size = compactSpectrogram[ch]->getSpectrogramSize();
+        ASSERT_EQ(size, rawSpectrogram[ch]->getSpectrogramSize());
+        fftwf_complex* bins = rawSpectrogram[ch]->getRawSpectrogram();
+        for (int i = 0; i < size; i++) {
+          float magnitude =
+              std::sqrt(bins[i][0] * bins[i][0] + bins[i][1] * bins[i][1]);
+          if (format == hpaslt::SpectrogramFormat::Magnitude32) {
+            ASSERT_NEAR(compactSpectrogram[ch]->getMagnitudes()[i], magnitude,
+                        1e-5 * std::max(1.f, magnitude));
+          } else if (format == hpaslt::SpectrogramFormat::Magnitude16) {
+            // Half floats keep 11 significant bits.
+            ASSERT_NEAR(hpaslt::halfToFloat(
+                            compactSpectrogram[ch]->getHalfMagnitudes()[i]),
+                        magnitude, magnitude / 1024 + 1e-7);
+          } else {
+            float decibels = 20 * std::log10(magnitude * 2 / windowSum);
+            decibels = std::clamp(decibels, config.minDecibels,
+                                  config.maxDecibels);
+            ASSERT_NEAR(hpaslt::dequantizeDecibels(
+                            compactSpectrogram[ch]->getDecibels()[i],
+                            config.minDecibels, config.maxDecibels),
+                        decibels, decibelStep / 2 + 0.05f);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateISTFTRoundTrip) {
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(440, 0.5);
+  m_signalGenerator->overlaySignal(3000, 0.25);
+  m_signalGenerator->overlaySignal(12000, 0.1);
+  int sampleNum = m_audioFile->getNumSamplesPerChannel();
+
+  struct RoundTrip {
+    hpaslt::WindowFunction window;
+    int hopSize;
+    hpaslt::PaddingMode padding;
+    hpaslt::SpectrogramMode mode;
+  };
+  const std::vector<RoundTrip> roundTrips{
+      {hpaslt::WindowFunction::Rectangular, NFFT, hpaslt::PaddingMode::Drop,
+       hpaslt::SpectrogramMode::RealToComplex},
+      {hpaslt::WindowFunction::Hann, NFFT / 4, hpaslt::PaddingMode::Zero,
+       hpaslt::SpectrogramMode::RealToComplex},
+      {hpaslt::WindowFunction::Hamming, NFFT / 2, hpaslt::PaddingMode::Reflect,
+       hpaslt::SpectrogramMode::RealToComplex},
+      {hpaslt::WindowFunction::Hann, NFFT / 4, hpaslt::PaddingMode::Zero,
+       hpaslt::SpectrogramMode::Complex}};
+
+  for (const RoundTrip& roundTrip : roundTrips) {
+    hpaslt::STFTConfig config;
+    config.nfft = NFFT;
+    config.hopSize = roundTrip.hopSize;
+    config.window = roundTrip.window;
+    config.padding = roundTrip.padding;
+    config.mode = roundTrip.mode;
+    m_audioSpectrogram->generateSTFT(m_audioFile, config);
+    std::shared_ptr<AudioFile<float>> audioFile =
+        m_audioSpectrogram->generateISTFT();
+
+    ASSERT_EQ(audioFile->getNumChannels(), m_audioFile->getNumChannels());
+    ASSERT_EQ(audioFile->getSampleRate(), m_audioFile->getSampleRate());
+    // Drop leaves the samples past the last whole frame out.
+    int expectedNum = (m_audioSpectrogram->getSpectrogramLength() - 1) *
+                          config.hopSize +
+                      NFFT;
+    ASSERT_EQ(audioFile->getNumSamplesPerChannel(),
+              std::min(expectedNum, sampleNum));
+
+    // The edges of a tapered window are covered by almost no window.
+    int first = config.window == hpaslt::WindowFunction::Rectangular ? 0 : NFFT;
+    int last = audioFile->getNumSamplesPerChannel() - first;
+    for (int ch = 0; ch < audioFile->getNumChannels(); ch++) {
+      for (int i = first; i < last; i++) {
+        ASSERT_NEAR(audioFile->samples[ch][i], m_audioFile->samples[ch][i],
+                    1e-4);
+      }
+    }
+  }
+}
+
+TEST_F(AudioSpectrogramTest, GenerateISTFTRange) {
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+  m_signalGenerator->generateSignal(512, 0.5);
+  m_signalGenerator->overlaySignal(2048, 0.25);
+  std::shared_ptr<hpaslt::MemoryAudioSource> audioSource =
+      std::make_shared<hpaslt::MemoryAudioSource>(m_audioFile);
+
+  hpaslt::STFTConfig config;
+  config.nfft = NFFT;
+  config.hopSize = NFFT / 4;
+  config.window = hpaslt::WindowFunction::Hann;
+  config.threadNum = 1;
+  m_audioSpectrogram->generateSTFT(audioSource, config);
+  std::shared_ptr<AudioFile<float>> serial =
+      m_audioSpectrogram->generateISTFT();
+
+  // The seams are merged in the same order by any number of threads.
+  config.threadNum = 0;
+  m_audioSpectrogram->generateSTFT(audioSource, config);
+  std::shared_ptr<AudioFile<float>> parallel =
+      m_audioSpectrogram->generateISTFT();
+  for (int ch = 0; ch < serial->getNumChannels(); ch++) {
+    ASSERT_EQ(serial->samples[ch], parallel->samples[ch]);
+  }
+
+  // A slice resynthesizes the samples under its frames.
+  m_audioSpectrogram->generateSTFT(audioSource, config, 100, 200);
+  std::shared_ptr<AudioFile<float>> slice = m_audioSpectrogram->generateISTFT();
+  ASSERT_EQ(slice->getNumSamplesPerChannel(), 199 * config.hopSize + NFFT);
+  int offset = 100 * config.hopSize;
+  for (int ch = 0; ch < slice->getNumChannels(); ch++) {
+    for (int i = NFFT; i < slice->getNumSamplesPerChannel() - NFFT; i++) {
+      ASSERT_NEAR(slice->samples[ch][i], m_audioFile->samples[ch][offset + i],
+                  1e-4);
+    }
+  }
+
+  // Only complex bins can be inverted.
+  config.format = hpaslt::SpectrogramFormat::Magnitude32;
+  m_audioSpectrogram->generateSTFT(audioSource, config);
+  EXPECT_THROW(m_audioSpectrogram->generateISTFT(), std::invalid_argument);
+}
+
 }  // namespace test
 
 }  // namespace hpaslt
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <fftw3.h>
+#include <math.h>
+
+#include "core/fft_plan_cache/fft_plan_cache.h"
+
+namespace hpaslt {
+
+namespace test {
+
+class FFTPlanCacheTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief The plan cache used by all tests.
+   *
+   */
+  std::shared_ptr<hpaslt::FFTPlanCache> m_planCache;
+
+  FFTPlanCacheTest() {}
+  ~FFTPlanCacheTest() override {}
+
+  void SetUp() override {
+    m_planCache = std::make_shared<hpaslt::FFTPlanCache>();
+  }
+
+  virtual void TearDown() override { m_planCache = nullptr; }
+};
+
+#define NFFT 256
+
+TEST_F(FFTPlanCacheTest, ReusePlan) {
+  fftwf_complex* in = fftwf_alloc_complex(NFFT * 2);
+  fftwf_complex* out = fftwf_alloc_complex(NFFT * 2);
+
+  fftwf_plan first =
+      m_planCache->getComplexPlan(NFFT, FFTW_FORWARD, in, out, FFTW_ESTIMATE);
+  fftwf_plan second = m_planCache->getComplexPlan(
+      NFFT, FFTW_FORWARD, in + NFFT, out + NFFT, FFTW_ESTIMATE);
+
+  // Same size and alignment should reuse the plan.
+  EXPECT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(m_planCache->size(), 1);
+
+  // Different direction, size or layout should create new plans.
+  m_planCache->getComplexPlan(NFFT, FFTW_BACKWARD, in, out, FFTW_ESTIMATE);
+  m_planCache->getComplexPlan(NFFT * 2, FFTW_FORWARD, in, out, FFTW_ESTIMATE);
+  m_planCache->getComplexPlan(NFFT, FFTW_FORWARD, in, in, FFTW_ESTIMATE);
+  m_planCache->getRealToComplexPlan(NFFT, (float*)in, out, FFTW_ESTIMATE);
+  EXPECT_EQ(m_planCache->size(), 5);
+
+  m_planCache->clear();
+  EXPECT_EQ(m_planCache->size(), 0);
+
+  fftwf_free(in);
+  fftwf_free(out);
+}
+
+TEST_F(FFTPlanCacheTest, ExecuteCachedPlan) {
+  fftwf_complex* in = fftwf_alloc_complex(NFFT);
+  fftwf_complex* out = fftwf_alloc_complex(NFFT);
+
+  // Plan before filling the input, FFTW_MEASURE overwrites the arrays.
+  fftwf_plan plan =
+      m_planCache->getComplexPlan(NFFT, FFTW_FORWARD, in, out, FFTW_MEASURE);
+
+  // A pure tone at bin 8.
+  for (int i = 0; i < NFFT; i++) {
+    in[i][0] = cos(2 * M_PI * 8 * i / NFFT);
+    in[i][1] = 0;
+  }
+  fftwf_execute_dft(plan, in, out);
+
+  for (int i = 0; i < NFFT; i++) {
+    float mag = sqrt(out[i][0] * out[i][0] + out[i][1] * out[i][1]);
+    if (i == 8 || i == NFFT - 8) {
+      EXPECT_NEAR(mag, NFFT / 2, 1e-2);
+    } else {
+      EXPECT_NEAR(mag, 0, 1e-2);
+    }
+  }
+
+  fftwf_free(in);
+  fftwf_free(out);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "core/job_scheduler/job_scheduler.h"
+#include "logger/logger.h"
+
+namespace hpaslt {
+
+namespace test {
+
+TEST(JobSchedulerTest, Priority) {
+  hpaslt::JobScheduler scheduler(1);
+
+  // Hold the only worker until all the jobs are queued.
+  std::promise<void> gate;
+  std::shared_future<void> gateFuture = gate.get_future().share();
+  auto blocker = scheduler.submit(
+      [gateFuture](const CancellationToken &) { gateFuture.wait(); });
+
+  std::mutex orderMutex;
+  std::vector<int> order;
+  auto record = [&](int id) {
+    return [&, id](const CancellationToken &) {
+      std::lock_guard<std::mutex> lock(orderMutex);
+      order.push_back(id);
+    };
+  };
+  std::vector<std::shared_ptr<JobHandle>> handles{
+      scheduler.submit(record(0), JobPriority::Low),
+      scheduler.submit(record(1), JobPriority::Normal),
+      scheduler.submit(record(2), JobPriority::High),
+      scheduler.submit(record(3), JobPriority::High)};
+
+  gate.set_value();
+  for (auto &handle : handles) {
+    handle->wait();
+  }
+
+  std::vector<int> expected{2, 3, 1, 0};
+  EXPECT_EQ(order, expected);
+}
+
+TEST(JobSchedulerTest, Cancel) {
+  hpaslt::JobScheduler scheduler(1);
+
+  std::atomic<bool> started = false;
+  auto running = scheduler.submit([&](const CancellationToken &token) {
+    started = true;
+    while (!token.isCancelled()) {
+      std::this_thread::yield();
+    }
+  });
+  // Share the token of the running job.
+  std::atomic<bool> pendingRan = false;
+  auto pending = scheduler.submit(
+      [&](const CancellationToken &) { pendingRan = true; },
+      JobPriority::Normal, running->getToken());
+
+  while (!started) {
+    std::this_thread::yield();
+  }
+  running->cancel();
+  running->wait();
+  pending->wait();
+
+  EXPECT_EQ(running->getStatus(), JobStatus::Cancelled);
+  EXPECT_EQ(pending->getStatus(), JobStatus::Cancelled);
+  EXPECT_FALSE(pendingRan);
+}
+
+TEST(JobSchedulerTest, ChainedToken) {
+  // A chained token is cancelled with its parent, not the other way around.
+  auto parent = std::make_shared<CancellationToken>();
+  auto first = std::make_shared<CancellationToken>(parent);
+  auto second = std::make_shared<CancellationToken>(parent);
+  first->cancel();
+  EXPECT_TRUE(first->isCancelled());
+  EXPECT_FALSE(parent->isCancelled());
+  EXPECT_FALSE(second->isCancelled());
+
+  parent->cancel();
+  EXPECT_TRUE(second->isCancelled());
+}
+
+TEST(JobSchedulerTest, Completion) {
+  // Failed jobs are logged, keep the log out of the way.
+  if (!hpaslt::logger) {
+    hpaslt::initLogger(
+        (std::filesystem::temp_directory_path() / "hpaslt_test").string());
+    hpaslt::logger->setLogLevel(spdlog::level::off);
+  }
+
+  hpaslt::JobScheduler scheduler(2);
+
+  std::thread::id drainThread = std::this_thread::get_id();
+  std::thread::id completionThread;
+  auto finished = scheduler.submit(
+      [](const CancellationToken &) {}, JobPriority::Normal, nullptr,
+      [&]() { completionThread = std::this_thread::get_id(); });
+  auto failed = scheduler.submit(
+      [](const CancellationToken &) { throw std::invalid_argument("Failed."); },
+      JobPriority::Normal, nullptr, []() { FAIL(); });
+  // Exceptions of any type fail the job without ending the worker.
+  auto failedUnknown = scheduler.submit(
+      [](const CancellationToken &) { throw 1; }, JobPriority::Normal, nullptr,
+      []() { FAIL(); });
+  finished->wait();
+  failed->wait();
+  failedUnknown->wait();
+  EXPECT_EQ(failed->getStatus(), JobStatus::Failed);
+  EXPECT_EQ(failedUnknown->getStatus(), JobStatus::Failed);
+
+  // Stale completions of a cancelled group are dropped.
+  auto token = std::make_shared<CancellationToken>();
+  scheduler.postCompletion(token, []() { FAIL(); });
+  token->cancel();
+
+  EXPECT_EQ(scheduler.drainCompletions(), 1);
+  EXPECT_EQ(completionThread, drainThread);
+  EXPECT_EQ(scheduler.drainCompletions(), 0);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
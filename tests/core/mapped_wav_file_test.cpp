@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "core/mapped_wav_file/mapped_wav_file.h"
+#include "wav_test_utils.h"
+
+namespace hpaslt {
+
+namespace test {
+
+class MappedWavFileTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief The temporary WAV file written by each test.
+   *
+   */
+  std::filesystem::path m_filePath;
+
+  void SetUp() override {
+    m_filePath = std::filesystem::temp_directory_path() /
+                 ("hpaslt_mapped_wav_" +
+                  std::string(::testing::UnitTest::GetInstance()
+                                  ->current_test_info()
+                                  ->name()) +
+                  ".wav");
+  }
+
+  void TearDown() override { std::filesystem::remove(m_filePath); }
+};
+
+TEST_F(MappedWavFileTest, ParseHeader) {
+  std::vector<uint8_t> data(4 * 100);
+  writeWav(m_filePath, 1, 2, 48000, 16, data, true);
+
+  hpaslt::MappedWavFile wavFile(m_filePath.string());
+  EXPECT_EQ(wavFile.getNumChannels(), 2);
+  EXPECT_EQ(wavFile.getSampleRate(), 48000);
+  EXPECT_EQ(wavFile.getBitDepth(), 16);
+  EXPECT_EQ(wavFile.getSampleFormat(), hpaslt::WavSampleFormat::Int);
+  EXPECT_EQ(wavFile.getNumSamplesPerChannel(), 100);
+}
+
+TEST_F(MappedWavFileTest, ReadInt16) {
+  std::vector<uint8_t> data;
+  for (int16_t value : {0, 16384, -32768, 32767}) {
+    appendLittleEndian(data, (uint16_t)value, 2);
+  }
+  writeWav(m_filePath, 1, 2, 48000, 16, data, true);
+
+  hpaslt::MappedWavFile wavFile(m_filePath.string());
+  std::vector<float> right(2);
+  EXPECT_EQ(wavFile.readSamples(1, 0, 2, right.data()), 2);
+  EXPECT_FLOAT_EQ(right[0], 0.5f);
+  EXPECT_FLOAT_EQ(right[1], 32767.f / 32768.f);
+
+  std::vector<float> frames(4);
+  EXPECT_EQ(wavFile.readFrames(0, 4, frames.data()), 2);
+  std::vector<float> expected{0, 0.5f, -1, 32767.f / 32768.f};
+  EXPECT_EQ(frames, expected);
+}
+
+TEST_F(MappedWavFileTest, ReadInt24) {
+  std::vector<uint8_t> data;
+  for (int32_t value : {4194304, -4194304, -1}) {
+    appendLittleEndian(data, (uint32_t)value, 3);
+  }
+  writeWav(m_filePath, 1, 1, 48000, 24, data, true);
+
+  hpaslt::MappedWavFile wavFile(m_filePath.string());
+  std::vector<float> samples(3);
+  EXPECT_EQ(wavFile.readSamples(0, 0, 3, samples.data()), 3);
+  EXPECT_FLOAT_EQ(samples[0], 0.5f);
+  EXPECT_FLOAT_EQ(samples[1], -0.5f);
+  EXPECT_FLOAT_EQ(samples[2], -1.f / 8388608.f);
+}
+
+TEST_F(MappedWavFileTest, ReadFloat32) {
+  std::vector<float> values{0.25f, -0.75f, 1.f};
+  std::vector<uint8_t> data(values.size() * sizeof(float));
+  std::memcpy(data.data(), values.data(), data.size());
+  writeWav(m_filePath, 3, 1, 48000, 32, data, true);
+
+  hpaslt::MappedWavFile wavFile(m_filePath.string());
+  EXPECT_EQ(wavFile.getSampleFormat(), hpaslt::WavSampleFormat::Float);
+  std::vector<float> samples(3);
+  // Reading from an offset is clamped to the end.
+  EXPECT_EQ(wavFile.readSamples(0, 1, 10, samples.data()), 2);
+  EXPECT_FLOAT_EQ(samples[0], -0.75f);
+  EXPECT_FLOAT_EQ(samples[1], 1.f);
+}
+
+TEST_F(MappedWavFileTest, InvalidFile) {
+  {
+    std::ofstream fs(m_filePath, std::ios::binary);
+    fs << "not a wav file";
+  }
+  EXPECT_THROW(hpaslt::MappedWavFile wavFile(m_filePath.string()),
+               std::invalid_argument);
+  EXPECT_THROW(hpaslt::MappedWavFile wavFile(m_filePath.string() + ".missing"),
+               std::invalid_argument);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "core/mel_filterbank/mel_filterbank.h"
+
+namespace hpaslt {
+
+namespace test {
+
+TEST(MelFilterbankTest, MelScale) {
+  EXPECT_NEAR(MelFilterbank::hzToMel(700), 2595 * std::log10(2.f), 1e-3f);
+  for (float freq : {0.f, 100.f, 1000.f, 8000.f, 20000.f}) {
+    EXPECT_NEAR(MelFilterbank::melToHz(MelFilterbank::hzToMel(freq)), freq,
+                freq * 1e-5f + 1e-3f);
+  }
+}
+
+TEST(MelFilterbankTest, Triangles) {
+  int sampleRate = 16000;
+  int nfft = 512;
+  FilterbankConfig config;
+  config.bandNum = 26;
+  MelFilterbank filterbank(sampleRate, nfft, config);
+  ASSERT_EQ(filterbank.getBinNum(), nfft / 2 + 1);
+  ASSERT_EQ(filterbank.getBandNum(), 26);
+
+  // Centers are increasing and evenly spaced in mel.
+  float melStep = MelFilterbank::hzToMel(8000) / 27;
+  for (int band = 0; band < 26; band++) {
+    EXPECT_NEAR(MelFilterbank::hzToMel(filterbank.getCenterFrequency(band)),
+                melStep * (band + 1), 1e-2f);
+  }
+
+  // A single bin only reaches the bands around it, at most at weight 1, and
+  // neighbouring triangles sum to 1 between the first and last center.
+  float binFreq = (float)sampleRate / nfft;
+  std::vector<float> power(filterbank.getBinNum());
+  std::vector<float> bands(26);
+  for (int bin = 0; bin < filterbank.getBinNum(); bin++) {
+    std::fill(power.begin(), power.end(), 0.f);
+    power[bin] = 1;
+    filterbank.apply(power.data(), bands.data());
+    float sum = 0;
+    for (int band = 0; band < 26; band++) {
+      EXPECT_GE(bands[band], 0.f);
+      EXPECT_LE(bands[band], 1.f);
+      sum += bands[band];
+    }
+    float freq = bin * binFreq;
+    if (freq >= filterbank.getCenterFrequency(0) &&
+        freq <= filterbank.getCenterFrequency(25)) {
+      EXPECT_NEAR(sum, 1.f, 1e-4f) << "bin " << bin;
+    }
+  }
+}
+
+TEST(MelFilterbankTest, LogScale) {
+  FilterbankConfig config;
+  config.scale = FilterbankScale::Log;
+  config.bandNum = 24;
+  config.minFreq = 110;
+  config.maxFreq = 110 * std::exp2(25.f / 12);
+  MelFilterbank filterbank(44100, 16384, config);
+
+  // One band per semitone.
+  for (int band = 0; band < 24; band++) {
+    EXPECT_NEAR(filterbank.getCenterFrequency(band),
+                110 * std::exp2((band + 1) / 12.f),
+                filterbank.getCenterFrequency(band) * 1e-4f);
+  }
+}
+
+TEST(MelFilterbankTest, InvalidConfig) {
+  FilterbankConfig config;
+  config.maxFreq = 30000;
+  EXPECT_THROW(MelFilterbank(44100, 1024, config), std::invalid_argument);
+
+  config = FilterbankConfig();
+  config.scale = FilterbankScale::Log;
+  EXPECT_THROW(MelFilterbank(44100, 1024, config), std::invalid_argument);
+
+  config = FilterbankConfig();
+  config.bandNum = 0;
+  EXPECT_THROW(MelFilterbank(44100, 1024, config), std::invalid_argument);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
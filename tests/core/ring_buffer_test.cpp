@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "core/ring_buffer/ring_buffer.h"
+
+namespace hpaslt {
+
+namespace test {
+
+TEST(SPSCRingBufferTest, Capacity) {
+  hpaslt::SPSCRingBuffer<float> ringBuffer(1000);
+  EXPECT_EQ(ringBuffer.capacity(), 1024);
+  EXPECT_EQ(ringBuffer.readAvailable(), 0);
+  EXPECT_EQ(ringBuffer.writeAvailable(), 1024);
+}
+
+TEST(SPSCRingBufferTest, WrapAround) {
+  hpaslt::SPSCRingBuffer<float> ringBuffer(8);
+  std::vector<float> src{0, 1, 2, 3, 4, 5};
+  std::vector<float> dst(6);
+
+  // Move the indices close to the end.
+  EXPECT_EQ(ringBuffer.write(src.data(), 6), 6);
+  EXPECT_EQ(ringBuffer.read(dst.data(), 6), 6);
+
+  // This write wraps around the storage.
+  EXPECT_EQ(ringBuffer.write(src.data(), 6), 6);
+  EXPECT_EQ(ringBuffer.readAvailable(), 6);
+  // Only 2 elements fit.
+  EXPECT_EQ(ringBuffer.write(src.data(), 6), 2);
+  EXPECT_EQ(ringBuffer.writeAvailable(), 0);
+
+  std::vector<float> result(8);
+  EXPECT_EQ(ringBuffer.read(result.data(), 8), 8);
+  std::vector<float> expected{0, 1, 2, 3, 4, 5, 0, 1};
+  EXPECT_EQ(result, expected);
+}
+
+TEST(SPSCRingBufferTest, Discard) {
+  hpaslt::SPSCRingBuffer<float> ringBuffer(8);
+  std::vector<float> src{0, 1, 2, 3};
+
+  ringBuffer.write(src.data(), 4);
+  ringBuffer.discard();
+  EXPECT_EQ(ringBuffer.readAvailable(), 0);
+  EXPECT_EQ(ringBuffer.writeAvailable(), 8);
+}
+
+TEST(SPSCRingBufferTest, ProducerConsumer) {
+  const int count = 1 << 20;
+  hpaslt::SPSCRingBuffer<int> ringBuffer(256);
+
+  std::thread producer([&]() {
+    int next = 0;
+    std::vector<int> chunk(100);
+    while (next < count) {
+      int num = std::min(count - next, (int)chunk.size());
+      for (int i = 0; i < num; i++) {
+        chunk[i] = next + i;
+      }
+      int written = ringBuffer.write(chunk.data(), num);
+      if (written == 0) {
+        std::this_thread::yield();
+      }
+      next += written;
+    }
+  });
+
+  // Every element should arrive once and in order.
+  int expected = 0;
+  std::vector<int> chunk(64);
+  bool ordered = true;
+  while (expected < count) {
+    int num = ringBuffer.read(chunk.data(), chunk.size());
+    if (num == 0) {
+      std::this_thread::yield();
+    }
+    for (int i = 0; i < num; i++) {
+      ordered &= chunk[i] == expected++;
+    }
+  }
+  producer.join();
+
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(ringBuffer.readAvailable(), 0);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
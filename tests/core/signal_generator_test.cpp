@@ -6,6 +6,9 @@
 #include <math.h>
 #include <AudioFile.h>
 
+#include <cmath>
+#include <vector>
+
 #include "core/signal_generator/signal_generator.h"
 
 namespace hpaslt {
@@ -15,6 +18,7 @@ namespace test {
 struct FreqComponent {
   float freq;
   float magnitude;
+  float phase = 0;
 };
 
 class SignalGeneratorTest : public ::testing::Test {
@@ -63,8 +67,9 @@ class SignalGeneratorTest : public ::testing::Test {
       // Merge all the frequency together.
       float expectVal = 0;
       for (int j = 0; j < freq.size(); j++) {
-        expectVal +=
-            sin(2 * M_PI * i * freq[j].freq / sampleRate) * freq[j].magnitude;
+        expectVal += sin(2 * M_PI * i * freq[j].freq / sampleRate +
+                         freq[j].phase) *
+                     freq[j].magnitude;
       }
 
       for (int channel = 0; channel < m_audioFile->getNumChannels();
@@ -114,7 +119,7 @@ TEST_F(SignalGeneratorTest, GenerateSignal) {
 
   // Test signal.
   std::vector<FreqComponent> freq{{32, 1}};
-  EXPECT_TRUE(isFrequency(freq));
+  EXPECT_TRUE(isFrequency(freq, 1e-6f));
 }
 
 TEST_F(SignalGeneratorTest, OverlaySignal) {
@@ -137,7 +142,86 @@ TEST_F(SignalGeneratorTest, OverlaySignal) {
   std::vector<FreqComponent> freq{{32, (float)1 / (float)3},
                                   {64, (float)1 / (float)3},
                                   {128, (float)1 / (float)3}};
-  EXPECT_TRUE(isFrequency(freq));
+  EXPECT_TRUE(isFrequency(freq, 1e-6f));
+}
+
+TEST_F(SignalGeneratorTest, LongSignal) {
+  // Blocks an hour into a signal stay as accurate as the first samples.
+  int sampleRate = 44100;
+  int sampleNum = 10000;
+  std::vector<float> samples(sampleNum);
+  for (float freq : {32.f, 440.f, 12345.67f, 22049.f}) {
+    for (int64_t firstSample : {(int64_t)0, (int64_t)3600 * sampleRate,
+                                (int64_t)24 * 3600 * sampleRate + 17}) {
+      hpaslt::SignalGenerator::synthesizePartials(
+          samples.data(), firstSample, sampleNum, {{freq, 0.5f}}, sampleRate,
+          false);
+      for (int i = 0; i < sampleNum; i++) {
+        // The phase in cycles, exact in long double.
+        long double cycles =
+            std::fmod((long double)(firstSample + i) * freq, sampleRate) /
+            sampleRate;
+        float expectVal = 0.5 * std::sin(2 * M_PI * cycles);
+        ASSERT_NEAR(samples[i], expectVal, 1e-6f)
+            << freq << " Hz, sample " << firstSample + i;
+      }
+
+      // Overlay adds the same signal.
+      hpaslt::SignalGenerator::synthesizePartials(
+          samples.data(), firstSample, sampleNum, {{freq, 0.5f}}, sampleRate,
+          true);
+      for (int i = 0; i < sampleNum; i++) {
+        long double cycles =
+            std::fmod((long double)(firstSample + i) * freq, sampleRate) /
+            sampleRate;
+        ASSERT_NEAR(samples[i], std::sin(2 * M_PI * cycles), 2e-6f);
+      }
+    }
+  }
+}
+
+TEST_F(SignalGeneratorTest, GeneratePartials) {
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+
+  // 50 harmonics with shifted phases in one pass.
+  std::vector<SignalPartial> partials;
+  std::vector<FreqComponent> freq;
+  for (int i = 1; i <= 50; i++) {
+    partials.push_back({55.f * i, 0.5f / i, 0.1f * i});
+    freq.push_back({55.f * i, 0.5f / i, 0.1f * i});
+  }
+  m_signalGenerator->generatePartials(partials);
+  EXPECT_TRUE(isFrequency(freq, 1e-5f));
+
+  // The channels are copies of the first one.
+  EXPECT_EQ(m_audioFile->samples[0], m_audioFile->samples[1]);
+
+  // No partials is silence.
+  m_signalGenerator->generatePartials({});
+  EXPECT_TRUE(isFrequency({}));
+}
+
+TEST_F(SignalGeneratorTest, OverlayPartials) {
+  m_signalGenerator->changeLength(m_audioFile->getSampleRate() *
+                                  TEST_AUDIO_LENGTH);
+
+  // Channels with different signals keep them under the overlay.
+  m_signalGenerator->generateSignal(32, 0.25f);
+  for (float &sample : m_audioFile->samples[1]) {
+    sample = -sample;
+  }
+  m_signalGenerator->overlayPartials({{64, 0.25f}, {128, 0.25f, 1}});
+
+  // Check the channels one by one.
+  std::vector<float> secondChannel = m_audioFile->samples[1];
+  m_audioFile->setNumChannels(1);
+  std::vector<FreqComponent> freq{{32, 0.25f}, {64, 0.25f}, {128, 0.25f, 1}};
+  EXPECT_TRUE(isFrequency(freq, 1e-6f));
+  m_audioFile->samples[0] = secondChannel;
+  std::vector<FreqComponent> invertedFreq{
+      {32, -0.25f}, {64, 0.25f}, {128, 0.25f, 1}};
+  EXPECT_TRUE(isFrequency(invertedFreq, 1e-6f));
 }
 
 }  // namespace test
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/signal_generator/signal_generator.h"
+#include "core/spectrogram_pyramid/spectrogram_pyramid.h"
+
+namespace hpaslt {
+
+namespace test {
+
+class SpectrogramPyramidTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<AudioFile<float>> m_audioFile;
+  hpaslt::AudioSpectrogram m_spectrogram;
+
+  void SetUp() override {
+    // A tone with a single click.
+    m_audioFile = std::make_shared<AudioFile<float>>();
+    m_audioFile->setNumChannels(1);
+    hpaslt::SignalGenerator signalGenerator;
+    signalGenerator.bindAudioFile(m_audioFile);
+    signalGenerator.changeLength(m_audioFile->getSampleRate() * 2);
+    signalGenerator.generateSignal(440, 0.25f);
+    m_audioFile->samples[0][50000] = 1;
+
+    hpaslt::STFTConfig config;
+    config.nfft = 256;
+    config.hopSize = 128;
+    config.window = WindowFunction::Hann;
+    m_spectrogram.generateSTFT(m_audioFile, config);
+  }
+
+  /**
+   * @brief The magnitude of a bin of the spectrogram.
+   *
+   * @param frame
+   * @param bin
+   * @return float
+   */
+  float magnitude(int frame, int bin) {
+    fftwf_complex& value =
+        m_spectrogram.getRawSpectrogram()[0]->getRawSpectrogram()
+            [(size_t)frame * m_spectrogram.getBinNum() + bin];
+    return std::sqrt(value[0] * value[0] + value[1] * value[1]);
+  }
+};
+
+TEST_F(SpectrogramPyramidTest, MatchBruteForce) {
+  int frameNum = m_spectrogram.getSpectrogramLength();
+  int binNum = m_spectrogram.getBinNum();
+
+  for (SpectrogramPooling pooling :
+       {SpectrogramPooling::Max, SpectrogramPooling::Mean}) {
+    hpaslt::SpectrogramPyramid pyramid(m_spectrogram, 0, 16, pooling);
+    EXPECT_LE(pyramid.getLevel(pyramid.getNumLevels() - 1).frameNum, 16);
+
+    // Max pooling is exact at every level. Mean pooling averages the means of
+    // uneven odd tails, so only the finer levels match exactly.
+    int levelNum = pooling == SpectrogramPooling::Max
+                       ? pyramid.getNumLevels()
+                       : 4;
+    for (int l = 0; l < levelNum; l++) {
+      const SpectrogramLevel& level = pyramid.getLevel(l);
+      for (int i = 0; i < level.frameNum; i++) {
+        int first = i * level.frameSize;
+        int last = std::min(first + level.frameSize, frameNum);
+        for (int bin = 0; bin < binNum; bin += 7) {
+          float expected = 0;
+          for (int frame = first; frame < last; frame++) {
+            expected = pooling == SpectrogramPooling::Max
+                           ? std::max(expected, magnitude(frame, bin))
+                           : expected + magnitude(frame, bin);
+          }
+          if (pooling == SpectrogramPooling::Mean) {
+            expected /= last - first;
+          }
+          ASSERT_NEAR(level.magnitudes[(size_t)i * binNum + bin], expected,
+                      1e-4f * std::max(1.f, expected));
+        }
+      }
+    }
+  }
+}
+
+TEST_F(SpectrogramPyramidTest, Slice) {
+  int frameNum = m_spectrogram.getSpectrogramLength();
+  int binNum = m_spectrogram.getBinNum();
+  hpaslt::SpectrogramPyramid pyramid(m_spectrogram, 0, 16);
+
+  // The click stays visible when the whole file is squeezed into 32 columns.
+  int columnNum = 32;
+  std::vector<float> slice((size_t)columnNum * binNum);
+  pyramid.getSlice(0, frameNum, columnNum, slice.data());
+  int clickFrame = 50000 / m_spectrogram.getHopSize();
+  int clickColumn = (int)((int64_t)clickFrame * columnNum / frameNum);
+  int highBin = binNum - 2;
+  float clickMagnitude = slice[(size_t)clickColumn * binNum + highBin];
+  EXPECT_GE(clickMagnitude, magnitude(clickFrame, highBin));
+  for (int column = 0; column < columnNum; column++) {
+    if (std::abs(column - clickColumn) > 1) {
+      EXPECT_LT(slice[(size_t)column * binNum + highBin], clickMagnitude);
+    }
+  }
+
+  // Zoomed in past the frames, columns repeat the frames.
+  slice.resize((size_t)4 * binNum);
+  pyramid.getSlice(10, 12, 4, slice.data());
+  EXPECT_FLOAT_EQ(slice[0 * binNum + 3], magnitude(10, 3));
+  EXPECT_FLOAT_EQ(slice[1 * binNum + 3], magnitude(10, 3));
+  EXPECT_FLOAT_EQ(slice[2 * binNum + 3], magnitude(11, 3));
+
+  EXPECT_THROW(pyramid.getSlice(0, frameNum + 1, 4, slice.data()),
+               std::invalid_argument);
+}
+
+TEST_F(SpectrogramPyramidTest, MagnitudeFormat) {
+  hpaslt::SpectrogramPyramid complexPyramid(m_spectrogram, 0, 16);
+
+  hpaslt::STFTConfig config = m_spectrogram.getConfig();
+  config.format = SpectrogramFormat::Magnitude32;
+  hpaslt::AudioSpectrogram magnitudeSpectrogram;
+  magnitudeSpectrogram.generateSTFT(m_audioFile, config);
+  hpaslt::SpectrogramPyramid pyramid(magnitudeSpectrogram, 0, 16);
+
+  ASSERT_EQ(pyramid.getNumLevels(), complexPyramid.getNumLevels());
+  const std::vector<float>& magnitudes = pyramid.getLevel(2).magnitudes;
+  const std::vector<float>& expected = complexPyramid.getLevel(2).magnitudes;
+  ASSERT_EQ(magnitudes.size(), expected.size());
+  for (size_t i = 0; i < magnitudes.size(); i++) {
+    ASSERT_NEAR(magnitudes[i], expected[i], 1e-4f * std::max(1.f, expected[i]));
+  }
+
+  config.format = SpectrogramFormat::Decibel8;
+  magnitudeSpectrogram.generateSTFT(m_audioFile, config);
+  EXPECT_THROW(hpaslt::SpectrogramPyramid(magnitudeSpectrogram, 0, 16),
+               std::invalid_argument);
+}
+
+TEST_F(SpectrogramPyramidTest, FindLevel) {
+  int frameNum = m_spectrogram.getSpectrogramLength();
+  hpaslt::SpectrogramPyramid pyramid(m_spectrogram, 0, 1);
+  EXPECT_EQ(pyramid.getLevel(pyramid.getNumLevels() - 1).frameNum, 1);
+
+  EXPECT_EQ(pyramid.findLevel(100, 100), 0);
+  EXPECT_EQ(pyramid.findLevel(400, 100), 2);
+  EXPECT_EQ(pyramid.findLevel(frameNum, frameNum / 8), 3);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+#include "core/audio_source/memory_audio_source.h"
+#include "core/audio_spectrogram/audio_spectrogram.h"
+#include "core/signal_generator/signal_generator.h"
+#include "core/spectrogram_tile_cache/spectrogram_tile_cache.h"
+#include "logger/logger.h"
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief A memory source whose first transforms on a job thread fail.
+ *
+ */
+class FailingAudioSource : public MemoryAudioSource {
+ private:
+  std::thread::id m_ownerThread;
+  std::atomic<int> m_failureNum;
+
+ public:
+  FailingAudioSource(std::shared_ptr<AudioFile<float>> audioFile,
+                     int failureNum)
+      : MemoryAudioSource(audioFile),
+        m_ownerThread(std::this_thread::get_id()),
+        m_failureNum(failureNum) {}
+
+  virtual int getNumChannels() override {
+    if (std::this_thread::get_id() != m_ownerThread &&
+        m_failureNum.fetch_sub(1) > 0) {
+      throw std::runtime_error("Source failed.");
+    }
+    return MemoryAudioSource::getNumChannels();
+  }
+};
+
+class SpectrogramTileCacheTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<AudioFile<float>> m_audioFile;
+  std::shared_ptr<hpaslt::MemoryAudioSource> m_audioSource;
+  std::shared_ptr<hpaslt::JobScheduler> m_jobScheduler;
+  hpaslt::STFTConfig m_config;
+
+  void SetUp() override {
+    // Three seconds of two tones.
+    m_audioFile = std::make_shared<AudioFile<float>>();
+    m_audioFile->setNumChannels(2);
+    hpaslt::SignalGenerator signalGenerator;
+    signalGenerator.bindAudioFile(m_audioFile);
+    signalGenerator.changeLength(m_audioFile->getSampleRate() * 3);
+    signalGenerator.generateSignal(440, 0.5f);
+    signalGenerator.overlaySignal(3000, 0.25f);
+    m_audioSource = std::make_shared<hpaslt::MemoryAudioSource>(m_audioFile);
+
+    m_jobScheduler = std::make_shared<hpaslt::JobScheduler>(2);
+
+    m_config.nfft = 512;
+    m_config.hopSize = 256;
+    m_config.window = WindowFunction::Hann;
+  }
+
+  void TearDown() override {
+    m_jobScheduler = nullptr;
+    m_audioSource = nullptr;
+    m_audioFile = nullptr;
+  }
+
+  /**
+   * @brief Request the tile until its transform finished.
+   *
+   * @param cache
+   * @param key
+   * @return std::shared_ptr<const SpectrogramTile>
+   */
+  std::shared_ptr<const SpectrogramTile> waitTile(
+      SpectrogramTileCache &cache, const SpectrogramTileKey &key) {
+    std::shared_ptr<const SpectrogramTile> tile;
+    while (!(tile = cache.requestTile(key))) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return tile;
+  }
+};
+
+TEST_F(SpectrogramTileCacheTest, MatchSTFT) {
+  auto cache = std::make_shared<SpectrogramTileCache>(
+      m_audioSource, m_config, 64 << 20, m_jobScheduler);
+  ASSERT_GT(cache->getNumLevels(), 1);
+
+  // A frame of the second level max pools two frames of the first level.
+  ASSERT_EQ(cache->getPoolNum(1), 2);
+  ASSERT_EQ(cache->getPoolHopSize(1), m_config.hopSize);
+  hpaslt::AudioSpectrogram spectrogram;
+  spectrogram.generateSTFT(m_audioSource, m_config);
+  int poolFrameNum = spectrogram.getSpectrogramLength();
+  ASSERT_EQ((poolFrameNum + 1) / 2, cache->getNumFrames(1));
+  float windowSum = 0;
+  for (float coefficient : spectrogram.getWindow()) {
+    windowSum += coefficient;
+  }
+
+  // The last frame block is partial.
+  SpectrogramTileKey key{1, 1, 1, 0};
+  std::shared_ptr<const SpectrogramTile> tile = waitTile(*cache, key);
+  EXPECT_EQ(tile->firstFrame, SPECTROGRAM_TILE_FRAMES);
+  EXPECT_EQ(tile->frameNum,
+            cache->getNumFrames(1) - SPECTROGRAM_TILE_FRAMES);
+  EXPECT_EQ(tile->binNum, SPECTROGRAM_TILE_BINS);
+
+  fftwf_complex* bins =
+      spectrogram.getRawSpectrogram()[1]->getRawSpectrogram();
+  float maxDecibels = SPECTROGRAM_TILE_MIN_DB;
+  for (int frame = 0; frame < tile->frameNum; frame++) {
+    int first = (tile->firstFrame + frame) * 2;
+    int last = std::min(first + 2, poolFrameNum);
+    for (int bin = 0; bin < tile->binNum; bin++) {
+      float magnitude = 0;
+      for (int poolFrame = first; poolFrame < last; poolFrame++) {
+        fftwf_complex& value =
+            bins[(size_t)poolFrame * cache->getBinNum() + bin];
+        magnitude = std::max(
+            magnitude, std::sqrt(value[0] * value[0] + value[1] * value[1]));
+      }
+      float expected = 20 * std::log10(magnitude * 2 / windowSum);
+      float decibels = tile->decibels[(size_t)frame * tile->binNum +
+                                      tile->binNum - 1 - bin];
+      maxDecibels = std::max(maxDecibels, decibels);
+      // Leakage far below the tones is only compared roughly.
+      if (expected > -60) {
+        ASSERT_NEAR(decibels, expected, 0.01);
+      }
+    }
+  }
+  // The 0.5 tone is at about -6 dB.
+  EXPECT_NEAR(maxDecibels, -6, 1);
+}
+
+TEST_F(SpectrogramTileCacheTest, Budget) {
+  // The 257 bins of a frame block take a full and a one bin tile per
+  // channel, the budget holds one block.
+  size_t blockBytes = 2 * (2 * sizeof(SpectrogramTile) +
+                           SPECTROGRAM_TILE_FRAMES *
+                               (SPECTROGRAM_TILE_BINS + 1) * sizeof(float));
+  auto cache = std::make_shared<SpectrogramTileCache>(
+      m_audioSource, m_config, blockBytes, m_jobScheduler);
+
+  for (int frameBlock = 0; frameBlock < 2; frameBlock++) {
+    waitTile(*cache, {0, 0, frameBlock, 0});
+    EXPECT_LE(cache->getUsedBytes(), cache->getBudget());
+  }
+  // The least recently used block is evicted first.
+  EXPECT_EQ(cache->findTile({0, 0, 0, 0}), nullptr);
+  EXPECT_EQ(cache->findTile({1, 0, 0, 1}), nullptr);
+  EXPECT_NE(cache->findTile({0, 0, 1, 0}), nullptr);
+  EXPECT_NE(cache->findTile({1, 0, 1, 1}), nullptr);
+
+  cache->setBudget(0);
+  EXPECT_EQ(cache->getUsedBytes(), 0);
+  EXPECT_EQ(cache->findTile({1, 0, 1, 1}), nullptr);
+}
+
+TEST_F(SpectrogramTileCacheTest, Levels) {
+  auto cache = std::make_shared<SpectrogramTileCache>(
+      m_audioSource, m_config, 64 << 20, m_jobScheduler);
+  int levelNum = cache->getNumLevels();
+  EXPECT_LE(cache->getNumFrames(levelNum - 1), SPECTROGRAM_TILE_FRAMES);
+  EXPECT_GT(cache->getNumFrames(levelNum - 2), SPECTROGRAM_TILE_FRAMES);
+
+  int sampleNum = m_audioSource->getNumSamplesPerChannel();
+  EXPECT_EQ(cache->findLevel(sampleNum, sampleNum), 0);
+  EXPECT_EQ(cache->findLevel(sampleNum, 1), levelNum - 1);
+  EXPECT_EQ(cache->findLevel(sampleNum, sampleNum / cache->getHopSize(2)), 2);
+
+  // Tiles outside of the spectrogram are never queued.
+  EXPECT_EQ(cache->requestTile({0, 0, 1000, 0}), nullptr);
+  EXPECT_EQ(cache->requestTile({0, 0, 0, 2}), nullptr);
+}
+
+TEST_F(SpectrogramTileCacheTest, Transient) {
+  // A click on the first sample of a frame of the second level, where its
+  // window is zero.
+  auto audioFile = std::make_shared<AudioFile<float>>();
+  audioFile->setNumChannels(1);
+  audioFile->setNumSamplesPerChannel(m_config.nfft * 256);
+  int click = m_config.hopSize * 2 * 100;
+  audioFile->samples[0][click] = 1;
+  auto cache = std::make_shared<SpectrogramTileCache>(
+      std::make_shared<hpaslt::MemoryAudioSource>(audioFile), m_config,
+      64 << 20, m_jobScheduler);
+  ASSERT_GT(cache->getNumLevels(), 1);
+
+  // The frame before pools the frame centered on the click.
+  std::shared_ptr<const SpectrogramTile> tile = waitTile(*cache, {0, 1, 0, 0});
+  int frame = click / cache->getHopSize(1) - 1;
+  float maxDecibels = SPECTROGRAM_TILE_MIN_DB;
+  for (int bin = 0; bin < tile->binNum; bin++) {
+    maxDecibels = std::max(
+        maxDecibels, tile->decibels[(size_t)frame * tile->binNum + bin]);
+  }
+  EXPECT_GT(maxDecibels, -60);
+}
+
+TEST_F(SpectrogramTileCacheTest, FailedBlock) {
+  // Failed blocks are logged, keep the log out of the way.
+  if (!hpaslt::logger) {
+    hpaslt::initLogger(
+        (std::filesystem::temp_directory_path() / "hpaslt_test").string());
+    hpaslt::logger->setLogLevel(spdlog::level::off);
+  }
+
+  // A block whose transform failed is queued again by the next request.
+  auto source = std::make_shared<FailingAudioSource>(m_audioFile, 2);
+  auto cache = std::make_shared<SpectrogramTileCache>(source, m_config,
+                                                      64 << 20, m_jobScheduler);
+  std::shared_ptr<const SpectrogramTile> tile = waitTile(*cache, {0, 0, 0, 0});
+  EXPECT_EQ(tile->firstFrame, 0);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <AudioFile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "core/signal_generator/signal_generator.h"
+#include "core/spectrum_analyzer/spectrum_analyzer.h"
+
+namespace hpaslt {
+
+namespace test {
+
+class SpectrumAnalyzerTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<AudioFile<float>> m_audioFile;
+  // The samples of m_audioFile, interleaved like the audio callback output.
+  std::vector<float> m_interleaved;
+
+  void SetUp() override {
+    // One second of a stereo tone.
+    m_audioFile = std::make_shared<AudioFile<float>>();
+    m_audioFile->setNumChannels(2);
+    hpaslt::SignalGenerator signalGenerator;
+    signalGenerator.bindAudioFile(m_audioFile);
+    signalGenerator.changeLength(m_audioFile->getSampleRate());
+    signalGenerator.generateSignal(1000, 0.5f);
+
+    int sampleNum = m_audioFile->getNumSamplesPerChannel();
+    m_interleaved.resize((size_t)sampleNum * 2);
+    for (int i = 0; i < sampleNum; i++) {
+      m_interleaved[2 * i] = m_audioFile->samples[0][i];
+      m_interleaved[2 * i + 1] = m_audioFile->samples[1][i];
+    }
+  }
+
+  void TearDown() override { m_audioFile = nullptr; }
+
+  /**
+   * @brief Push device sized buffers until a frame newer than sequence is
+   * published.
+   *
+   * @param analyzer
+   * @param sequence
+   * @param frame
+   * @return true if a frame was published within a second.
+   */
+  bool pushUntilFrame(SpectrumAnalyzer& analyzer, uint64_t sequence,
+                      SpectrumFrame& frame) {
+    int frameNum = m_audioFile->getNumSamplesPerChannel();
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (int cursor = 0; std::chrono::steady_clock::now() < deadline;
+         cursor = (cursor + 512) % (frameNum - 512)) {
+      analyzer.push(m_interleaved.data() + (size_t)cursor * 2, 512);
+      if (analyzer.readFrame(frame) && frame.sequence > sequence) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+};
+
+TEST_F(SpectrumAnalyzerTest, PeakFrequency) {
+  SpectrumAnalyzer analyzer(2, m_audioFile->getSampleRate());
+  analyzer.setNfft(4096);
+  analyzer.setUpdateRate(200);
+
+  // Nothing is published while disabled.
+  SpectrumFrame frame;
+  analyzer.push(m_interleaved.data(), 4096);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(analyzer.readFrame(frame));
+
+  // Fill the history in one push, so the first frame is all tone.
+  analyzer.setEnabled(true);
+  analyzer.push(m_interleaved.data(), 8192);
+  ASSERT_TRUE(pushUntilFrame(analyzer, 0, frame));
+  ASSERT_EQ(frame.nfft, 4096);
+  ASSERT_EQ(frame.decibels.size(), 4096 / 2 + 1);
+  EXPECT_EQ(frame.sampleRate, m_audioFile->getSampleRate());
+
+  // The 0.5 tone is at about -6 dB.
+  auto peak = std::max_element(frame.decibels.begin(), frame.decibels.end());
+  float peakFreq = (float)(peak - frame.decibels.begin()) *
+                   m_audioFile->getSampleRate() / frame.nfft;
+  EXPECT_NEAR(peakFreq, 1000, (float)m_audioFile->getSampleRate() / 4096);
+  EXPECT_NEAR(*peak, -6, 1.5);
+
+  // New settings apply to the next frames.
+  analyzer.setNfft(1024);
+  uint64_t sequence = frame.sequence;
+  do {
+    ASSERT_TRUE(pushUntilFrame(analyzer, sequence, frame));
+    sequence = frame.sequence;
+  } while (frame.nfft != 1024);
+  EXPECT_EQ(frame.decibels.size(), 1024 / 2 + 1);
+
+  EXPECT_THROW(analyzer.setNfft(SPECTRUM_ANALYZER_MAX_NFFT * 2),
+               std::invalid_argument);
+  EXPECT_THROW(analyzer.setUpdateRate(0), std::invalid_argument);
+}
+
+TEST_F(SpectrumAnalyzerTest, ConcurrentRead) {
+  SpectrumAnalyzer analyzer(2, m_audioFile->getSampleRate());
+  analyzer.setNfft(256);
+  analyzer.setUpdateRate(10000);
+  analyzer.setEnabled(true);
+
+  // The reader keeps copying while the analysis thread publishes, every copy
+  // is a whole frame and the sequence never goes back.
+  std::atomic<bool> stop(false);
+  std::thread audioThread([&]() {
+    int frameNum = m_audioFile->getNumSamplesPerChannel();
+    for (int cursor = 0; !stop.load();
+         cursor = (cursor + 64) % (frameNum - 64)) {
+      analyzer.push(m_interleaved.data() + (size_t)cursor * 2, 64);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+
+  SpectrumFrame frame;
+  uint64_t sequence = 0;
+  int newFrames = 0;
+  bool consistent = true;
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+  while (consistent && std::chrono::steady_clock::now() < deadline) {
+    if (!analyzer.readFrame(frame)) {
+      continue;
+    }
+    consistent = frame.sequence >= sequence &&
+                 frame.decibels.size() == 256 / 2 + 1 && frame.nfft == 256;
+    newFrames += frame.sequence > sequence;
+    sequence = frame.sequence;
+  }
+  stop.store(true);
+  audioThread.join();
+  EXPECT_TRUE(consistent);
+  EXPECT_GT(newFrames, 1);
+}
+
+TEST_F(SpectrumAnalyzerTest, EnableToggle) {
+  // A disabled analyzer is destroyed without waiting on its thread.
+  { SpectrumAnalyzer idle(2, m_audioFile->getSampleRate()); }
+
+  // The analysis resumes after it was disabled.
+  SpectrumAnalyzer analyzer(2, m_audioFile->getSampleRate());
+  analyzer.setUpdateRate(200);
+  SpectrumFrame frame;
+  analyzer.setEnabled(true);
+  ASSERT_TRUE(pushUntilFrame(analyzer, 0, frame));
+  analyzer.setEnabled(false);
+  uint64_t sequence = frame.sequence;
+  analyzer.setEnabled(true);
+  EXPECT_TRUE(pushUntilFrame(analyzer, sequence, frame));
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief Append the lowest byteNum bytes of a value, little endian.
+ *
+ * @param bytes
+ * @param value
+ * @param byteNum
+ */
+inline void appendLittleEndian(std::vector<uint8_t>& bytes, uint32_t value,
+                               int byteNum) {
+  for (int i = 0; i < byteNum; i++) {
+    bytes.push_back((value >> (8 * i)) & 0xFF);
+  }
+}
+
+/**
+ * @brief Write a WAV file, the tests do not depend on an encoder.
+ *
+ * @param filePath
+ * @param formatTag 1 for integer PCM, 3 for float samples.
+ * @param channelNum
+ * @param sampleRate
+ * @param bitDepth
+ * @param data the interleaved sample bytes.
+ * @param listChunk write an odd sized LIST chunk before the data chunk, the
+ * parser has to skip it with its padding.
+ */
+inline void writeWav(const std::filesystem::path& filePath, int formatTag,
+                     int channelNum, int sampleRate, int bitDepth,
+                     const std::vector<uint8_t>& data,
+                     bool listChunk = false) {
+  std::vector<uint8_t> bytes;
+  int blockAlign = channelNum * bitDepth / 8;
+
+  bytes.insert(bytes.end(), {'R', 'I', 'F', 'F'});
+  appendLittleEndian(bytes, 0, 4);
+  bytes.insert(bytes.end(), {'W', 'A', 'V', 'E'});
+
+  bytes.insert(bytes.end(), {'f', 'm', 't', ' '});
+  appendLittleEndian(bytes, 16, 4);
+  appendLittleEndian(bytes, formatTag, 2);
+  appendLittleEndian(bytes, channelNum, 2);
+  appendLittleEndian(bytes, sampleRate, 4);
+  appendLittleEndian(bytes, sampleRate * blockAlign, 4);
+  appendLittleEndian(bytes, blockAlign, 2);
+  appendLittleEndian(bytes, bitDepth, 2);
+
+  if (listChunk) {
+    bytes.insert(bytes.end(), {'L', 'I', 'S', 'T'});
+    appendLittleEndian(bytes, 3, 4);
+    bytes.insert(bytes.end(), {'a', 'b', 'c', 0});
+  }
+
+  bytes.insert(bytes.end(), {'d', 'a', 't', 'a'});
+  appendLittleEndian(bytes, data.size(), 4);
+  bytes.insert(bytes.end(), data.begin(), data.end());
+
+  uint32_t riffSize = bytes.size() - 8;
+  std::memcpy(bytes.data() + 4, &riffSize, 4);
+
+  std::ofstream fs(filePath, std::ios::binary);
+  fs.write((const char*)bytes.data(), bytes.size());
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "core/waveform_envelope/waveform_envelope.h"
+
+namespace hpaslt {
+
+namespace test {
+
+/**
+ * @brief A deterministic test signal with isolated peaks.
+ *
+ * @param sampleNum
+ * @return std::vector<float>
+ */
+static std::vector<float> testSignal(int sampleNum) {
+  std::vector<float> samples(sampleNum);
+  for (int i = 0; i < sampleNum; i++) {
+    samples[i] = 0.5f * std::sin(0.01f * i);
+    if (i % 997 == 0) {
+      samples[i] = 1;
+    }
+  }
+  return samples;
+}
+
+TEST(WaveformEnvelopeTest, MatchBruteForce) {
+  // An odd size spanning several tiles, so every level has a single child
+  // tail.
+  int sampleNum = WAVEFORM_ENVELOPE_TILE_SAMPLES * 2 + 10001;
+  std::vector<float> samples = testSignal(sampleNum);
+
+  hpaslt::WaveformEnvelope envelope(sampleNum, 64, true);
+  envelope.extend(samples.data(), sampleNum);
+  ASSERT_GT(envelope.getNumLevels(), 0);
+  EXPECT_LE(envelope.getLevel(envelope.getNumLevels() - 1).binNum, 64);
+
+  for (int l = 0; l < envelope.getNumLevels(); l++) {
+    const EnvelopeLevel &level = envelope.getLevel(l);
+    EXPECT_EQ(level.loadedBins, level.binNum);
+    for (int i = 0; i < level.binNum; i++) {
+      int first = i * level.binSize;
+      int last = std::min(first + level.binSize, sampleNum);
+      float expectedMin = *std::min_element(&samples[first], &samples[last]);
+      float expectedMax = *std::max_element(&samples[first], &samples[last]);
+      ASSERT_EQ(level.min[i], expectedMin);
+      ASSERT_EQ(level.max[i], expectedMax);
+      ASSERT_GE(level.meanSquare[i], 0);
+      ASSERT_LE(level.meanSquare[i], expectedMax * expectedMax +
+                                         expectedMin * expectedMin);
+    }
+  }
+}
+
+TEST(WaveformEnvelopeTest, Extend) {
+  int sampleNum = WAVEFORM_ENVELOPE_TILE_SAMPLES * 3 + 3;
+  std::vector<float> samples = testSignal(sampleNum);
+
+  hpaslt::WaveformEnvelope fullEnvelope(sampleNum, 16, true);
+  fullEnvelope.extend(samples.data(), sampleNum);
+
+  // Extend in uneven steps like a progressive load.
+  hpaslt::WaveformEnvelope envelope(sampleNum, 16, true);
+  for (int loaded = 0; loaded < sampleNum; loaded += 33333) {
+    envelope.extend(samples.data(), loaded);
+  }
+  EXPECT_LT(envelope.getLevel(0).loadedBins, envelope.getLevel(0).binNum);
+  envelope.extend(samples.data(), sampleNum);
+  EXPECT_EQ(envelope.getLoadedSamples(), sampleNum);
+
+  for (int l = 0; l < envelope.getNumLevels(); l++) {
+    EXPECT_EQ(envelope.getLevel(l).min, fullEnvelope.getLevel(l).min);
+    EXPECT_EQ(envelope.getLevel(l).max, fullEnvelope.getLevel(l).max);
+    EXPECT_EQ(envelope.getLevel(l).meanSquare,
+              fullEnvelope.getLevel(l).meanSquare);
+  }
+}
+
+TEST(WaveformEnvelopeTest, ExtendWindow) {
+  int sampleNum = WAVEFORM_ENVELOPE_TILE_SAMPLES * 2 + 5;
+  std::vector<float> samples = testSignal(sampleNum);
+
+  hpaslt::WaveformEnvelope fullEnvelope(sampleNum, 16);
+  fullEnvelope.extend(samples.data(), sampleNum);
+
+  // Only pass a window of the samples, like a chunked read from disk.
+  hpaslt::WaveformEnvelope envelope(sampleNum, 16);
+  for (int loaded = 1001; loaded < sampleNum + 1001; loaded += 1001) {
+    int firstSample = envelope.getNextSample();
+    envelope.extend(samples.data() + firstSample, firstSample,
+                    std::min(loaded, sampleNum));
+  }
+  EXPECT_EQ(envelope.getNextSample(), sampleNum);
+
+  for (int l = 0; l < envelope.getNumLevels(); l++) {
+    EXPECT_EQ(envelope.getLevel(l).min, fullEnvelope.getLevel(l).min);
+    EXPECT_EQ(envelope.getLevel(l).max, fullEnvelope.getLevel(l).max);
+  }
+}
+
+TEST(WaveformEnvelopeTest, FindLevel) {
+  hpaslt::WaveformEnvelope envelope(1 << 20, 1024);
+  EXPECT_EQ(envelope.getNumLevels(), 10);
+  EXPECT_FALSE(envelope.hasRms());
+
+  // Few samples are drawn directly.
+  EXPECT_EQ(envelope.findLevel(1000, 1024), -1);
+  EXPECT_EQ(envelope.findLevel(2048, 1024), 0);
+  EXPECT_EQ(envelope.findLevel(1 << 20, 1024), 9);
+}
+
+}  // namespace test
+
+}  // namespace hpaslt
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "core/window_function/window_function.h"
+
+namespace hpaslt {
+
+namespace test {
+
+#define WINDOW_SIZE 512
+
+TEST(WindowFunctionTest, Rectangular) {
+  std::vector<float> window =
+      hpaslt::generateWindow(hpaslt::WindowFunction::Rectangular, WINDOW_SIZE);
+  ASSERT_EQ(window.size(), WINDOW_SIZE);
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    EXPECT_FLOAT_EQ(window[i], 1);
+  }
+}
+
+TEST(WindowFunctionTest, PeriodicSymmetry) {
+  const std::vector<hpaslt::WindowFunction> functions{
+      hpaslt::WindowFunction::Hann, hpaslt::WindowFunction::Hamming,
+      hpaslt::WindowFunction::BlackmanHarris, hpaslt::WindowFunction::Kaiser};
+
+  for (auto function : functions) {
+    std::vector<float> window = hpaslt::generateWindow(function, WINDOW_SIZE);
+    ASSERT_EQ(window.size(), WINDOW_SIZE);
+    // Periodic windows peak at the center and are symmetric around it.
+    EXPECT_NEAR(window[WINDOW_SIZE / 2], 1, 1e-4);
+    for (int i = 1; i < WINDOW_SIZE / 2; i++) {
+      EXPECT_NEAR(window[WINDOW_SIZE / 2 - i], window[WINDOW_SIZE / 2 + i],
+                  1e-5);
+      EXPECT_LE(window[i], 1 + 1e-5);
+      EXPECT_GE(window[i], 0);
+    }
+  }
+}
+
+TEST(WindowFunctionTest, HannOverlapAdd) {
+  std::vector<float> window =
+      hpaslt::generateWindow(hpaslt::WindowFunction::Hann, WINDOW_SIZE);
+  // Periodic Hann overlapped by 75% sums to 2.
+  int hopSize = WINDOW_SIZE / 4;
+  for (int i = 0; i < hopSize; i++) {
+    float sum = 0;
+    for (int j = i; j < WINDOW_SIZE; j += hopSize) {
+      sum += window[j];
+    }
+    EXPECT_NEAR(sum, 2, 1e-5);
+  }
+}
+
+}  // namespace test
+
+}  // namespace hpaslt